@@ -0,0 +1,95 @@
+#!/usr/bin/env python
+
+from __future__ import print_function
+
+import argparse
+import os
+import tempfile
+import time
+import torch
+import torch_xla
+import torch_xla.core.xla_model as xm
+import torch_xla.utils.serialization as xser
+
+
+def _evict_from_page_cache(path):
+  fd = os.open(path, os.O_RDONLY)
+  try:
+    os.fsync(fd)
+    os.posix_fadvise(fd, 0, 0, os.POSIX_FADV_DONTNEED)
+  finally:
+    os.close(fd)
+
+
+def _timed(fn, files, cold, test_count):
+  total = 0.0
+  for _ in range(0, test_count):
+    if cold:
+      for path in files:
+        _evict_from_page_cache(path)
+    ts = time.time()
+    fn()
+    total += time.time() - ts
+  return total / test_count
+
+
+def run_benchmark(args):
+  device = xm.xla_device()
+  numel = args.tensor_mb * 1024 * 1024 // 4
+  tensors = [
+      torch.randn(numel, device=device)
+      for _ in range(0, args.size_mb // args.tensor_mb)
+  ]
+  size = len(tensors) * numel * 4
+  with tempfile.TemporaryDirectory() as tmpdir:
+    torch_path = os.path.join(tmpdir, 'tensors.pt')
+    xm.save(tensors, torch_path)
+    stream_path = os.path.join(tmpdir, 'stream.pt')
+    xser.save_streaming(tensors, stream_path, group_bytes=args.group_mb << 20)
+    stream_files = [stream_path, stream_path + '.tensors.bin']
+
+    def torch_load():
+      cpu_tensors = torch.load(torch_path)
+      xm.send_cpu_data_to_device(cpu_tensors, device)
+
+    def stream_load():
+      xser.load_streaming(
+          stream_path, device=device, group_bytes=args.group_mb << 20)
+
+    def mmap_load():
+      xser.load_streaming(
+          stream_path,
+          device=device,
+          group_bytes=args.group_mb << 20,
+          mmap=True)
+
+    for name, fn, files in (('torch.load', torch_load, [torch_path]),
+                            ('load_streaming', stream_load, stream_files),
+                            ('load_streaming(mmap)', mmap_load, stream_files)):
+      for cold in (True, False):
+        secs = _timed(fn, files, cold, args.test_count)
+        print('{} {}: {:.3f}s ({:.2f}MB/s)'.format(
+            name, 'cold' if cold else 'warm', secs,
+            size / secs / (1024 * 1024)))
+
+
+if __name__ == '__main__':
+  arg_parser = argparse.ArgumentParser()
+  arg_parser.add_argument('--test_count', type=int, default=3)
+  arg_parser.add_argument(
+      '--size_mb',
+      type=int,
+      default=1024,
+      help='The total size of the tensors being loaded')
+  arg_parser.add_argument(
+      '--tensor_mb',
+      type=int,
+      default=16,
+      help='The size of each of the tensors being loaded')
+  arg_parser.add_argument(
+      '--group_mb',
+      type=int,
+      default=256,
+      help='The size of the tensor groups of the streaming loads')
+  args = arg_parser.parse_args()
+  run_benchmark(args)
@@ -0,0 +1,67 @@
+#!/usr/bin/env python
+
+from __future__ import print_function
+
+import argparse
+import os
+import tempfile
+import time
+import torch
+import torch_xla
+import torch_xla.utils.gcsfs as gs
+
+
+def _timed(fn, test_count):
+  ts = time.time()
+  for _ in range(0, test_count):
+    fn()
+  return (time.time() - ts) / test_count
+
+
+def run_benchmark(args):
+  path = args.file
+  tmpfile = None
+  if path is None:
+    tmpfile = tempfile.NamedTemporaryFile()
+    chunk = os.urandom(1024 * 1024)
+    for _ in range(0, args.size_mb):
+      tmpfile.write(chunk)
+    tmpfile.flush()
+    path = tmpfile.name
+  size = gs.stat(path).size
+  print('File {} is {} bytes long'.format(path, size))
+
+  def python_read():
+    with open(path, 'rb') as fd:
+      assert len(fd.read()) == size
+
+  def bytes_read():
+    assert len(gs.read(path)) == size
+
+  tensor = torch.empty(size, dtype=torch.uint8)
+
+  def tensor_read():
+    gs.read_into(path, tensor)
+
+  for name, fn in (('python', python_read), ('tffile_read', bytes_read),
+                   ('tffile_read_into', tensor_read)):
+    secs = _timed(fn, args.test_count)
+    print('{}: {:.2f}MB/s'.format(name, size / secs / (1024 * 1024)))
+
+
+if __name__ == '__main__':
+  arg_parser = argparse.ArgumentParser()
+  arg_parser.add_argument('--test_count', type=int, default=5)
+  arg_parser.add_argument(
+      '--size_mb',
+      type=int,
+      default=1024,
+      help='The size of the temporary file created if FILE is missing')
+  arg_parser.add_argument(
+      'file',
+      type=str,
+      nargs='?',
+      metavar='FILE',
+      help='The path to the (local or GCS) file to be used for benchmark')
+  args = arg_parser.parse_args()
+  run_benchmark(args)
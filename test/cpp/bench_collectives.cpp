@@ -0,0 +1,255 @@
+#include <ATen/ATen.h>
+#include <gtest/gtest.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "bench_util.h"
+#include "cpp_test_util.h"
+#include "tensorflow/compiler/xla/client/xla_builder.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/xla_client/computation_client.h"
+#include "tensorflow/compiler/xla/xla_client/debug_macros.h"
+#include "tensorflow/compiler/xla/xla_client/sys_util.h"
+#include "torch_xla/csrc/cross_replica_reduces.h"
+#include "torch_xla/csrc/tensor_util.h"
+#include "torch_xla_test.h"
+
+namespace torch_xla {
+namespace cpp_test {
+namespace {
+
+// Sweeps the collective operations lowered by cross_replica_reduces.cpp over
+// all the local devices of the first available device type, executing them as
+// replicated computations. The sweep is skipped with less than two local
+// devices (like the default XLA CPU setup), where the collectives are no-ops.
+// The sweep can be restricted with the following environment variables:
+//   XLA_BENCH_COLLECTIVE_OPS: Comma separated list of operations.
+//   XLA_BENCH_COLLECTIVE_TYPES: Comma separated list of f32, bf16, s32.
+//   XLA_BENCH_COLLECTIVE_MIN_BYTES/XLA_BENCH_COLLECTIVE_MAX_BYTES: The range
+//     of the per-replica input sizes, which is walked in powers of 4.
+enum class CollectiveOp {
+  kAllReduce,
+  kAllGather,
+  kReduceScatter,
+  kAllToAll,
+  kCollectivePermute,
+};
+
+struct CollectiveOpInfo {
+  CollectiveOp op;
+  const char* name;
+};
+
+const CollectiveOpInfo kCollectiveOps[] = {
+    {CollectiveOp::kAllReduce, "all_reduce"},
+    {CollectiveOp::kAllGather, "all_gather"},
+    {CollectiveOp::kReduceScatter, "reduce_scatter"},
+    {CollectiveOp::kAllToAll, "all_to_all"},
+    {CollectiveOp::kCollectivePermute, "collective_permute"},
+};
+
+struct ElementTypeInfo {
+  at::ScalarType scalar_type;
+  xla::PrimitiveType type;
+  const char* name;
+};
+
+const ElementTypeInfo kElementTypes[] = {
+    {at::kFloat, xla::PrimitiveType::F32, "f32"},
+    {at::kBFloat16, xla::PrimitiveType::BF16, "bf16"},
+    {at::kInt, xla::PrimitiveType::S32, "s32"},
+};
+
+struct GroupLayout {
+  std::string name;
+  std::vector<std::vector<int64_t>> groups;
+  int64_t group_size;
+};
+
+bool IsSelected(const char* env, const std::string& name) {
+  std::string selection = xla::sys_util::GetEnvString(env, "");
+  if (selection.empty()) {
+    return true;
+  }
+  for (absl::string_view item : absl::StrSplit(selection, ',')) {
+    if (item == name) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::vector<GroupLayout> CreateGroupLayouts(int64_t num_replicas) {
+  std::vector<GroupLayout> layouts;
+  // A single group containing all the replicas.
+  GroupLayout all_group{absl::StrCat("1x", num_replicas), {{}}, num_replicas};
+  for (int64_t i = 0; i < num_replicas; ++i) {
+    all_group.groups[0].push_back(i);
+  }
+  layouts.push_back(std::move(all_group));
+  // Pairs of adjacent replicas, if there is more than one pair.
+  if (num_replicas >= 4 && num_replicas % 2 == 0) {
+    GroupLayout pair_groups{absl::StrCat(num_replicas / 2, "x2"), {}, 2};
+    for (int64_t i = 0; i < num_replicas; i += 2) {
+      pair_groups.groups.push_back({i, i + 1});
+    }
+    layouts.push_back(std::move(pair_groups));
+  }
+  return layouts;
+}
+
+std::vector<std::pair<int64_t, int64_t>> CreateRingPairs(
+    const std::vector<std::vector<int64_t>>& groups) {
+  std::vector<std::pair<int64_t, int64_t>> pairs;
+  for (auto& group : groups) {
+    for (size_t i = 0; i < group.size(); ++i) {
+      pairs.emplace_back(group[i], group[(i + 1) % group.size()]);
+    }
+  }
+  return pairs;
+}
+
+xla::XlaComputation CreateCollectiveComputation(
+    CollectiveOp op, const xla::Shape& shape, const GroupLayout& layout) {
+  xla::XlaBuilder builder("CollectiveBench");
+  xla::XlaOp x = xla::Parameter(&builder, 0, shape, "x");
+  xla::XlaOp token = xla::CreateToken(&builder);
+  xla::XlaOp result;
+  switch (op) {
+    case CollectiveOp::kAllReduce:
+      result = BuildAllReduce(AllReduceType::kSum, {x}, token, /*scale=*/1.0,
+                              layout.groups)
+                   .front();
+      break;
+    case CollectiveOp::kAllGather:
+      result = BuildAllGather(x, token, /*dim=*/0, layout.group_size,
+                              layout.groups)
+                   .result;
+      break;
+    case CollectiveOp::kReduceScatter:
+      result = BuildReduceScatter(AllReduceType::kSum, x, token, /*scale=*/1.0,
+                                  /*scatter_dim=*/0, layout.group_size,
+                                  layout.groups)
+                   .result;
+      break;
+    case CollectiveOp::kAllToAll:
+      result = BuildAllToAll(x, token, /*split_dimension=*/0,
+                             /*concat_dimension=*/0, layout.group_size,
+                             layout.groups)
+                   .result;
+      break;
+    case CollectiveOp::kCollectivePermute:
+      result =
+          BuildCollectivePermute(x, token, CreateRingPairs(layout.groups))
+              .result;
+      break;
+  }
+  return ConsumeValue(builder.Build(result));
+}
+
+void BenchCollective(const CollectiveOpInfo& op_info,
+                     const ElementTypeInfo& type_info,
+                     const GroupLayout& layout, int64_t bytes,
+                     const std::vector<std::string>& devices) {
+  int64_t element_size =
+      xla::ShapeUtil::ByteSizeOfPrimitiveType(type_info.type);
+  // Reduce-scatter and all-to-all need the input to be split evenly among the
+  // replicas of a group.
+  int64_t num_elements = std::max<int64_t>(
+      bytes / element_size / layout.group_size * layout.group_size,
+      layout.group_size);
+  xla::Shape shape = xla::ShapeUtil::MakeShape(type_info.type, {num_elements});
+  xla::XlaComputation computation =
+      CreateCollectiveComputation(op_info.op, shape, layout);
+  xla::Shape result_shape =
+      ConsumeValue(computation.GetProgramShape()).result();
+
+  std::vector<xla::ComputationClient::CompileInstance> instances;
+  instances.emplace_back(std::move(computation), devices.front(), devices,
+                         &result_shape);
+  auto compiled_computations =
+      xla::ComputationClient::Get()->Compile(std::move(instances));
+
+  std::vector<at::Tensor> tensors;
+  for (size_t i = 0; i < devices.size(); ++i) {
+    tensors.push_back(
+        at::ones({num_elements}, at::TensorOptions(type_info.scalar_type)));
+  }
+  std::vector<xla::ComputationClient::DataPtr> tensors_data =
+      CreateTensorsData(tensors, devices);
+  std::vector<std::vector<xla::ComputationClient::DataPtr>> arguments;
+  for (auto& data : tensors_data) {
+    arguments.push_back({data});
+  }
+
+  xla::ComputationClient::ExecuteReplicatedOptions options;
+  auto runfn = [&]() {
+    xla::ComputationClient::Get()->ExecuteReplicated(
+        *compiled_computations.front(), arguments, devices, options);
+  };
+  BenchStats stats = RunBenchmark(runfn);
+  ReportBenchmark(absl::StrCat(op_info.name, " ", type_info.name,
+                               " groups=", layout.name,
+                               " bytes=", num_elements * element_size),
+                  stats, num_elements * element_size);
+}
+
+std::vector<std::string> GetBenchDevices() {
+  for (auto hw_type : {TorchXLADeviceType::TPU, TorchXLADeviceType::GPU,
+                       TorchXLADeviceType::CPU}) {
+    std::vector<std::string> devices;
+    for (const auto& device_str :
+         xla::ComputationClient::Get()->GetLocalDevices()) {
+      if (Device(device_str).device_type.hw_type == hw_type) {
+        devices.push_back(device_str);
+      }
+    }
+    if (!devices.empty()) {
+      return devices;
+    }
+  }
+  return {};
+}
+
+}  // namespace
+
+class CollectiveBench : public AtenXlaTensorTestBase {};
+
+TEST_F(CollectiveBench, Sweep) {
+  std::vector<std::string> devices = GetBenchDevices();
+  ASSERT_FALSE(devices.empty());
+  if (devices.size() < 2) {
+    // With a single replica the collectives do not move any data, and the
+    // sweep would only measure the graph execution overhead.
+    GTEST_SKIP() << "Collective benchmarks need at least two replicas, found "
+                 << devices.size() << " at " << devices.front();
+  }
+  int64_t min_bytes =
+      xla::sys_util::GetEnvInt("XLA_BENCH_COLLECTIVE_MIN_BYTES", 1 << 10);
+  int64_t max_bytes =
+      xla::sys_util::GetEnvInt("XLA_BENCH_COLLECTIVE_MAX_BYTES", 1 << 30);
+  std::cout << "Collective benchmarks on " << devices.size()
+            << " replicas, starting at " << devices.front() << std::endl;
+  for (auto& op_info : kCollectiveOps) {
+    if (!IsSelected("XLA_BENCH_COLLECTIVE_OPS", op_info.name)) {
+      continue;
+    }
+    for (auto& type_info : kElementTypes) {
+      if (!IsSelected("XLA_BENCH_COLLECTIVE_TYPES", type_info.name)) {
+        continue;
+      }
+      for (auto& layout : CreateGroupLayouts(devices.size())) {
+        for (int64_t bytes = min_bytes; bytes <= max_bytes; bytes *= 4) {
+          BenchCollective(op_info, type_info, layout, bytes, devices);
+        }
+      }
+    }
+  }
+}
+
+}  // namespace cpp_test
+}  // namespace torch_xla
@@ -0,0 +1,47 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "bench_util.h"
+#include "tensorflow/compiler/xla/xla_client/metrics.h"
+
+namespace torch_xla {
+namespace cpp_test {
+namespace {
+
+constexpr int64_t kSamplesPerThread = 50000;
+
+// Has num_threads threads concurrently post kSamplesPerThread samples each to
+// the same metric, like the XLA_TIMED and XLA_VALUE_METRIC hot paths do.
+void AddSamples(xla::metrics::Metric* metric, int64_t num_threads) {
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  for (int64_t i = 0; i < num_threads; ++i) {
+    threads.emplace_back([metric]() {
+      for (int64_t j = 0; j < kSamplesPerThread; ++j) {
+        metric->AddSample(static_cast<double>(j));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+}  // namespace
+
+TEST(MetricsBench, AddSampleContention) {
+  for (int64_t num_threads : {1, 4, 16}) {
+    xla::metrics::Metric metric(
+        absl::StrCat("MetricsBenchAddSample", num_threads));
+    auto fn = [&]() { AddSamples(&metric, num_threads); };
+    ReportBenchmark(absl::StrCat("add_sample threads=", num_threads, " x",
+                                 kSamplesPerThread),
+                    RunBenchmark(fn));
+  }
+}
+
+}  // namespace cpp_test
+}  // namespace torch_xla
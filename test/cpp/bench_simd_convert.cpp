@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "bench_util.h"
+#include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/compiler/xla/xla_client/sys_util.h"
+#include "tensorflow/core/lib/bfloat16/bfloat16.h"
+#include "torch_xla/csrc/simd_convert.h"
+
+namespace torch_xla {
+namespace cpp_test {
+namespace {
+
+// The conversions the CopyData() paths of tensor_util.cpp did before being
+// routed to the SIMD kernels: a StridedCopy() with unit strides, whose
+// Caster<> is a per-element static_cast<> to the tensorflow::bfloat16 and
+// xla::half types, and an std::copy() for the integer ones.
+template <typename S, typename D, typename ST, typename DT>
+void StridedCastCopy(const S* src, D* dest, int64_t n) {
+  const ST* source = reinterpret_cast<const ST*>(src);
+  DT* dest_data = reinterpret_cast<DT*>(dest);
+  for (int64_t i = 0; i < n; ++i) {
+    dest_data[i] = static_cast<DT>(source[i]);
+  }
+}
+
+template <typename S, typename D>
+void StdCopy(const S* src, D* dest, int64_t n) {
+  std::copy(src, src + n, dest);
+}
+
+const simd::ConvertKernels kBaselineKernels = {
+    simd::Isa::kScalar,
+    StridedCastCopy<float, uint16_t, float, tensorflow::bfloat16>,
+    StridedCastCopy<uint16_t, float, tensorflow::bfloat16, float>,
+    StridedCastCopy<float, uint16_t, float, xla::half>,
+    StridedCastCopy<uint16_t, float, xla::half, float>,
+    StdCopy<int64_t, int32_t>,
+    StdCopy<int32_t, int64_t>,
+    nullptr,
+};
+
+// Reports the conversion bandwidth of each kernel, for every instruction set
+// supported by the host CPU. The number of converted elements can be set with
+// XLA_BENCH_CONVERT_ELEMENTS.
+template <typename S, typename D>
+void BenchConvert(const char* name, void (*kernel)(const S*, D*, int64_t),
+                  const char* variant, int64_t num_elements) {
+  std::vector<S> src(num_elements, S(1));
+  std::vector<D> dest(num_elements);
+  auto runfn = [&]() { kernel(src.data(), dest.data(), num_elements); };
+  BenchStats stats = RunBenchmark(runfn);
+  ReportBenchmark(
+      absl::StrCat(name, " ", variant, " elements=", num_elements), stats,
+      num_elements * (sizeof(S) + sizeof(D)));
+}
+
+void BenchKernels(const simd::ConvertKernels& kernels, const char* variant,
+                  int64_t num_elements) {
+  BenchConvert("f32_to_bf16", kernels.f32_to_bf16, variant, num_elements);
+  BenchConvert("bf16_to_f32", kernels.bf16_to_f32, variant, num_elements);
+  BenchConvert("f32_to_f16", kernels.f32_to_f16, variant, num_elements);
+  BenchConvert("f16_to_f32", kernels.f16_to_f32, variant, num_elements);
+  BenchConvert("s64_to_s32", kernels.s64_to_s32, variant, num_elements);
+  BenchConvert("s32_to_s64", kernels.s32_to_s64, variant, num_elements);
+}
+
+}  // namespace
+
+TEST(SimdConvertBench, Kernels) {
+  int64_t num_elements =
+      xla::sys_util::GetEnvInt("XLA_BENCH_CONVERT_ELEMENTS", 64 << 20);
+  BenchKernels(kBaselineKernels, "static_cast", num_elements);
+  for (auto isa :
+       {simd::Isa::kScalar, simd::Isa::kAvx2, simd::Isa::kAvx512}) {
+    const simd::ConvertKernels* kernels = simd::GetConvertKernels(isa);
+    if (kernels != nullptr) {
+      BenchKernels(*kernels, simd::IsaName(isa), num_elements);
+    }
+  }
+}
+
+}  // namespace cpp_test
+}  // namespace torch_xla
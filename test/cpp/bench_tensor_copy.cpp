@@ -0,0 +1,77 @@
+#include <ATen/ATen.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "bench_util.h"
+#include "tensorflow/compiler/xla/primitive_util.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/xla_client/sys_util.h"
+#include "torch_xla/csrc/tensor_util.h"
+#include "torch_xla_test.h"
+
+namespace torch_xla {
+namespace cpp_test {
+namespace {
+
+// Compares the tiled and the sliced (XLA_TILED_TENSOR_COPY=0) host copies
+// between tensors with different layouts. The uploads copy from the PyTorch
+// layout to the given one, and the downloads the other way around.
+struct CopyCase {
+  std::string name;
+  std::vector<int64_t> sizes;
+  std::vector<int64_t> minor_to_major;
+};
+
+void BenchLayoutCopy(const CopyCase& copy_case, xla::PrimitiveType type,
+                     bool tiled) {
+  SetTiledTensorCopy(tiled);
+  at::Tensor input = at::rand(copy_case.sizes, at::TensorOptions(at::kFloat));
+  xla::Shape shape = xla::ShapeUtil::MakeShapeWithLayout(
+      type, copy_case.sizes, copy_case.minor_to_major);
+  xla::Literal literal = GetTensorLiteral(input, &shape, /*device=*/nullptr);
+  int64_t bytes =
+      input.numel() * (sizeof(float) +
+                       xla::ShapeUtil::ByteSizeOfPrimitiveType(type));
+  std::string name = absl::StrCat(
+      copy_case.name, " [", absl::StrJoin(copy_case.sizes, ","), "] ",
+      xla::primitive_util::LowercasePrimitiveTypeName(type),
+      tiled ? " tiled" : " sliced");
+
+  auto upload_fn = [&]() {
+    GetTensorLiteral(input, &shape, /*device=*/nullptr);
+  };
+  ReportBenchmark(absl::StrCat("upload ", name), RunBenchmark(upload_fn),
+                  bytes);
+  auto download_fn = [&]() { MakeTensorFromXlaLiteral(literal, at::kFloat); };
+  ReportBenchmark(absl::StrCat("download ", name), RunBenchmark(download_fn),
+                  bytes);
+}
+
+}  // namespace
+
+using TensorCopyBench = TorchXlaTest;
+
+TEST_F(TensorCopyBench, LayoutCopies) {
+  std::vector<CopyCase> cases = {
+      {"transpose", {4096, 4096}, {0, 1}},
+      {"transpose", {1024, 65536}, {0, 1}},
+      {"nchw_to_nhwc", {64, 64, 56, 56}, {1, 3, 2, 0}},
+      {"nchw_to_nhwc", {64, 3, 224, 224}, {1, 3, 2, 0}},
+      {"nchw_to_hwcn", {64, 256, 14, 14}, {0, 1, 3, 2}},
+  };
+  for (auto& copy_case : cases) {
+    for (auto type : {xla::PrimitiveType::F32, xla::PrimitiveType::BF16}) {
+      for (bool tiled : {false, true}) {
+        BenchLayoutCopy(copy_case, type, tiled);
+      }
+    }
+  }
+  SetTiledTensorCopy(xla::sys_util::GetEnvBool("XLA_TILED_TENSOR_COPY", true));
+}
+
+}  // namespace cpp_test
+}  // namespace torch_xla
@@ -0,0 +1,72 @@
+#include <ATen/ATen.h>
+#include <gtest/gtest.h>
+
+#include "bench_util.h"
+#include "cpp_test_util.h"
+#include "torch_xla/csrc/aten_xla_bridge.h"
+#include "torch_xla_test.h"
+
+namespace torch_xla {
+namespace cpp_test {
+namespace {
+
+// The accessors take a few nanoseconds, so every timed call runs a batch of
+// them, to keep the timer overhead out of the measure.
+constexpr int64_t kBatchSize = 1000;
+
+}  // namespace
+
+class TensorImplBench : public AtenXlaTensorTestBase {};
+
+TEST_F(TensorImplBench, Sizes) {
+  ForEachDevice([&](const torch::Device& device) {
+    at::Tensor xla_tensor =
+        CopyToDevice(at::rand({8, 16, 32}, at::TensorOptions(at::kFloat)),
+                     device);
+    int64_t total = 0;
+    auto sizes_fn = [&]() {
+      for (int64_t i = 0; i < kBatchSize; ++i) {
+        total += xla_tensor.sizes()[0];
+      }
+    };
+    ReportBenchmark("sizes() x1000", RunBenchmark(sizes_fn));
+
+    auto strides_fn = [&]() {
+      for (int64_t i = 0; i < kBatchSize; ++i) {
+        total += xla_tensor.strides()[0] + xla_tensor.dim() +
+                 xla_tensor.numel();
+      }
+    };
+    ReportBenchmark("strides()+dim()+numel() x1000", RunBenchmark(strides_fn));
+
+    // Every in-place update bumps the tensor generation, without changing its
+    // shape.
+    auto update_fn = [&]() {
+      xla_tensor.add_(1.0);
+      for (int64_t i = 0; i < kBatchSize; ++i) {
+        total += xla_tensor.sizes()[0];
+      }
+    };
+    ReportBenchmark("add_() + sizes() x1000", RunBenchmark(update_fn));
+    EXPECT_GT(total, 0);
+  });
+}
+
+TEST_F(TensorImplBench, IsXlaTensor) {
+  ForEachDevice([&](const torch::Device& device) {
+    at::Tensor cpu_tensor = at::rand({4, 4}, at::TensorOptions(at::kFloat));
+    at::Tensor xla_tensor = CopyToDevice(cpu_tensor, device);
+    int64_t count = 0;
+    auto lookup_fn = [&]() {
+      for (int64_t i = 0; i < kBatchSize; ++i) {
+        count += bridge::IsXlaTensor(xla_tensor);
+        count += bridge::IsXlaTensor(cpu_tensor);
+      }
+    };
+    ReportBenchmark("IsXlaTensor() x2000", RunBenchmark(lookup_fn));
+    EXPECT_GT(count, 0);
+  });
+}
+
+}  // namespace cpp_test
+}  // namespace torch_xla
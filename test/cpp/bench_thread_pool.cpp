@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+
+#include "absl/strings/str_cat.h"
+#include "bench_util.h"
+#include "tensorflow/compiler/xla/xla_client/async_task.h"
+#include "tensorflow/compiler/xla/xla_client/multi_wait.h"
+#include "tensorflow/compiler/xla/xla_client/thread_pool.h"
+
+namespace torch_xla {
+namespace cpp_test {
+namespace {
+
+// Schedules count closures from the calling thread, and waits for all of them.
+void RunFlat(int64_t count, std::atomic<int64_t>* counter) {
+  auto mwait = std::make_shared<xla::util::MultiWait>(count);
+  for (int64_t i = 0; i < count; ++i) {
+    xla::env::ScheduleClosure(
+        xla::util::MultiWait::Completer(mwait, [counter]() { ++*counter; }));
+  }
+  mwait->Wait();
+}
+
+// Schedules fanout closures, each one of them recursively scheduling (and
+// waiting for) fanout closures, down to the given depth.
+void RunNested(int64_t fanout, int64_t depth, std::atomic<int64_t>* counter) {
+  if (depth == 0) {
+    ++*counter;
+    return;
+  }
+  auto mwait = std::make_shared<xla::util::MultiWait>(fanout);
+  for (int64_t i = 0; i < fanout; ++i) {
+    xla::env::ScheduleClosure(xla::util::MultiWait::Completer(
+        mwait, [=]() { RunNested(fanout, depth - 1, counter); }));
+  }
+  mwait->Wait();
+}
+
+}  // namespace
+
+TEST(ThreadPoolBench, ScheduleOverhead) {
+  std::atomic<int64_t> counter(0);
+  for (int64_t count : {1, 16, 256, 4096}) {
+    auto fn = [&]() { RunFlat(count, &counter); };
+    ReportBenchmark(absl::StrCat("flat x", count), RunBenchmark(fn));
+  }
+}
+
+TEST(ThreadPoolBench, NestedForkJoin) {
+  std::atomic<int64_t> counter(0);
+  for (int64_t fanout : {4, 16}) {
+    for (int64_t depth : {2, 3}) {
+      counter = 0;
+      auto fn = [&]() { RunNested(fanout, depth, &counter); };
+      ReportBenchmark(absl::StrCat("nested fanout=", fanout, " depth=", depth),
+                      RunBenchmark(fn));
+      EXPECT_GT(counter.load(), 0);
+    }
+  }
+}
+
+TEST(ThreadPoolBench, CrossPool) {
+  // CPU pool closures waiting on IO pool ones, like the transfer paths do.
+  auto fn = [&]() {
+    auto mwait = std::make_shared<xla::util::MultiWait>(64);
+    for (int64_t i = 0; i < 64; ++i) {
+      xla::env::ScheduleClosure(xla::util::MultiWait::Completer(mwait, []() {
+        xla::util::AsyncTask<int> task([]() { return 17; });
+        task.Schedule();
+        task.Wait();
+      }));
+    }
+    mwait->Wait();
+  };
+  ReportBenchmark("cross pool x64", RunBenchmark(fn));
+}
+
+}  // namespace cpp_test
+}  // namespace torch_xla
@@ -0,0 +1,259 @@
+#include <ATen/ATen.h>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "bench_util.h"
+#include "cpp_test_util.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/xla_client/sys_util.h"
+#include "torch/csrc/lazy/core/hash.h"
+#include "torch_xla/csrc/aten_xla_bridge.h"
+#include "torch_xla/csrc/ir_util.h"
+#include "torch_xla/csrc/ops/arithmetic_ir_ops.h"
+#include "torch_xla/csrc/ops/infer_output_shape.h"
+#include "torch_xla/csrc/ops/ops.h"
+#include "torch_xla/csrc/tensor.h"
+#include "torch_xla_test.h"
+
+namespace torch_xla {
+namespace cpp_test {
+namespace {
+
+// The synthetic graphs stack XLA_BENCH_TRACING_LAYERS layers, whose tensors
+// have XLA_BENCH_TRACING_DIM sized dimensions.
+struct GraphConfig {
+  GraphConfig()
+      : layers(xla::sys_util::GetEnvInt("XLA_BENCH_TRACING_LAYERS", 8)),
+        dim(xla::sys_util::GetEnvInt("XLA_BENCH_TRACING_DIM", 64)) {}
+
+  int64_t layers;
+  int64_t dim;
+};
+
+using GraphFn = std::function<std::vector<at::Tensor>(
+    const at::Tensor&, const std::vector<at::Tensor>&)>;
+
+struct SyntheticGraph {
+  std::string name;
+  GraphFn trace_fn;
+  at::Tensor input;
+  std::vector<at::Tensor> weights;
+};
+
+std::vector<at::Tensor> TraceMlp(const at::Tensor& input,
+                                 const std::vector<at::Tensor>& weights) {
+  at::Tensor x = input;
+  for (size_t i = 0; i + 1 < weights.size(); i += 2) {
+    x = at::relu(at::matmul(x, weights[i]) + weights[i + 1]);
+  }
+  return {x};
+}
+
+std::vector<at::Tensor> TraceTransformer(
+    const at::Tensor& input, const std::vector<at::Tensor>& weights) {
+  at::Tensor x = input;
+  double scale = 1.0 / std::sqrt(static_cast<double>(input.size(-1)));
+  for (size_t i = 0; i + 5 < weights.size(); i += 6) {
+    at::Tensor q = at::matmul(x, weights[i]);
+    at::Tensor k = at::matmul(x, weights[i + 1]);
+    at::Tensor v = at::matmul(x, weights[i + 2]);
+    at::Tensor scores = at::softmax(at::matmul(q, k.transpose(-2, -1)) * scale,
+                                    /*dim=*/-1);
+    at::Tensor attn = at::matmul(at::matmul(scores, v), weights[i + 3]);
+    x = at::layer_norm(x + attn, {x.size(-1)});
+    at::Tensor ff = at::matmul(at::relu(at::matmul(x, weights[i + 4])),
+                               weights[i + 5]);
+    x = at::layer_norm(x + ff, {x.size(-1)});
+  }
+  return {x};
+}
+
+// Narrows, transposes and in-place updates of slices of a base tensor, which
+// go through the view and alias update tracking of the XLA tensors.
+std::vector<at::Tensor> TraceViews(const at::Tensor& input,
+                                   const std::vector<at::Tensor>& weights) {
+  at::Tensor base = input.clone();
+  std::vector<at::Tensor> outputs;
+  int64_t rows = base.size(0);
+  for (size_t i = 0; i < weights.size(); ++i) {
+    int64_t start = i % rows;
+    at::Tensor slice = base.narrow(0, start, 1).transpose(0, 1);
+    slice.add_(weights[i].narrow(0, 0, 1).transpose(0, 1));
+    outputs.push_back(base.narrow(0, start, 1).view({-1}));
+  }
+  outputs.push_back(base);
+  return outputs;
+}
+
+std::vector<SyntheticGraph> MakeGraphs(const torch::Device& device) {
+  GraphConfig config;
+  at::TensorOptions options(at::kFloat);
+  auto make = [&](at::IntArrayRef sizes) {
+    return CopyToDevice(at::rand(sizes, options), device);
+  };
+
+  std::vector<SyntheticGraph> graphs;
+  SyntheticGraph mlp{"mlp", TraceMlp, make({config.dim, config.dim}), {}};
+  for (int64_t i = 0; i < config.layers; ++i) {
+    mlp.weights.push_back(make({config.dim, config.dim}));
+    mlp.weights.push_back(make({config.dim}));
+  }
+  graphs.push_back(std::move(mlp));
+
+  SyntheticGraph transformer{"transformer", TraceTransformer,
+                             make({2, config.dim, config.dim}), {}};
+  for (int64_t i = 0; i < config.layers * 6; ++i) {
+    transformer.weights.push_back(make({config.dim, config.dim}));
+  }
+  graphs.push_back(std::move(transformer));
+
+  SyntheticGraph views{"views", TraceViews, make({config.dim, config.dim}), {}};
+  for (int64_t i = 0; i < config.layers * 4; ++i) {
+    views.weights.push_back(make({config.dim, config.dim}));
+  }
+  graphs.push_back(std::move(views));
+  return graphs;
+}
+
+std::vector<const torch::lazy::Node*> GetRoots(
+    const std::vector<at::Tensor>& tensors, std::vector<ir::Value>* values) {
+  std::vector<const torch::lazy::Node*> roots;
+  for (auto& tensor : tensors) {
+    values->push_back(bridge::GetXlaTensor(tensor).GetIrValue());
+    roots.push_back(values->back().node.get());
+  }
+  return roots;
+}
+
+std::string GraphName(const SyntheticGraph& graph, const std::string& stage) {
+  GraphConfig config;
+  return absl::StrCat(graph.name, " L=", config.layers, " D=", config.dim, " ",
+                      stage);
+}
+
+}  // namespace
+
+class TracingBench : public AtenXlaTensorTestBase {};
+
+TEST_F(TracingBench, IrNodeCreation) {
+  GraphConfig config;
+  int64_t nodes = config.layers * 64;
+  ir::Value scalar = ir::ops::ScalarOp(1.0, xla::F32);
+  auto create_fn = [&]() {
+    ir::Value value = scalar;
+    for (int64_t i = 0; i < nodes; ++i) {
+      value = value + scalar;
+    }
+    EXPECT_TRUE(value);
+  };
+  ReportOpBenchmark(absl::StrCat("ir::ops add x", nodes),
+                    RunBenchmark(create_fn), nodes);
+}
+
+TEST_F(TracingBench, InferOutputShape) {
+  GraphConfig config;
+  xla::Shape shape =
+      xla::ShapeUtil::MakeShape(xla::F32, {config.dim, config.dim});
+  auto lower_for_shape_fn =
+      [](absl::Span<const xla::XlaOp> operands) -> xla::XlaOp {
+    return xla::Dot(operands[0], operands[1]);
+  };
+  auto infer_fn = [&]() {
+    xla::Shape result =
+        ir::ops::InferOutputShape({shape, shape}, lower_for_shape_fn);
+    EXPECT_EQ(result.rank(), 2);
+  };
+  ReportOpBenchmark("InferOutputShape(dot)", RunBenchmark(infer_fn), 1);
+}
+
+TEST_F(TracingBench, Trace) {
+  ForEachDevice([&](const torch::Device& device) {
+    for (auto& graph : MakeGraphs(device)) {
+      std::vector<ir::Value> values;
+      int64_t nodes =
+          ir::Util::ComputePostOrder(
+              GetRoots(graph.trace_fn(graph.input, graph.weights), &values))
+              .size();
+      auto trace_fn = [&]() { graph.trace_fn(graph.input, graph.weights); };
+      ReportOpBenchmark(GraphName(graph, "trace"), RunBenchmark(trace_fn),
+                        nodes);
+    }
+  });
+}
+
+TEST_F(TracingBench, GetIrValue) {
+  ForEachDevice([&](const torch::Device& device) {
+    for (auto& graph : MakeGraphs(device)) {
+      std::vector<XLATensor> tensors;
+      for (auto& output : graph.trace_fn(graph.input, graph.weights)) {
+        tensors.push_back(bridge::GetXlaTensor(output));
+      }
+      auto get_fn = [&]() {
+        for (auto& tensor : tensors) {
+          EXPECT_TRUE(tensor.GetIrValue());
+        }
+      };
+      ReportOpBenchmark(GraphName(graph, "GetIrValue"), RunBenchmark(get_fn),
+                        tensors.size());
+    }
+  });
+}
+
+TEST_F(TracingBench, PostOrderAndHash) {
+  ForEachDevice([&](const torch::Device& device) {
+    for (auto& graph : MakeGraphs(device)) {
+      std::vector<ir::Value> values;
+      std::vector<const torch::lazy::Node*> roots =
+          GetRoots(graph.trace_fn(graph.input, graph.weights), &values);
+      int64_t nodes = ir::Util::ComputePostOrder(roots).size();
+      auto post_order_fn = [&]() {
+        EXPECT_EQ(ir::Util::ComputePostOrder(roots).size(), nodes);
+      };
+      ReportOpBenchmark(GraphName(graph, "post order"),
+                        RunBenchmark(post_order_fn), nodes);
+
+      // Same as the graph hash computed by the tensors sync.
+      auto hash_fn = [&]() {
+        torch::lazy::hash_t hash = torch::lazy::MHash(false);
+        for (auto& value : values) {
+          hash = torch::lazy::HashCombine(hash, value.hash());
+        }
+        EXPECT_NE(hash, torch::lazy::hash_t(0));
+      };
+      ReportOpBenchmark(GraphName(graph, "roots hash"), RunBenchmark(hash_fn),
+                        values.size());
+    }
+  });
+}
+
+TEST_F(TracingBench, SyncCacheHit) {
+  ForEachDevice([&](const torch::Device& device) {
+    for (auto& graph : MakeGraphs(device)) {
+      std::vector<ir::Value> values;
+      int64_t nodes =
+          ir::Util::ComputePostOrder(
+              GetRoots(graph.trace_fn(graph.input, graph.weights), &values))
+              .size();
+      // Every iteration traces the same graph again, so all but the first sync
+      // (which runs within the warmup iterations) hit the computation cache.
+      auto sync_fn = [&]() {
+        std::vector<XLATensor> tensors;
+        for (auto& output : graph.trace_fn(graph.input, graph.weights)) {
+          tensors.push_back(bridge::GetXlaTensor(output));
+        }
+        XLATensor::SyncTensorsGraph(&tensors, {}, /*wait=*/true,
+                                    /*sync_xla_data=*/false);
+      };
+      ReportOpBenchmark(GraphName(graph, "trace + cached sync"),
+                        RunBenchmark(sync_fn), nodes);
+    }
+  });
+}
+
+}  // namespace cpp_test
+}  // namespace torch_xla
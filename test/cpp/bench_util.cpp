@@ -0,0 +1,128 @@
+#include "bench_util.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <vector>
+
+#include "tensorflow/compiler/xla/xla_client/sys_util.h"
+
+namespace {
+
+thread_local int64_t thread_allocations = 0;
+
+void* CountedAlloc(size_t size) {
+  ++thread_allocations;
+  void* ptr = std::malloc(size > 0 ? size : 1);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+}  // namespace
+
+// The benchmark binary replaces the global allocation functions, so that the
+// allocations issued by the benchmarked code can be counted.
+void* operator new(size_t size) { return CountedAlloc(size); }
+
+void* operator new[](size_t size) { return CountedAlloc(size); }
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr, size_t) noexcept { std::free(ptr); }
+
+namespace torch_xla {
+namespace cpp_test {
+namespace {
+
+double Percentile(const std::vector<double>& sorted_samples, double pct) {
+  size_t index = static_cast<size_t>(
+      std::ceil(pct / 100.0 * sorted_samples.size()) - 1);
+  return sorted_samples[std::min(index, sorted_samples.size() - 1)];
+}
+
+}  // namespace
+
+int64_t GetThreadAllocationCount() { return thread_allocations; }
+
+BenchOptions::BenchOptions()
+    : time_secs(xla::sys_util::GetEnvDouble("XLA_BENCH_TIME", 1.0)),
+      warmup_iters(xla::sys_util::GetEnvInt("XLA_BENCH_WARMUP_ITERS", 2)),
+      min_iters(xla::sys_util::GetEnvInt("XLA_BENCH_MIN_ITERS", 10)),
+      max_iters(xla::sys_util::GetEnvInt("XLA_BENCH_MAX_ITERS", 100000)) {}
+
+BenchStats RunBenchmark(const std::function<void()>& fn,
+                        const BenchOptions& options) {
+  for (int64_t i = 0; i < options.warmup_iters; ++i) {
+    fn();
+  }
+  std::vector<double> samples;
+  int64_t allocs = 0;
+  int64_t budget_ns = static_cast<int64_t>(options.time_secs * 1e9);
+  int64_t start = xla::sys_util::NowNs();
+  while (static_cast<int64_t>(samples.size()) < options.max_iters) {
+    int64_t now = xla::sys_util::NowNs();
+    if (static_cast<int64_t>(samples.size()) >= options.min_iters &&
+        now - start >= budget_ns) {
+      break;
+    }
+    int64_t allocs_start = GetThreadAllocationCount();
+    fn();
+    allocs += GetThreadAllocationCount() - allocs_start;
+    samples.push_back((xla::sys_util::NowNs() - now) / 1000.0);
+  }
+
+  BenchStats stats;
+  if (samples.empty()) {
+    return stats;
+  }
+  std::sort(samples.begin(), samples.end());
+  double total = 0.0;
+  for (auto sample : samples) {
+    total += sample;
+  }
+  stats.iters = samples.size();
+  stats.mean_us = total / samples.size();
+  stats.min_us = samples.front();
+  stats.p50_us = Percentile(samples, 50.0);
+  stats.p99_us = Percentile(samples, 99.0);
+  stats.max_us = samples.back();
+  stats.allocs = static_cast<double>(allocs) / samples.size();
+  return stats;
+}
+
+void ReportBenchmark(const std::string& name, const BenchStats& stats,
+                     int64_t bytes) {
+  std::cout << std::left << std::setw(48) << name << std::right << std::fixed
+            << std::setprecision(2) << " iters=" << stats.iters
+            << " mean=" << stats.mean_us << "us"
+            << " p50=" << stats.p50_us << "us"
+            << " p99=" << stats.p99_us << "us";
+  if (bytes >= 0 && stats.p50_us > 0.0) {
+    // Bytes per microsecond, to GB/s.
+    std::cout << " algbw=" << std::setprecision(3)
+              << bytes / stats.p50_us / 1000.0 << "GB/s";
+  }
+  std::cout << std::endl;
+}
+
+void ReportOpBenchmark(const std::string& name, const BenchStats& stats,
+                       int64_t ops) {
+  std::cout << std::left << std::setw(48) << name << std::right << std::fixed
+            << std::setprecision(1) << " iters=" << stats.iters
+            << " mean=" << stats.mean_us * 1000.0 / ops << "ns/op"
+            << " p50=" << stats.p50_us * 1000.0 / ops << "ns/op"
+            << std::setprecision(2) << " allocs=" << stats.allocs / ops
+            << "/op" << std::endl;
+}
+
+}  // namespace cpp_test
+}  // namespace torch_xla
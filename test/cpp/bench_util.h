@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace torch_xla {
+namespace cpp_test {
+
+// Controls how many times a benchmark function is run. The defaults can be
+// overridden with the XLA_BENCH_TIME (seconds), XLA_BENCH_WARMUP_ITERS,
+// XLA_BENCH_MIN_ITERS and XLA_BENCH_MAX_ITERS environment variables.
+struct BenchOptions {
+  BenchOptions();
+
+  double time_secs;
+  int64_t warmup_iters;
+  int64_t min_iters;
+  int64_t max_iters;
+};
+
+// Latencies are in microseconds. The allocations are the mean number of heap
+// allocations (operator new calls) issued by the calling thread per iteration.
+struct BenchStats {
+  int64_t iters = 0;
+  double mean_us = 0.0;
+  double min_us = 0.0;
+  double p50_us = 0.0;
+  double p99_us = 0.0;
+  double max_us = 0.0;
+  double allocs = 0.0;
+};
+
+// Returns the number of operator new calls issued so far by the calling thread.
+int64_t GetThreadAllocationCount();
+
+// Runs fn for the configured warmup iterations, and then times each one of the
+// following calls, until both the minimum number of iterations and the time
+// budget are reached (or the maximum number of iterations is hit).
+BenchStats RunBenchmark(const std::function<void()>& fn,
+                        const BenchOptions& options = BenchOptions());
+
+// Prints a single line benchmark report to stdout. If bytes is not negative,
+// the algorithmic bandwidth (bytes / p50 latency) is reported as well.
+void ReportBenchmark(const std::string& name, const BenchStats& stats,
+                     int64_t bytes = -1);
+
+// Prints a single line benchmark report to stdout, with the latency and the
+// allocations scaled down to a single one of the ops run by each iteration.
+void ReportOpBenchmark(const std::string& name, const BenchStats& stats,
+                       int64_t ops);
+
+}  // namespace cpp_test
+}  // namespace torch_xla
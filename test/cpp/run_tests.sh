@@ -6,6 +6,7 @@ BUILDTYPE="Release"
 VERB=
 FILTER=
 BUILD_ONLY=0
+RUN_BENCH=0
 RMBUILD=1
 LOGFILE=/tmp/pytorch_cpp_test.log
 XLA_EXPERIMENTAL="nonzero:masked_select"
@@ -14,7 +15,7 @@ if [ "$DEBUG" == "1" ]; then
   BUILDTYPE="Debug"
 fi
 
-while getopts 'VLDKBF:X:' OPTION
+while getopts 'VLDKBPF:X:' OPTION
 do
   case $OPTION in
     V)
@@ -32,6 +33,9 @@ do
     B)
       BUILD_ONLY=1
       ;;
+    P)
+      RUN_BENCH=1
+      ;;
     F)
       FILTER="--gtest_filter=$OPTARG"
       ;;
@@ -62,6 +66,9 @@ if [ $BUILD_ONLY -eq 0 ]; then
   else
     ./test_ptxla ${FILTER:+"$FILTER"}
   fi
+  if [ $RUN_BENCH -eq 1 ]; then
+    ./bench_ptxla ${FILTER:+"$FILTER"}
+  fi
 fi
 popd
 if [ $RMBUILD -eq 1 -a $BUILD_ONLY -eq 0 ]; then
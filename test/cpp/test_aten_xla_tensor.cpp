@@ -7,6 +7,7 @@
 #include "tensorflow/compiler/xla/permutation_util.h"
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/compiler/xla/xla_client/metrics.h"
+#include "torch_xla/csrc/aten_cpu_fallback.h"
 #include "torch_xla/csrc/aten_xla_bridge.h"
 #include "torch_xla/csrc/helpers.h"
 #include "torch_xla/csrc/torch_util.h"
@@ -5311,6 +5312,35 @@ TEST_F(AtenXlaTensorTest, TestIndexPutImpl) {
   }
 }
 
+TEST_F(AtenXlaTensorTest, TestCpuFallbackOptionalTensorList) {
+  // The index_put indices are a Tensor?[] argument, which the CPU fallback has
+  // to move to the CPU together with the plain tensor arguments.
+  const c10::OperatorHandle op =
+      c10::Dispatcher::singleton().findSchemaOrThrow("aten::index_put", "");
+  torch::Tensor params =
+      torch::rand({4, 3, 5}, torch::TensorOptions(torch::kFloat));
+  torch::Tensor indices =
+      torch::randint(-3, 3, {2, 4}, torch::TensorOptions(torch::kLong));
+  torch::Tensor values =
+      torch::ones({2, 4, 5}, torch::TensorOptions(torch::kFloat));
+  torch::Tensor result = torch::index_put(
+      params, c10::List<c10::optional<torch::Tensor>>({c10::nullopt, indices}),
+      values);
+  ForEachDevice([&](const torch::Device& device) {
+    torch::Tensor xla_params = CopyToDevice(params, device);
+    c10::List<c10::optional<torch::Tensor>> xla_indices(
+        {c10::nullopt, CopyToDevice(indices, device)});
+    torch::jit::Stack stack;
+    torch::jit::push(stack, xla_params, xla_indices,
+                     CopyToDevice(values, device), /*accumulate=*/false);
+    xla_cpu_fallback(op, &stack);
+    ASSERT_EQ(stack.size(), 1);
+    torch::Tensor xla_result = stack.back().toTensor();
+    EXPECT_EQ(xla_result.device(), device);
+    AllEqual(result, xla_result);
+  });
+}
+
 TEST_F(AtenXlaTensorTest, TestIndexFillWithScalar) {
   torch::Tensor index =
       torch::tensor({0, 2}, torch::TensorOptions(torch::kLong));
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "cpp_test_util.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "torch_xla/csrc/layout_manager.h"
+
+namespace torch_xla {
+namespace cpp_test {
+namespace {
+
+// Enables or disables the layout tuner for the scope of a test, which starts
+// and ends with no recorded layouts.
+class LayoutTunerScope {
+ public:
+  explicit LayoutTunerScope(bool enabled)
+      : prev_enabled_(SetLayoutTuner(enabled)) {
+    ClearTunedLayouts();
+  }
+
+  ~LayoutTunerScope() {
+    ClearTunedLayouts();
+    SetLayoutTuner(prev_enabled_);
+  }
+
+ private:
+  bool prev_enabled_;
+};
+
+std::vector<int64_t> MinorToMajor(const xla::Shape& shape) {
+  return std::vector<int64_t>(shape.layout().minor_to_major().begin(),
+                              shape.layout().minor_to_major().end());
+}
+
+xla::ProgramShape MakeProgramShape(const xla::Shape& parameter,
+                                   const xla::Shape& result) {
+  xla::ProgramShape program_shape;
+  *program_shape.add_parameters() = parameter;
+  *program_shape.mutable_result() = result;
+  return program_shape;
+}
+
+}  // namespace
+
+TEST(LayoutManagerTest, TunedLayouts) {
+  std::vector<int64_t> dimensions({7, 13, 5});
+  DeviceType device_type(TorchXLADeviceType::CPU);
+  xla::Shape default_shape =
+      MakeArrayShapeFromDimensions(dimensions, {}, xla::F32, device_type);
+  EXPECT_EQ(MinorToMajor(default_shape), std::vector<int64_t>({2, 1, 0}));
+
+  LayoutTunerScope tuner_scope(/*enabled=*/true);
+  // A parameter layout picked by the compiler, which differs from the default
+  // one, and a result one for a different type.
+  xla::Shape compiled_parameter =
+      xla::ShapeUtil::MakeShapeWithLayout(xla::F32, dimensions, {0, 2, 1});
+  xla::Shape compiled_result =
+      xla::ShapeUtil::MakeShapeWithLayout(xla::S32, dimensions, {1, 0, 2});
+  RecordCompiledLayouts(MakeProgramShape(compiled_parameter, compiled_result));
+
+  xla::Shape shape =
+      MakeArrayShapeFromDimensions(dimensions, {}, xla::F32, device_type);
+  EXPECT_EQ(MinorToMajor(shape), std::vector<int64_t>({0, 2, 1}));
+  shape = MakeArrayShapeFromDimensions(dimensions, {}, xla::S32, device_type);
+  EXPECT_EQ(MinorToMajor(shape), std::vector<int64_t>({1, 0, 2}));
+  shape = MakeArrayShapeFromDimensions(dimensions, {}, xla::F64, device_type);
+  EXPECT_EQ(MinorToMajor(shape), std::vector<int64_t>({2, 1, 0}));
+
+  // The first recorded layout sticks.
+  xla::Shape recompiled_parameter =
+      xla::ShapeUtil::MakeShapeWithLayout(xla::F32, dimensions, {1, 2, 0});
+  RecordCompiledLayouts(
+      MakeProgramShape(recompiled_parameter, recompiled_parameter));
+  shape = MakeArrayShapeFromDimensions(dimensions, {}, xla::F32, device_type);
+  EXPECT_EQ(MinorToMajor(shape), std::vector<int64_t>({0, 2, 1}));
+}
+
+TEST(LayoutManagerTest, TunerDisabled) {
+  LayoutTunerScope tuner_scope(/*enabled=*/false);
+  std::vector<int64_t> dimensions({11, 3});
+  DeviceType device_type(TorchXLADeviceType::CPU);
+  xla::Shape compiled_parameter =
+      xla::ShapeUtil::MakeShapeWithLayout(xla::F32, dimensions, {0, 1});
+  RecordCompiledLayouts(
+      MakeProgramShape(compiled_parameter, compiled_parameter));
+  xla::Shape shape =
+      MakeArrayShapeFromDimensions(dimensions, {}, xla::F32, device_type);
+  EXPECT_EQ(MinorToMajor(shape), std::vector<int64_t>({1, 0}));
+}
+
+}  // namespace cpp_test
+}  // namespace torch_xla
@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "cpp_test_util.h"
+#include "tensorflow/compiler/xla/xla_client/metrics.h"
+
+namespace torch_xla {
+namespace cpp_test {
+
+TEST(MetricsTest, SamplesTest) {
+  static const size_t kMaxSamples = 64;
+  xla::metrics::MetricData data(xla::metrics::MetricFnValue, kMaxSamples);
+  for (size_t i = 0; i < 2 * kMaxSamples; ++i) {
+    data.AddSample(i, i);
+  }
+  double accumulator = 0.0;
+  size_t total_samples = 0;
+  std::vector<xla::metrics::Sample> samples =
+      data.Samples(&accumulator, &total_samples);
+  EXPECT_EQ(total_samples, 2 * kMaxSamples);
+  EXPECT_EQ(accumulator, kMaxSamples * (2 * kMaxSamples - 1));
+  ASSERT_EQ(samples.size(), kMaxSamples);
+  for (size_t i = 0; i < samples.size(); ++i) {
+    EXPECT_EQ(samples[i].timestamp_ns, static_cast<int64_t>(kMaxSamples + i));
+  }
+}
+
+TEST(MetricsTest, ConcurrentSamplesTest) {
+  static const size_t kMaxSamples = 256;
+  static const int kNumThreads = 16;
+  static const int kSamplesPerThread = 1000;
+  xla::metrics::MetricData data(xla::metrics::MetricFnValue, kMaxSamples);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([&]() {
+      for (int j = 0; j < kSamplesPerThread; ++j) {
+        data.AddSample(j, 1.0);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  double accumulator = 0.0;
+  size_t total_samples = 0;
+  std::vector<xla::metrics::Sample> samples =
+      data.Samples(&accumulator, &total_samples);
+  EXPECT_EQ(total_samples, kNumThreads * kSamplesPerThread);
+  EXPECT_EQ(accumulator, kNumThreads * kSamplesPerThread);
+  EXPECT_EQ(data.TotalSamples(), total_samples);
+  EXPECT_EQ(data.Accumulator(), accumulator);
+  ASSERT_EQ(samples.size(), kMaxSamples);
+  for (size_t i = 1; i < samples.size(); ++i) {
+    EXPECT_LE(samples[i - 1].timestamp_ns, samples[i].timestamp_ns);
+  }
+}
+
+}  // namespace cpp_test
+}  // namespace torch_xla
@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "torch_xla/csrc/simd_convert.h"
+
+namespace torch_xla {
+namespace cpp_test {
+namespace {
+
+// Not a multiple of any vector width, so that the kernels tails get exercised.
+constexpr int64_t kNumElements = 4099;
+
+uint32_t FloatBits(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+bool IsF16NaN(uint16_t bits) {
+  return (bits & 0x7c00) == 0x7c00 && (bits & 0x03ff) != 0;
+}
+
+std::vector<float> CreateFloats() {
+  std::mt19937 generator(17);
+  std::vector<float> values(kNumElements);
+  for (auto& value : values) {
+    uint32_t bits = generator();
+    std::memcpy(&value, &bits, sizeof(value));
+  }
+  // Special values, rounding ties and values which overflow F16.
+  const float kSpecials[] = {0.0f,
+                             -0.0f,
+                             std::numeric_limits<float>::infinity(),
+                             -std::numeric_limits<float>::infinity(),
+                             std::numeric_limits<float>::quiet_NaN(),
+                             std::numeric_limits<float>::denorm_min(),
+                             std::numeric_limits<float>::max(),
+                             1.00390625f,
+                             1.01171875f,
+                             65520.0f,
+                             6.0e-8f};
+  for (size_t i = 0; i < sizeof(kSpecials) / sizeof(kSpecials[0]); ++i) {
+    values[i * 37] = kSpecials[i];
+  }
+  return values;
+}
+
+template <typename T>
+std::vector<T> CreateIntegers() {
+  std::mt19937_64 generator(29);
+  std::vector<T> values(kNumElements);
+  for (auto& value : values) {
+    value = static_cast<T>(generator());
+  }
+  return values;
+}
+
+std::vector<simd::Isa> GetVectorIsas() {
+  std::vector<simd::Isa> isas;
+  for (auto isa : {simd::Isa::kAvx2, simd::Isa::kAvx512}) {
+    if (simd::GetConvertKernels(isa) != nullptr) {
+      isas.push_back(isa);
+    }
+  }
+  return isas;
+}
+
+}  // namespace
+
+TEST(SimdConvertTest, ScalarRounding) {
+  const simd::ConvertKernels* kernels =
+      simd::GetConvertKernels(simd::Isa::kScalar);
+  ASSERT_NE(kernels, nullptr);
+  // 1 + 2^-8 is a tie between 1.0 and 1 + 2^-7, and rounds to the even one.
+  std::vector<float> src = {1.00390625f, 1.01171875f, -2.0f};
+  std::vector<uint16_t> dest(src.size());
+  kernels->f32_to_bf16(src.data(), dest.data(), src.size());
+  EXPECT_EQ(dest[0], 0x3f80);
+  EXPECT_EQ(dest[1], 0x3f82);
+  EXPECT_EQ(dest[2], 0xc000);
+}
+
+TEST(SimdConvertTest, MatchesScalar) {
+  const simd::ConvertKernels* scalar =
+      simd::GetConvertKernels(simd::Isa::kScalar);
+  std::vector<float> floats = CreateFloats();
+  std::vector<uint16_t> halves = CreateIntegers<uint16_t>();
+  std::vector<int64_t> longs = CreateIntegers<int64_t>();
+  std::vector<int32_t> ints = CreateIntegers<int32_t>();
+  for (auto isa : GetVectorIsas()) {
+    SCOPED_TRACE(simd::IsaName(isa));
+    const simd::ConvertKernels* kernels = simd::GetConvertKernels(isa);
+
+    std::vector<uint16_t> expected_halves(kNumElements);
+    std::vector<uint16_t> halves_result(kNumElements);
+    scalar->f32_to_bf16(floats.data(), expected_halves.data(), kNumElements);
+    kernels->f32_to_bf16(floats.data(), halves_result.data(), kNumElements);
+    EXPECT_EQ(halves_result, expected_halves);
+
+    scalar->f32_to_f16(floats.data(), expected_halves.data(), kNumElements);
+    kernels->f32_to_f16(floats.data(), halves_result.data(), kNumElements);
+    for (int64_t i = 0; i < kNumElements; ++i) {
+      // The NaN payloads are allowed to differ.
+      if (!IsF16NaN(expected_halves[i]) || !IsF16NaN(halves_result[i])) {
+        ASSERT_EQ(halves_result[i], expected_halves[i]) << "at " << i;
+      }
+    }
+
+    std::vector<float> expected_floats(kNumElements);
+    std::vector<float> floats_result(kNumElements);
+    scalar->bf16_to_f32(halves.data(), expected_floats.data(), kNumElements);
+    kernels->bf16_to_f32(halves.data(), floats_result.data(), kNumElements);
+    for (int64_t i = 0; i < kNumElements; ++i) {
+      ASSERT_EQ(FloatBits(floats_result[i]), FloatBits(expected_floats[i]))
+          << "at " << i;
+    }
+
+    scalar->f16_to_f32(halves.data(), expected_floats.data(), kNumElements);
+    kernels->f16_to_f32(halves.data(), floats_result.data(), kNumElements);
+    for (int64_t i = 0; i < kNumElements; ++i) {
+      if (!std::isnan(expected_floats[i]) || !std::isnan(floats_result[i])) {
+        ASSERT_EQ(FloatBits(floats_result[i]), FloatBits(expected_floats[i]))
+            << "at " << i;
+      }
+    }
+
+    std::vector<int32_t> ints_result(kNumElements);
+    kernels->s64_to_s32(longs.data(), ints_result.data(), kNumElements);
+    for (int64_t i = 0; i < kNumElements; ++i) {
+      ASSERT_EQ(ints_result[i], static_cast<int32_t>(longs[i])) << "at " << i;
+    }
+
+    std::vector<int64_t> longs_result(kNumElements);
+    kernels->s32_to_s64(ints.data(), longs_result.data(), kNumElements);
+    for (int64_t i = 0; i < kNumElements; ++i) {
+      ASSERT_EQ(longs_result[i], ints[i]) << "at " << i;
+    }
+  }
+}
+
+TEST(SimdConvertTest, Transpose) {
+  const simd::ConvertKernels* scalar =
+      simd::GetConvertKernels(simd::Isa::kScalar);
+  // Odd sizes and strides, so that the blocks tails get exercised.
+  const int64_t kRows = 37;
+  const int64_t kCols = 29;
+  const int64_t kSrcStride = 31;
+  const int64_t kDestStride = 41;
+  std::vector<uint32_t> src = CreateIntegers<uint32_t>();
+  std::vector<uint32_t> expected(kCols * kDestStride);
+  scalar->transpose_32(src.data(), kSrcStride, expected.data(), kDestStride,
+                       kRows, kCols);
+  EXPECT_EQ(expected[5 * kDestStride + 3], src[3 * kSrcStride + 5]);
+  for (auto isa : GetVectorIsas()) {
+    SCOPED_TRACE(simd::IsaName(isa));
+    std::vector<uint32_t> result(kCols * kDestStride);
+    simd::GetConvertKernels(isa)->transpose_32(
+        src.data(), kSrcStride, result.data(), kDestStride, kRows, kCols);
+    EXPECT_EQ(result, expected);
+  }
+}
+
+}  // namespace cpp_test
+}  // namespace torch_xla
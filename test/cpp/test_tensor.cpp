@@ -7,6 +7,7 @@
 #include "cpp_test_util.h"
 #include "torch/csrc/autograd/variable.h"
 #include "torch_xla/csrc/aten_xla_bridge.h"
+#include "torch_xla/csrc/helpers.h"
 #include "torch_xla/csrc/tensor.h"
 #include "torch_xla/csrc/tensor_util.h"
 #include "torch_xla_test.h"
@@ -72,6 +73,79 @@ TEST_F(TensorTest, TestConversions) {
   }
 }
 
+TEST_F(TensorTest, TestLayoutConversions) {
+  struct LayoutCase {
+    std::vector<int64_t> sizes;
+    std::vector<int64_t> minor_to_major;
+  };
+  // Transposes, NCHW to NHWC, and layouts sharing the minor dimension.
+  std::vector<LayoutCase> cases = {
+      {{67, 131}, {0, 1}},
+      {{8, 19, 13, 11}, {1, 3, 2, 0}},
+      {{8, 19, 13, 11}, {3, 1, 0, 2}},
+      {{5, 1, 33, 1}, {1, 3, 2, 0}},
+  };
+  for (auto& layout_case : cases) {
+    // Going through BF16 keeps the values exact in both the layouts.
+    at::Tensor input =
+        at::rand(layout_case.sizes, at::TensorOptions(at::kFloat))
+            .to(at::kBFloat16)
+            .to(at::kFloat);
+    for (auto type : {xla::PrimitiveType::F32, xla::PrimitiveType::BF16}) {
+      xla::Shape shape = xla::ShapeUtil::MakeShapeWithLayout(
+          type, layout_case.sizes, layout_case.minor_to_major);
+      xla::Literal literal =
+          GetTensorLiteral(input, &shape, /*device=*/nullptr);
+      std::vector<int64_t> indices(layout_case.sizes.size());
+      for (size_t i = 0; i < indices.size(); ++i) {
+        indices[i] = layout_case.sizes[i] - 1;
+      }
+      at::Tensor last = input;
+      for (auto index : indices) {
+        last = last.select(0, index);
+      }
+      EXPECT_EQ(literal.GetAsDouble(indices).ValueOrDie(),
+                last.item().toDouble());
+      at::Tensor output = MakeTensorFromXlaLiteral(literal, at::kFloat);
+      EXPECT_TRUE(EqualValues(output, input)) << shape;
+    }
+  }
+}
+
+TEST_F(TensorTest, TestStridedConversions) {
+  at::Tensor base = at::rand({6, 10, 12}, at::TensorOptions(at::kFloat));
+  std::vector<at::Tensor> inputs = {
+      base.slice(/*dim=*/2, /*start=*/1, /*end=*/9),
+      base.slice(/*dim=*/1, /*start=*/0, /*end=*/10, /*step=*/3),
+      base.permute({2, 0, 1}),
+      base.select(/*dim=*/1, /*index=*/4).t(),
+      base.select(/*dim=*/2, /*index=*/0).unsqueeze(1).expand({6, 5, 10}),
+      at::rand({1}, at::TensorOptions(at::kFloat)).expand({7, 9}),
+      base.select(/*dim=*/0, /*index=*/2)
+          .select(/*dim=*/0, /*index=*/5)
+          .slice(/*dim=*/0, /*start=*/0, /*end=*/12, /*step=*/2),
+  };
+  // Both the tiled and the sliced copies are checked, as selected with
+  // XLA_TILED_TENSOR_COPY.
+  for (bool tiled : {true, false}) {
+    bool prev_tiled = SetTiledTensorCopy(tiled);
+    for (auto& input : inputs) {
+      ASSERT_FALSE(input.is_contiguous());
+      for (auto type : {xla::PrimitiveType::F32, xla::PrimitiveType::BF16}) {
+        xla::Shape shape = xla::ShapeUtil::MakeShape(
+            type, XlaHelpers::I64List(input.sizes()));
+        xla::Literal literal =
+            GetTensorLiteral(input, &shape, /*device=*/nullptr);
+        xla::Literal expected = GetTensorLiteral(input.contiguous(), &shape,
+                                                 /*device=*/nullptr);
+        EXPECT_EQ(literal, expected) << input.sizes() << " " << input.strides()
+                                     << " tiled=" << tiled;
+      }
+    }
+    SetTiledTensorCopy(prev_tiled);
+  }
+}
+
 TEST_F(TensorTest, TestAdd) {
   at::Tensor a = at::rand({2, 2}, at::TensorOptions(at::kFloat));
   at::Tensor b = at::rand({2, 2}, at::TensorOptions(at::kFloat));
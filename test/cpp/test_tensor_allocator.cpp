@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+
+#include <set>
+#include <string>
+
+#include "cpp_test_util.h"
+#include "tensorflow/compiler/xla/xla_client/metrics.h"
+#include "tensorflow/compiler/xla/xla_client/tensor_allocator.h"
+
+namespace torch_xla {
+namespace cpp_test {
+namespace {
+
+int64_t CounterValue(const std::string& name) {
+  xla::metrics::CounterData* counter = xla::metrics::GetCounter(name);
+  return counter != nullptr ? counter->Value() : 0;
+}
+
+}  // namespace
+
+TEST(TensorAllocatorTest, SizeClasses) {
+  // Small sizes are not rounded.
+  EXPECT_EQ(xla::TensorAllocator::GetSizeClass(100), 100);
+  EXPECT_EQ(xla::TensorAllocator::GetSizeClass(4096), 4096);
+  // Every power of two range is split into four classes.
+  EXPECT_EQ(xla::TensorAllocator::GetSizeClass(4097), 5120);
+  EXPECT_EQ(xla::TensorAllocator::GetSizeClass(5120), 5120);
+  EXPECT_EQ(xla::TensorAllocator::GetSizeClass(5121), 6144);
+  EXPECT_EQ(xla::TensorAllocator::GetSizeClass(8191), 8192);
+  EXPECT_EQ(xla::TensorAllocator::GetSizeClass(8192), 8192);
+  size_t base = size_t(1) << 20;
+  std::set<size_t> size_classes;
+  for (size_t num_bytes = base + 1; num_bytes <= 2 * base; num_bytes += 4099) {
+    size_t size_class = xla::TensorAllocator::GetSizeClass(num_bytes);
+    EXPECT_GE(size_class, num_bytes);
+    EXPECT_LE(size_class - num_bytes, base / 4);
+    size_classes.insert(size_class);
+  }
+  EXPECT_EQ(size_classes.size(), 4);
+}
+
+TEST(TensorAllocatorTest, HitsAndMisses) {
+  xla::TensorAllocator allocator(/*max_size=*/1 << 24, /*trim_period=*/0,
+                                 /*mlock=*/false);
+  int64_t hits = CounterValue("TensorAllocatorHits");
+  int64_t misses = CounterValue("TensorAllocatorMisses");
+  void* ptr = allocator.AllocateRaw(64, 5000);
+  EXPECT_EQ(CounterValue("TensorAllocatorMisses"), misses + 1);
+  allocator.DeallocateRaw(ptr);
+  EXPECT_EQ(allocator.RetainedSize(), 5120);
+
+  // Same size class, so the cached block is reused.
+  void* ptr2 = allocator.AllocateRaw(64, 5100);
+  EXPECT_EQ(ptr2, ptr);
+  EXPECT_EQ(CounterValue("TensorAllocatorHits"), hits + 1);
+  EXPECT_EQ(allocator.RetainedSize(), 0);
+
+  // A different size class, while the cached block is in use.
+  void* ptr3 = allocator.AllocateRaw(64, 5000);
+  EXPECT_NE(ptr3, ptr2);
+  EXPECT_EQ(CounterValue("TensorAllocatorMisses"), misses + 2);
+  void* ptr4 = allocator.AllocateRaw(64, 6000);
+  EXPECT_EQ(CounterValue("TensorAllocatorMisses"), misses + 3);
+  allocator.DeallocateRaw(ptr2);
+  allocator.DeallocateRaw(ptr3);
+  allocator.DeallocateRaw(ptr4);
+  EXPECT_EQ(allocator.RetainedSize(), 2 * 5120 + 6144);
+  EXPECT_EQ(CounterValue("TensorAllocatorHits"), hits + 1);
+}
+
+TEST(TensorAllocatorTest, TrimPeriod) {
+  static const size_t kTrimPeriod = 4;
+  static const size_t kLargeSize = 1 << 20;
+  static const size_t kSmallSize = 1 << 12;
+  xla::TensorAllocator allocator(/*max_size=*/1 << 24, kTrimPeriod,
+                                 /*mlock=*/false);
+  // Both blocks are in use at the same time during the first period, so they
+  // are both retained by the trim at its end.
+  void* large = allocator.AllocateRaw(64, kLargeSize);
+  void* small = allocator.AllocateRaw(64, kSmallSize);
+  allocator.DeallocateRaw(large);
+  allocator.DeallocateRaw(small);
+  for (size_t i = 2; i < kTrimPeriod; ++i) {
+    allocator.DeallocateRaw(allocator.AllocateRaw(64, kSmallSize));
+  }
+  EXPECT_EQ(allocator.RetainedSize(), kLargeSize + kSmallSize);
+
+  // The second period only uses the small block, so the large one is released.
+  for (size_t i = 0; i < kTrimPeriod; ++i) {
+    allocator.DeallocateRaw(allocator.AllocateRaw(64, kSmallSize));
+  }
+  EXPECT_EQ(allocator.RetainedSize(), kSmallSize);
+
+  int64_t misses = CounterValue("TensorAllocatorMisses");
+  allocator.DeallocateRaw(allocator.AllocateRaw(64, kLargeSize));
+  EXPECT_EQ(CounterValue("TensorAllocatorMisses"), misses + 1);
+}
+
+}  // namespace cpp_test
+}  // namespace torch_xla
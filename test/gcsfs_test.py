@@ -4,6 +4,7 @@ import shutil
 import sys
 import unittest
 import uuid
+import torch
 import torch_xla.utils.gcsfs as gcs
 
 _TEST_PATH = os.environ.get('GCS_TEST_PATH', None)
@@ -98,6 +99,20 @@ FZXY
     self.assertEqual(type(content), type(rcontent))
     self.assertEqual(content, rcontent)
 
+  def test_read_into(self):
+    SIZE = 20000000  # 20MB, which spans multiple read chunks
+    OFFSET = 12345
+    FNAME = 'test_read_into'
+    gcs_path = _gcs_test_path(name=FNAME)
+    content = _create_gcs_file(gcs_path, 'wb', size=SIZE, cleanup=self._cleanup)
+    tensor = torch.empty(SIZE, dtype=torch.uint8)
+    gcs.read_into(gcs_path, tensor)
+    self.assertEqual(content, tensor.numpy().tobytes())
+    tensor = torch.empty((SIZE - OFFSET) // 4, dtype=torch.int32)
+    gcs.read_into(gcs_path, tensor, offset=OFFSET)
+    self.assertEqual(content[OFFSET:OFFSET + tensor.numel() * 4],
+                     tensor.numpy().tobytes())
+
   def test_list(self):
     SIZE = 10000000  # 10MB
     FNAME = 'test_list'
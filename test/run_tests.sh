@@ -80,6 +80,16 @@ function run_async_rng {
   XLA_TRANSFER_SEED_ASYNC=1 run_test "$@"
 }
 
+function run_counter_rng {
+  echo "Running in counter based RNG mode: $@"
+  XLA_RNG_COUNTER_MODE=1 run_test "$@"
+}
+
+function run_layout_tuner {
+  echo "Running in layout tuner mode: $@"
+  XLA_LAYOUT_TUNER=1 run_test "$@"
+}
+
 function run_all_tests {
   run_dynamic python3 "$CDIR/../../test/test_view_ops.py" "$@" -v TestViewOpsXLA
   run_test python3 "$CDIR/../../test/test_torch.py" "$@" -v TestTorchDeviceTypeXLA
@@ -93,9 +103,12 @@ function run_all_tests {
   run_opbyop python3 "$CDIR/test_operations.py" "$@" --verbosity=$VERBOSITY
   run_eager_debug python3 "$CDIR/test_operations.py" "$@" --verbosity=$VERBOSITY
   run_async_rng python3 "$CDIR/test_operations.py" "$@" --verbosity=$VERBOSITY
+  run_counter_rng python3 "$CDIR/test_operations.py" "$@" --verbosity=$VERBOSITY TestCounterRNG
+  run_layout_tuner python3 "$CDIR/test_operations.py" "$@" --verbosity=$VERBOSITY TestLayoutTuner
   run_test python3 "$CDIR/test_mp_replication.py"
   run_test python3 "$CDIR/test_mp_all_to_all.py"
   run_test python3 "$CDIR/test_mp_collective_permute.py"
+  run_test python3 "$CDIR/test_mp_pipeline.py"
   run_test python3 "$CDIR/test_mp_all_gather.py"
   run_test python3 "$CDIR/test_mp_reduce_scatter.py"
   run_test python3 "$CDIR/test_mp_distributed_mm.py"
@@ -21,6 +21,27 @@ def _mp_fn(index):
       print(f'[{index}] {cpu_result}', file=sys.stderr)
       sys.exit(1)
 
+    # Testing the fused list variant, with per-tensor gather dimensions
+    tensors = [
+        torch.full([2, 3], index, dtype=torch.float, device=device),
+        torch.full([3, 2], index, dtype=torch.int32, device=device),
+        torch.full([4], index, dtype=torch.float, device=device),
+    ]
+    results = xm.all_gather(tensors, dim=[1, 0, 0])
+    ordinals = torch.arange(0, world_size, dtype=torch.float)
+    expected = [
+        ordinals.repeat_interleave(3).repeat(2, 1),
+        ordinals.to(torch.int32).repeat_interleave(3).unsqueeze(1).repeat(
+            1, 2),
+        ordinals.repeat_interleave(4),
+    ]
+    for result, exp in zip(results, expected):
+      cpu_result = result.cpu()
+      if not cpu_result.equal(exp):
+        print('xm.all_gather() produced wrong list results', file=sys.stderr)
+        print(f'[{index}] {cpu_result}', file=sys.stderr)
+        sys.exit(1)
+
     # Testing with two replica groups
     if world_size % 2 == 0 and world_size > 1:
       mp_groups = [[n for n in range(world_size) if n % 2 == 0],
@@ -5,8 +5,36 @@ import torch_xla.core.xla_model as xm
 import torch_xla.distributed.xla_multiprocessing as xmp
 
 
+def _check_chains(device):
+  # Two rings going in opposite directions, on two different token chains. On
+  # TPU these are in graph collective permutes, on XLA CPU (one device per
+  # process) they go through torch.distributed point to point transfers.
+  world_size = xm.xrt_world_size()
+  ordinal = xm.get_ordinal()
+  forward_pairs = [[i, (i + 1) % world_size] for i in range(0, world_size)]
+  backward_pairs = [[i, (i - 1) % world_size] for i in range(0, world_size)]
+  value = torch.tensor([ordinal] * 10, dtype=torch.int32, device=device)
+  forward = xm.collective_permute(value, forward_pairs, token_chain='forward')
+  backward = xm.collective_permute(
+      value * 2, backward_pairs, token_chain='backward')
+  forward = xm.collective_permute(
+      forward, forward_pairs, token_chain='forward')
+  xm.mark_step()
+  expected_forward = [(ordinal - 2) % world_size] * 10
+  expected_backward = [((ordinal + 1) % world_size) * 2] * 10
+  if (forward.cpu().tolist() != expected_forward or
+      backward.cpu().tolist() != expected_backward):
+    print(
+        'Wrong chained results from core {}: {} {}'.format(
+            ordinal, forward.cpu().tolist(), backward.cpu().tolist()),
+        file=sys.stderr)
+    sys.exit(1)
+
+
 def _mp_fn(index):
   device = xm.xla_device()
+  if xm.xrt_world_size() > 1:
+    _check_chains(device)
   if xm.xla_device_hw(device) == 'TPU':
     world_size = xm.xrt_world_size()
     ordinal = xm.get_ordinal()
@@ -0,0 +1,90 @@
+import sys
+import torch
+import torch.nn as nn
+import torch_xla
+import torch_xla.core.xla_model as xm
+import torch_xla.distributed.pipeline as xpp
+import torch_xla.distributed.xla_multiprocessing as xmp
+
+_FEATURES = 16
+_MICROBATCH_SIZE = 4
+_NUM_MICROBATCHES = 6
+
+
+def _check_schedule(schedule, num_stages, num_microbatches):
+  table = xpp.create_schedule(schedule, num_stages, num_microbatches)
+  done = dict()
+  for t, tick in enumerate(table):
+    for s, action in enumerate(tick):
+      if action is None:
+        continue
+      m = action.microbatch
+      if action.kind == xpp.FORWARD:
+        assert s == 0 or done[(xpp.FORWARD, s - 1, m)] < t
+      else:
+        assert done[(xpp.FORWARD, s, m)] < t
+        assert s == num_stages - 1 or done[(xpp.BACKWARD, s + 1, m)] < t
+      done[(action.kind, s, m)] = t
+  assert len(done) == 2 * num_stages * num_microbatches
+
+
+def _create_stage(stage):
+  torch.manual_seed(1234 + stage)
+  return nn.Sequential(nn.Linear(_FEATURES, _FEATURES), nn.Tanh())
+
+
+def _reference_grads(stage, num_stages, inputs, targets, loss_fn):
+  modules = [_create_stage(s) for s in range(num_stages)]
+  for x, target in zip(inputs, targets):
+    for module in modules:
+      x = module(x)
+    loss = loss_fn(x, target) / len(inputs)
+    loss.backward()
+  return [p.grad for p in modules[stage].parameters()]
+
+
+def _mp_fn(index):
+  for schedule in ('gpipe', '1f1b'):
+    for num_stages in (1, 2, 4, 8):
+      _check_schedule(schedule, num_stages, _NUM_MICROBATCHES)
+
+  # On XLA CPU every replica is a separate process (CPU_NUM_DEVICES of them),
+  # and the stage transfers go through the torch.distributed permute path.
+  device = xm.xla_device()
+  num_stages = xm.xrt_world_size()
+
+  torch.manual_seed(42)
+  inputs = [
+      torch.randn(_MICROBATCH_SIZE, _FEATURES)
+      for _ in range(_NUM_MICROBATCHES)
+  ]
+  targets = [
+      torch.randn(_MICROBATCH_SIZE, _FEATURES)
+      for _ in range(_NUM_MICROBATCHES)
+  ]
+  loss_fn = nn.MSELoss()
+  stage = xm.get_ordinal() % num_stages
+  expected_grads = _reference_grads(stage, num_stages, inputs, targets,
+                                    loss_fn)
+
+  for schedule in ('gpipe', '1f1b'):
+    module = _create_stage(stage).to(device)
+    pipeline = xpp.Pipeline(
+        module,
+        num_stages, [_MICROBATCH_SIZE, _FEATURES],
+        loss_fn,
+        schedule=schedule)
+    pipeline.step([x.to(device) for x in inputs],
+                  targets=[t.to(device) for t in targets])
+    xm.mark_step()
+    for param, expected in zip(module.parameters(), expected_grads):
+      if not param.grad.cpu().allclose(expected, rtol=1e-4, atol=1e-5):
+        print(
+            '[{}] Wrong {} pipeline gradients for stage {}'.format(
+                index, schedule, stage),
+            file=sys.stderr)
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+  xmp.spawn(_mp_fn, args=())
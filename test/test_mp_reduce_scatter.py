@@ -27,6 +27,27 @@ def _mp_fn(index):
     assert res.cpu().allclose(expected)
 
     xm.rendezvous('test_reduce_scatter')
+
+    # Testing the fused list variant, with per-tensor scatter dimensions
+    rand_list = [
+        torch.rand((32, shard_size * world_size, 32)),
+        torch.rand((shard_size * world_size, 8)),
+    ]
+    xrand_list = [rand.to(device) for rand in rand_list]
+    scatter_dims = [scatter_dim, 0]
+    res_list = xm.reduce_scatter(xm.REDUCE_SUM, xrand_list, scale, scatter_dims,
+                                 world_size)
+    expected_world_list = [
+        xm.all_reduce(xm.REDUCE_SUM, xrand, scale) for xrand in xrand_list
+    ]
+    xm.mark_step()
+
+    for res, expected_world, dim in zip(res_list, expected_world_list,
+                                        scatter_dims):
+      expected = expected_world.cpu().index_select(dim, slice_idx)
+      assert res.cpu().allclose(expected)
+
+    xm.rendezvous('test_reduce_scatter_list')
   else:
     print(
         'Default device {} is not a TPU device'.format(device), file=sys.stderr)
@@ -23,6 +23,8 @@ from numbers import Number
 import numpy
 import random
 import re
+import struct
+import subprocess
 import torch
 import torch.autograd as ad
 import torch.nn as nn
@@ -38,6 +40,7 @@ import torch_xla.distributed.parallel_loader as pl
 import torch_xla.test.test_utils as xtu
 import torch_xla.utils.utils as xu
 import torch_xla.utils.serialization as xser
+import torch_xla.utils.tf_record_reader as tfr
 import torch_xla.core.xla_model as xm
 import torch_xla.core.functions as xf
 import torchvision
@@ -763,6 +766,23 @@ class TestDataType(XlaTestCase):
     self.assertEqual(a_cast.dtype, torch.bfloat16)
 
 
+class TestCollectiveTokens(XlaTestCase):
+
+  def test_all_reduce_real_tokens(self):
+    if xu.getenv_as('XLA_USE_PSEUDO_TOKENS', bool, defval=False):
+      raise unittest.SkipTest('Pseudo tokens in use')
+    xla_device = xm.xla_device()
+    x = torch.randn(2, 3, device=xla_device)
+    token = torch_xla._XLAC._xla_create_token(str(xla_device))
+    result, token = torch_xla._XLAC._xla_all_reduce(xm.REDUCE_SUM, x, token,
+                                                    1.0, [])
+    result, _ = torch_xla._XLAC._xla_all_reduce(xm.REDUCE_SUM, result, token,
+                                                1.0, [])
+    hlo = torch_xla._XLAC._get_xla_tensors_hlo([result])
+    self.assertIn('after-all', hlo)
+    self.assertIn('opt-barrier', hlo)
+
+
 class TestAtenXlaTensor(XlaTestCase):
 
   def test_get_real_xla_devices(self):
@@ -1640,6 +1660,58 @@ class TestAtenXlaTensor(XlaTestCase):
       loaded_model = cpu_model.to(xla_device)
       self.assertEqual(model.state_dict(), loaded_model.state_dict())
 
+  def test_serialization_streaming_api(self):
+    with tempfile.TemporaryDirectory() as tmpdir:
+      path = os.path.join(tmpdir, 'data.pt')
+      xla_device = xm.xla_device()
+      model = XlaMNIST().to(xla_device)
+      # Use small groups, to exercise the pipelining across many of them.
+      xser.save_streaming(model.state_dict(), path, group_bytes=4096)
+      state_dict = xser.load_streaming(path)
+      cpu_model = XlaMNIST()
+      cpu_model.load_state_dict(state_dict)
+      loaded_model = cpu_model.to(xla_device)
+      self.assertEqual(model.state_dict(), loaded_model.state_dict())
+      state_dict = xser.load_streaming(
+          path, device=xla_device, group_bytes=4096)
+      for key, value in model.state_dict().items():
+        self.assertEqual(state_dict[key].device, xla_device)
+        self.assertEqual(value, state_dict[key])
+      for device in (None, xla_device):
+        state_dict = xser.load_streaming(
+            path, device=device, group_bytes=4096, mmap=True)
+        for key, value in model.state_dict().items():
+          self.assertEqual(value.cpu(), state_dict[key].cpu())
+
+  def test_serialization_streaming_dtypes(self):
+    with tempfile.TemporaryDirectory() as tmpdir:
+      path = os.path.join(tmpdir, 'data.pt')
+      tensors = [
+          torch.rand(4, 3) > 0.5,
+          torch.randint(0, 255, (4, 3), dtype=torch.uint8),
+          torch.randint(-128, 127, (5,), dtype=torch.int8),
+          torch.randint(-1000, 1000, (2, 2), dtype=torch.int16),
+          torch.randint(-1000, 1000, (3,), dtype=torch.int32),
+          torch.randint(-(1 << 40), 1 << 40, (3,), dtype=torch.int64),
+          torch.rand(3, 2).to(torch.float16),
+          torch.rand(3, 2).to(torch.bfloat16),
+          torch.rand(2, 3),
+          torch.rand(2, 3, dtype=torch.float64),
+      ]
+      xla_device = xm.xla_device()
+      xser.save_streaming([t.to(xla_device) for t in tensors], path)
+      # The tensors file stores the header values (like the number of tensors
+      # and the type codes) in little endian order.
+      with open(path + '.tensors.bin', 'rb') as fd:
+        prefix = fd.read(8 + 8 + 8 + 8)
+      self.assertEqual(prefix[:8], b'XLATSR02')
+      self.assertEqual(struct.unpack('<q', prefix[8:16])[0], len(tensors))
+      self.assertEqual(struct.unpack('<q', prefix[24:32])[0], 1)
+      loaded = xser.load_streaming(path)
+      for tensor, loaded_tensor in zip(tensors, loaded):
+        self.assertEqual(loaded_tensor.dtype, tensor.dtype)
+        self.assertEqual(loaded_tensor, tensor)
+
   def test_deepcopy(self):
     xla_device = xm.xla_device()
     x = torch.rand(5, device=xla_device)
@@ -1874,6 +1946,468 @@ class TestAsyncRNG(XlaTestCase):
       assert met.metric_data("TransferToServerAsync") == None
 
 
+def _crc32c(data):
+  crc = 0xffffffff
+  for b in data:
+    crc ^= b
+    for _ in range(0, 8):
+      crc = (crc >> 1) ^ (0x82f63b78 if crc & 1 else 0)
+  return crc ^ 0xffffffff
+
+
+def _masked_crc32c(data):
+  crc = _crc32c(data)
+  return ((((crc >> 15) | (crc << 17)) & 0xffffffff) + 0xa282ead8) & 0xffffffff
+
+
+def _pb_varint(value):
+  value &= (1 << 64) - 1
+  out = bytearray()
+  while True:
+    bits = value & 0x7f
+    value >>= 7
+    if value:
+      out.append(bits | 0x80)
+    else:
+      out.append(bits)
+      return bytes(out)
+
+
+def _pb_bytes(field, data):
+  return _pb_varint((field << 3) | 2) + _pb_varint(len(data)) + data
+
+
+def _tf_example(features):
+  # Encodes a tensorflow.Example proto. The values are either bytes (BytesList
+  # with a single value), or lists of floats (FloatList) or ints (Int64List).
+  entries = b''
+  for name, values in features.items():
+    if isinstance(values, bytes):
+      feature = _pb_bytes(1, _pb_bytes(1, values))
+    elif values and isinstance(values[0], float):
+      feature = _pb_bytes(
+          2, _pb_bytes(1, b''.join(struct.pack('<f', v) for v in values)))
+    else:
+      feature = _pb_bytes(3, _pb_bytes(1,
+                                       b''.join(_pb_varint(v) for v in values)))
+    entries += _pb_bytes(1,
+                         _pb_bytes(1, name.encode('utf-8')) +
+                         _pb_bytes(2, feature))
+  return _pb_bytes(1, entries)
+
+
+def _write_tfrecords(path, records):
+  with open(path, 'wb') as fd:
+    for record in records:
+      length = struct.pack('<Q', len(record))
+      fd.write(length)
+      fd.write(struct.pack('<I', _masked_crc32c(length)))
+      fd.write(record)
+      fd.write(struct.pack('<I', _masked_crc32c(record)))
+
+
+class TestTfExamplePipeline(XlaTestCase):
+
+  _NUM_EXAMPLES = 10
+
+  def _write_files(self, tmpdir):
+    files = [os.path.join(tmpdir, 'data{}.tfrecord'.format(i)) for i in (0, 1)]
+    for i, path in enumerate(files):
+      records = []
+      for n in range(i, self._NUM_EXAMPLES, len(files)):
+        records.append(
+            _tf_example({
+                'label': [n],
+                'x': [float(n), n + 0.5, n + 0.25],
+                'tokens': list(range(n, n + n % 3 + 1)),
+                'raw': bytes([n, 255 - n]),
+            }))
+      _write_tfrecords(path, records)
+    return files
+
+  def _features(self, **kwargs):
+    features = {
+        'label': tfr.FeatureSpec(torch.int64, []),
+        'x': tfr.FeatureSpec(torch.float32, [3]),
+        'tokens': tfr.FeatureSpec(torch.int32, [4], padding_value=-1),
+        'raw': tfr.FeatureSpec(torch.uint8, [2]),
+    }
+    features.update(kwargs)
+    return features
+
+  def _read_batches(self, files, device=None, drop_last=False, features=None):
+    pipeline = tfr.TfExamplePipeline(
+        files,
+        features or self._features(),
+        batch_size=4,
+        device=device,
+        num_readers=2,
+        drop_last=drop_last)
+    return list(pipeline)
+
+  def test_batches(self):
+    with tempfile.TemporaryDirectory() as tmpdir:
+      files = self._write_files(tmpdir)
+      for device in (None, xm.xla_device()):
+        batches = self._read_batches(files, device=device)
+        self.assertEqual([b['label'].size(0) for b in batches], [4, 4, 2])
+        batch = {
+            name: torch.cat([b[name].cpu() for b in batches])
+            for name in batches[0]
+        }
+        self.assertEqual(batch['label'].dtype, torch.int64)
+        self.assertEqual(batch['x'].dtype, torch.float32)
+        self.assertEqual(batch['tokens'].dtype, torch.int32)
+        self.assertEqual(batch['raw'].dtype, torch.uint8)
+        if device is not None:
+          self.assertEqual(batches[0]['x'].device, device)
+        # The order of the examples within the batches is not deterministic.
+        order = torch.argsort(batch['label'])
+        for n, row in enumerate(order.tolist()):
+          self.assertEqual(batch['label'][row].item(), n)
+          self.assertEqual(batch['x'][row],
+                           torch.tensor([float(n), n + 0.5, n + 0.25]))
+          tokens = list(range(n, n + n % 3 + 1))
+          tokens += [-1] * (4 - len(tokens))
+          self.assertEqual(batch['tokens'][row],
+                           torch.tensor(tokens, dtype=torch.int32))
+          self.assertEqual(batch['raw'][row],
+                           torch.tensor([n, 255 - n], dtype=torch.uint8))
+
+  def test_drop_last(self):
+    with tempfile.TemporaryDirectory() as tmpdir:
+      files = self._write_files(tmpdir)
+      batches = self._read_batches(files, drop_last=True)
+      self.assertEqual([b['label'].size(0) for b in batches], [4, 4])
+      labels = torch.cat([b['label'] for b in batches])
+      self.assertEqual(len(set(labels.tolist())), 8)
+
+  def test_errors(self):
+    with tempfile.TemporaryDirectory() as tmpdir:
+      files = self._write_files(tmpdir)
+      for device in (None, xm.xla_device()):
+        # The failing readers must close both queues, so that the consumer gets
+        # the error instead of hanging, and the pipeline threads can be joined.
+        for bad_spec in (
+            dict(missing=tfr.FeatureSpec(torch.float32, [1])),
+            dict(label=tfr.FeatureSpec(torch.float32, [])),
+        ):
+          with self.assertRaises(RuntimeError):
+            self._read_batches(
+                files, device=device, features=self._features(**bad_spec))
+
+        # A missing feature is fine when it can be padded.
+        features = self._features(
+            missing=tfr.FeatureSpec(torch.float32, [1], padding_value=3.0))
+        batches = self._read_batches(files, device=device, features=features)
+        self.assertEqual(sum(b['missing'].size(0) for b in batches),
+                         self._NUM_EXAMPLES)
+        for batch in batches:
+          self.assertTrue(torch.all(batch['missing'].cpu() == 3.0))
+
+
+class TestCollectivePermuteChains(XlaTestCase):
+
+  def test_independent_chains(self):
+    if xm.xrt_world_size() > 1:
+      raise unittest.SkipTest('Needs a single replica, for the in graph path')
+    xla_device = xm.xla_device()
+    pairs = [[0, 0]]
+    x = torch.rand(4, device=xla_device)
+    y = torch.rand(4, device=xla_device)
+    a1 = xm.collective_permute(x, pairs, token_chain='a')
+    b1 = xm.collective_permute(y, pairs, token_chain='b')
+    a2 = xm.collective_permute(x * 2, pairs, token_chain='a')
+    # The second permute of the chain "a" is ordered after the first one (by
+    # consuming its token), while the one of the chain "b" is not ordered with
+    # respect to any of them.
+    text = lambda t: torch_xla._XLAC._get_xla_tensors_text([t])
+    self.assertEqual(text(a1).count('xla::collective_permute('), 1)
+    self.assertEqual(text(b1).count('xla::collective_permute('), 1)
+    self.assertEqual(text(a2).count('xla::collective_permute('), 2)
+
+
+class TestCounterRNG(XlaTestCase):
+
+  def _run_step(self, x, count):
+    for _ in range(0, count):
+      x = torch.nn.functional.dropout(x, p=0.1)
+    graph_size = len(
+        torch_xla._XLAC._get_xla_tensors_text([x]).strip().splitlines())
+    xm.mark_step()
+    return x.cpu(), graph_size
+
+  def test(self):
+    xla_device = xm.xla_device()
+    counter_rng_mode = xu.getenv_as('XLA_RNG_COUNTER_MODE', bool, defval=False)
+    x = torch.ones(32, 32, device=xla_device)
+    xm.mark_step()
+
+    # In counter mode, every random operation adds a single seed node, instead
+    # of extending the chain of seed updates (a multiply and an add of the
+    # previous seed by scalar constants).
+    y = x
+    for _ in range(0, 4):
+      y = torch.nn.functional.dropout(y, p=0.1)
+    ir_text = torch_xla._XLAC._get_xla_tensors_text([y])
+    seed_updates = ir_text.count('s64[] aten::mul') + ir_text.count(
+        's64[] aten::add')
+    self.assertEqual(
+        ir_text.count('xla::rng_seed'), 4 if counter_rng_mode else 0)
+    self.assertEqual(seed_updates, 0 if counter_rng_mode else 8)
+    xm.mark_step()
+
+    # The graph grows by the same amount for every random operation.
+    _, size8 = self._run_step(x, 8)
+    _, size16 = self._run_step(x, 16)
+    _, size24 = self._run_step(x, 24)
+    self.assertEqual(size16 - size8, size24 - size16)
+
+    # Same graphs across steps hit the compilation cache, and the same seed
+    # generates the same numbers.
+    xm.set_rng_state(17)
+    y1, _ = self._run_step(x, 16)
+    cached_compiles = met.counter_value('CachedCompile') or 0
+    xm.set_rng_state(17)
+    y2, _ = self._run_step(x, 16)
+    y3, _ = self._run_step(x, 16)
+    self.assertEqual(met.counter_value('CachedCompile'), cached_compiles + 2)
+    self.assertEqual(y1, y2)
+    self.assertFalse(torch.equal(y2, y3))
+
+  def test_independent_streams(self):
+    xla_device = xm.xla_device()
+    # Random operations within the same step must not draw overlapping
+    # (possibly shifted) sequences. Independent uniform float samples share
+    # almost no values.
+    a = torch.rand(4096, device=xla_device)
+    b = torch.rand(4096, device=xla_device)
+    xm.mark_step()
+    common = set(a.cpu().tolist()).intersection(b.cpu().tolist())
+    self.assertLess(len(common), 16)
+
+
+class TestCpuFallback(XlaTestCase):
+
+  def test_fallback_metrics(self):
+    xla_device = xm.xla_device()
+    boundaries = torch.tensor([1, 3, 5, 7, 9], device=xla_device)
+    values = torch.tensor([[3, 6, 9], [3, 6, 9]], device=xla_device)
+    for _ in range(0, 3):
+      result = torch.bucketize(values, boundaries)
+    self.assertEqual(result.cpu(),
+                     torch.bucketize(values.cpu(), boundaries.cpu()))
+    names = [
+        name for name in met.counter_names()
+        if name.startswith('aten::bucketize')
+    ]
+    self.assertEqual(len(names), 1)
+    total_samples, accumulator, _ = met.metric_data('CpuFallbackTime.' +
+                                                    names[0])
+    self.assertEqual(total_samples, met.counter_value(names[0]))
+    self.assertGreater(accumulator, 0)
+
+  def test_fallback_batched_transfers(self):
+
+    def transfer_count(name):
+      data = met.metric_data(name)
+      return data[0] if data is not None else 0
+
+    xla_device = xm.xla_device()
+    xs = [torch.rand(4, 4) for _ in range(0, 8)]
+    ys = [torch.rand(4, 4) for _ in range(0, 8)]
+    xla_xs = [x.to(xla_device) for x in xs]
+    xla_ys = [y.to(xla_device) for y in ys]
+    xm.mark_step()
+    from_server = transfer_count('TransferFromServerTime')
+    to_server = transfer_count('TransferToServerTime')
+    # The fallback fetches the 16 inputs, and uploads the 8 results, with a
+    # single transfer each.
+    xla_results = torch._foreach_add(xla_xs, xla_ys)
+    self.assertEqual(
+        transfer_count('TransferFromServerTime'), from_server + 1)
+    self.assertEqual(transfer_count('TransferToServerTime'), to_server + 1)
+    for xla_result, x, y in zip(xla_results, xs, ys):
+      self.assertEqual(xla_result.device, xla_device)
+      self.assertEqual(xla_result.cpu(), x + y)
+
+
+class TestLayoutTuner(XlaTestCase):
+
+  def _run_step(self, x, w):
+    y = (x @ w).t() + 1.0
+    hlo = torch_xla._XLAC._get_xla_tensors_hlo([y])
+    xm.mark_step()
+    return y, hlo
+
+  def test(self):
+    xla_device = xm.xla_device()
+    layout_tuner = xu.getenv_as('XLA_LAYOUT_TUNER', bool, defval=False)
+    x = torch.rand(16, 48)
+    w = torch.rand(48, 32)
+    xla_x = x.to(xla_device)
+    xla_w = w.to(xla_device)
+    tuned_layouts = met.counter_value('TunedLayouts') or 0
+    xla_y, hlo1 = self._run_step(xla_x, xla_w)
+    self.assertEqual(xla_y.cpu(), (x @ w).t() + 1.0)
+    if layout_tuner:
+      self.assertGreater(met.counter_value('TunedLayouts'), tuned_layouts)
+    # The tuned layouts are stable, so the following steps (fed with the
+    # tensors uploaded after the first compilation) do not need relayout
+    # copies, and hit the compilation cache.
+    xla_x = x.to(xla_device)
+    xla_y, hlo2 = self._run_step(xla_x, xla_w)
+    cached_compiles = met.counter_value('CachedCompile') or 0
+    xla_y, hlo3 = self._run_step(xla_x, xla_w)
+    self.assertEqual(met.counter_value('CachedCompile'), cached_compiles + 1)
+    self.assertEqual(hlo2, hlo3)
+    self.assertLessEqual(hlo3.count(' copy('), hlo1.count(' copy('))
+
+
+class TestXrtMetrics(XlaTestCase):
+
+  def _metric_names(self, report):
+    return [
+        line.split(': ', 1)[1]
+        for line in report.splitlines()
+        if line.startswith('Metric: ') or line.startswith('Counter: ')
+    ]
+
+  def test(self):
+    xla_device = xm.xla_device()
+    x = torch.rand(4, 4, device=xla_device)
+    xm.mark_step()
+    names = self._metric_names(
+        met.xrt_metrics_report(metrics_regex=['/tensorflow/xrt/ops/execute']))
+    self.assertIn('XrtExecute', names)
+    self.assertNotIn('XrtCompile', names)
+
+    met.xrt_metrics_report(delta=True)
+    names = self._metric_names(met.xrt_metrics_report(delta=True))
+    self.assertNotIn('XrtExecute', names)
+    x = x * 2
+    xm.mark_step()
+    # A delta report of a different selection does not consume the changes.
+    execute_regex = ['/tensorflow/xrt/ops/execute']
+    names = self._metric_names(
+        met.xrt_metrics_report(metrics_regex=execute_regex, delta=True))
+    self.assertIn('XrtExecute', names)
+    names = self._metric_names(met.xrt_metrics_report(delta=True))
+    self.assertIn('XrtExecute', names)
+
+
+class TestSaveTensorsGraph(XlaTestCase):
+
+  # The graph dumper settings are read once per process, so every
+  # configuration runs in its own child process. The steps sync two different
+  # graphs, each one twice in a row: A, A, B, B, A, A, B, B.
+  _SCRIPT = """
+import torch
+import torch_xla
+import torch_xla.core.xla_model as xm
+import torch_xla.debug.metrics as met
+
+device = xm.xla_device()
+x = torch.ones(4, 4).to(device)
+for i in range(0, 8):
+  y = x + 1.0 if (i // 2) % 2 == 0 else x * 2.0
+  xm.mark_step()
+print(met.counter_value('SaveTensorsGraphDropped') or 0)
+"""
+
+  def _run_steps(self, path, **kwargs):
+    env = dict(os.environ)
+    env.pop('XRT_SHARD_ORDINAL', None)
+    env.update(
+        XLA_SAVE_TENSORS_FILE=path,
+        XLA_SAVE_TENSORS_SAMPLE_RATE='2',
+        XLA_SAVE_TENSORS_DEDUP='1')
+    env.update({name: str(value) for name, value in kwargs.items()})
+    result = subprocess.run([sys.executable, '-c', self._SCRIPT],
+                            env=env,
+                            stdout=subprocess.PIPE,
+                            check=True)
+    dropped = int(result.stdout.decode().strip().splitlines()[-1])
+    graphs = []
+    if os.path.exists(path):
+      with open(path, 'r') as f:
+        graphs = [
+            line for line in f.read().splitlines()
+            if line == '[ScheduleSyncTensorsGraph]'
+        ]
+    return len(graphs), dropped
+
+  def test_sample_and_dedup(self):
+    with tempfile.TemporaryDirectory() as tmpdir:
+      # The sampled steps are 0 (A), 2 (B), 4 (A) and 6 (B), and only the
+      # first instance of every graph is saved.
+      self.assertEqual(
+          self._run_steps(os.path.join(tmpdir, 'default.txt')), (2, 0))
+      # Same reports, with the graphs rendered by the syncing thread.
+      self.assertEqual(
+          self._run_steps(
+              os.path.join(tmpdir, 'rendered.txt'),
+              XLA_SAVE_TENSORS_MAX_RETAINED_GRAPHS=0), (2, 0))
+      # Without queue room, all the sampled graphs are dropped, as a dropped
+      # graph is not considered as saved by the dedup.
+      self.assertEqual(
+          self._run_steps(
+              os.path.join(tmpdir, 'dropped.txt'),
+              XLA_SAVE_TENSORS_QUEUE_SIZE=0), (0, 4))
+
+
+class TestViewCanonicalization(XlaTestCase):
+
+  def _ir_text(self, t):
+    return torch_xla._XLAC._get_xla_tensors_text([t])
+
+  def test_nested_slices(self):
+    x = torch.rand(32, 32)
+    xla_x = x.to(xm.xla_device())
+    xla_y = xla_x[2:30][1:20, 4:28][3:10, 1:-1]
+    ir_text = self._ir_text(xla_y)
+    self.assertEqual(ir_text.count('xla::generic_slice('), 1)
+    self.assertEqual(ir_text.count('xla::select('), 0)
+    self.assertEqual(xla_y.cpu(), x[2:30][1:20, 4:28][3:10, 1:-1])
+
+  def test_permutes_and_reshapes(self):
+    x = torch.rand(4, 8, 16)
+    xla_x = x.to(xm.xla_device())
+    xla_y = xla_x.permute(2, 0, 1).permute(1, 2, 0)
+    self.assertEqual(self._ir_text(xla_y).count('aten::permute('), 0)
+    self.assertEqual(xla_y.cpu(), x)
+    xla_y = xla_x.view(32, 16).view(16, 32).view(8, 64)
+    self.assertEqual(self._ir_text(xla_y).count('aten::view('), 1)
+    self.assertEqual(xla_y.cpu(), x.view(8, 64))
+
+  def test_batched_slice_updates(self):
+    x = torch.zeros(8, 4)
+    xla_x = x.to(xm.xla_device())
+    for i in range(0, 8):
+      x[i:i + 1] = i
+      xla_x[i:i + 1] = i
+    ir_text = self._ir_text(xla_x)
+    self.assertEqual(ir_text.count('xla::update_slices('), 1)
+    self.assertEqual(ir_text.count('xla::update_slice('), 0)
+    # The adjacent rows are concatenated and written by a single update.
+    hlo = torch_xla._XLAC._get_xla_tensors_hlo([xla_x])
+    self.assertEqual(hlo.count(' dynamic-update-slice('), 1)
+    self.assertEqual(xla_x.cpu(), x)
+
+  def test_batched_disjoint_slice_updates(self):
+    x = torch.zeros(8, 4)
+    xla_x = x.to(xm.xla_device())
+    for i in [0, 1, 4, 5, 3]:
+      x[i:i + 1] = i
+      xla_x[i:i + 1] = i
+    x[:, 1:2] = 9
+    xla_x[:, 1:2] = 9
+    hlo = torch_xla._XLAC._get_xla_tensors_hlo([xla_x])
+    # One update for each run of adjacent rows, and one for the column.
+    self.assertEqual(hlo.count(' dynamic-update-slice('), 4)
+    self.assertEqual(xla_x.cpu(), x)
+
+
 class TestOpBuilder(XlaTestCase):
 
   def runOpBuilderTest(self,
@@ -33,6 +33,7 @@ class AsyncTask {
       : data_(std::make_shared<Data>(std::move(taskfn))) {}
 
   AsyncTask& Wait() {
+    xla::env::ScopedBlockingWait blocking_wait;
     std::unique_lock<std::mutex> lock(data_->mutex);
     XLA_CHECK(data_->scheduled);
     data_->cv.wait(lock, [this] { return data_->completed; });
@@ -73,11 +73,25 @@ class ComputationClient {
 
     const ProgramShape& program_shape() const { return program_shape_; }
 
+    // The program shape with the parameter and result layouts picked by the
+    // compiler, which can differ from the ones requested by program_shape().
+    // Clients which do not report it return program_shape().
+    const ProgramShape& compiled_program_shape() const {
+      return compiled_program_shape_ ? *compiled_program_shape_
+                                     : program_shape_;
+    }
+
     const std::vector<std::string>& devices() const { return devices_; }
 
+   protected:
+    void set_compiled_program_shape(ProgramShape compiled_program_shape) {
+      compiled_program_shape_ = std::move(compiled_program_shape);
+    }
+
    private:
     XlaComputation computation_;
     ProgramShape program_shape_;
+    absl::optional<ProgramShape> compiled_program_shape_;
     std::vector<std::string> devices_;
   };
 
@@ -265,7 +279,15 @@ class ComputationClient {
 
   virtual void SetRngSeed(size_t seed) = 0;
 
-  virtual std::map<std::string, Metric> GetMetrics() const = 0;
+  // Collects the metrics of the backend. An empty metrics_regex selects all
+  // of them. If delta is true, only the metrics which changed since the
+  // previous delta collection with the same metrics_regex are returned.
+  virtual std::map<std::string, Metric> GetMetrics(
+      const std::vector<std::string>& metrics_regex, bool delta) const = 0;
+
+  std::map<std::string, Metric> GetMetrics() const {
+    return GetMetrics(/*metrics_regex=*/{}, /*delta=*/false);
+  }
 
   virtual MemoryInfo GetMemoryInfo(const std::string& device) = 0;
 
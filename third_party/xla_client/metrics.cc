@@ -154,44 +154,141 @@ CounterData* MetricsArena::GetCounter(const std::string& name) {
   return it != counters_.end() ? it->second.get() : nullptr;
 }
 
+struct MetricData::Shard {
+  // The slots are written by the thread which claimed their position, and
+  // seqno (twice the position, plus one while the write is in progress, plus
+  // two once it is complete) lets the readers detect partial writes, and the
+  // ones for positions which have been overwritten.
+  struct Slot {
+    std::atomic<uint64_t> seqno{0};
+    std::atomic<int64_t> timestamp_ns{0};
+    std::atomic<double> value{0.0};
+  };
+
+  explicit Shard(size_t size) : slots(new Slot[size]), size(size) {}
+
+  std::unique_ptr<Slot[]> slots;
+  size_t size;
+  std::atomic<uint64_t> count{0};
+  std::atomic<double> accumulator{0.0};
+  // Keeps the hot fields of different shards out of the same cache line.
+  char padding[64];
+};
+
+constexpr size_t MetricData::kMaxShards;
+
 MetricData::MetricData(MetricReprFn repr_fn, size_t max_samples)
-    : repr_fn_(std::move(repr_fn)), samples_(max_samples) {}
+    : repr_fn_(std::move(repr_fn)), max_samples_(max_samples) {
+  for (auto& shard : shards_) {
+    shard.store(nullptr);
+  }
+}
+
+MetricData::~MetricData() {
+  for (auto& shard : shards_) {
+    delete shard.load();
+  }
+}
+
+MetricData::Shard* MetricData::GetShard() {
+  static std::atomic<size_t> next_shard(0);
+  static thread_local size_t thread_shard = next_shard++ % kMaxShards;
+  std::atomic<Shard*>& shard_ptr = shards_[thread_shard];
+  Shard* shard = shard_ptr.load(std::memory_order_acquire);
+  if (TF_PREDICT_FALSE(shard == nullptr)) {
+    // The shard buffers are allocated on first use, as most metrics are only
+    // ever updated by a few threads. Their sizes decrease geometrically with
+    // the allocation order, which bounds the memory used by every metric.
+    size_t index = std::min<size_t>(num_shards_.fetch_add(1), 63);
+    size_t size = std::max<size_t>(
+        {max_samples_ >> index, max_samples_ / kMaxShards, 1});
+    std::unique_ptr<Shard> new_shard = absl::make_unique<Shard>(size);
+    if (shard_ptr.compare_exchange_strong(shard, new_shard.get(),
+                                          std::memory_order_acq_rel)) {
+      shard = new_shard.release();
+    }
+  }
+  return shard;
+}
 
 void MetricData::AddSample(int64_t timestamp_ns, double value) {
-  std::lock_guard<std::mutex> lock(lock_);
-  size_t position = count_ % samples_.size();
-  ++count_;
-  accumulator_ += value;
-  samples_[position] = Sample(timestamp_ns, value);
+  Shard* shard = GetShard();
+  uint64_t position = shard->count.fetch_add(1, std::memory_order_relaxed);
+  Shard::Slot& slot = shard->slots[position % shard->size];
+  slot.seqno.store(2 * position + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.timestamp_ns.store(timestamp_ns, std::memory_order_relaxed);
+  slot.value.store(value, std::memory_order_relaxed);
+  slot.seqno.store(2 * position + 2, std::memory_order_release);
+  // Unless more than kMaxShards threads are updating this metric, the shard is
+  // only written by this thread, and the exchange never fails.
+  double accumulator = shard->accumulator.load(std::memory_order_relaxed);
+  while (!shard->accumulator.compare_exchange_weak(
+      accumulator, accumulator + value, std::memory_order_relaxed)) {
+  }
 }
 
 double MetricData::Accumulator() const {
-  std::lock_guard<std::mutex> lock(lock_);
-  return accumulator_;
+  double accumulator = 0.0;
+  for (auto& shard_ptr : shards_) {
+    Shard* shard = shard_ptr.load(std::memory_order_acquire);
+    if (shard != nullptr) {
+      accumulator += shard->accumulator.load(std::memory_order_relaxed);
+    }
+  }
+  return accumulator;
 }
 
 size_t MetricData::TotalSamples() const {
-  std::lock_guard<std::mutex> lock(lock_);
-  return count_;
+  size_t total_samples = 0;
+  for (auto& shard_ptr : shards_) {
+    Shard* shard = shard_ptr.load(std::memory_order_acquire);
+    if (shard != nullptr) {
+      total_samples += shard->count.load(std::memory_order_relaxed);
+    }
+  }
+  return total_samples;
 }
 
 std::vector<Sample> MetricData::Samples(double* accumulator,
                                         size_t* total_samples) const {
-  std::lock_guard<std::mutex> lock(lock_);
   std::vector<Sample> samples;
-  if (count_ <= samples_.size()) {
-    samples.insert(samples.end(), samples_.begin(), samples_.begin() + count_);
-  } else {
-    size_t position = count_ % samples_.size();
-    samples.insert(samples.end(), samples_.begin() + position, samples_.end());
-    samples.insert(samples.end(), samples_.begin(),
-                   samples_.begin() + position);
+  double shards_accumulator = 0.0;
+  size_t shards_count = 0;
+  for (auto& shard_ptr : shards_) {
+    Shard* shard = shard_ptr.load(std::memory_order_acquire);
+    if (shard == nullptr) {
+      continue;
+    }
+    shards_accumulator += shard->accumulator.load(std::memory_order_relaxed);
+    uint64_t count = shard->count.load(std::memory_order_acquire);
+    shards_count += count;
+    uint64_t start = count > shard->size ? count - shard->size : 0;
+    for (uint64_t position = start; position < count; ++position) {
+      const Shard::Slot& slot = shard->slots[position % shard->size];
+      uint64_t seqno = slot.seqno.load(std::memory_order_acquire);
+      Sample sample(slot.timestamp_ns.load(std::memory_order_relaxed),
+                    slot.value.load(std::memory_order_relaxed));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      // Skip the samples still being written, or already overwritten.
+      if (seqno == 2 * position + 2 &&
+          slot.seqno.load(std::memory_order_relaxed) == seqno) {
+        samples.push_back(sample);
+      }
+    }
+  }
+  std::stable_sort(samples.begin(), samples.end(),
+                   [](const Sample& s1, const Sample& s2) {
+                     return s1.timestamp_ns < s2.timestamp_ns;
+                   });
+  if (samples.size() > max_samples_) {
+    samples.erase(samples.begin(), samples.end() - max_samples_);
   }
   if (accumulator != nullptr) {
-    *accumulator = accumulator_;
+    *accumulator = shards_accumulator;
   }
   if (total_samples != nullptr) {
-    *total_samples = count_;
+    *total_samples = shards_count;
   }
   return samples;
 }
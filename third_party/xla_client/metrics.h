@@ -27,14 +27,22 @@ struct Sample {
 using MetricReprFn = std::function<std::string(double)>;
 
 // Class used to collect time-stamped numeric samples. The samples are stored in
-// a circular buffer whose size can be configured at constructor time.
+// circular buffers whose size can be configured at constructor time.
+// Since metrics are updated from hot paths, by many threads at once, every
+// thread appends its samples, without taking any lock, to the circular buffer
+// of one out of a fixed set of shards, which are merged only when the samples
+// are read. The first shard holds max_samples samples, and every further one
+// half of the previous, down to max_samples / kMaxShards, so that a metric
+// never holds more than 3 * max_samples samples.
 class MetricData {
  public:
-  // Creates a new MetricData object with the internal circular buffer storing
+  // Creates a new MetricData object with the internal circular buffers storing
   // max_samples samples. The repr_fn argument allow to specify a function which
   // pretty-prints a sample value.
   MetricData(MetricReprFn repr_fn, size_t max_samples);
 
+  ~MetricData();
+
   // Returns the total values of all the samples being posted to this metric.
   double Accumulator() const;
 
@@ -42,20 +50,28 @@ class MetricData {
 
   void AddSample(int64_t timestamp_ns, double value);
 
-  // Returns a vector with all the current samples, from the oldest to the
-  // newer. If accumulator is not nullptr, it will receive the current value of
-  // the metrics' accumulator (the sum of all posted values). If total_samples
-  // is not nullptr, it will receive the count of the posted values.
+  // Returns a vector with the most recent max_samples samples, from the oldest
+  // to the newer. If accumulator is not nullptr, it will receive the current
+  // value of the metrics' accumulator (the sum of all posted values). If
+  // total_samples is not nullptr, it will receive the count of the posted
+  // values.
   std::vector<Sample> Samples(double* accumulator, size_t* total_samples) const;
 
   std::string Repr(double value) const { return repr_fn_(value); }
 
  private:
-  mutable std::mutex lock_;
+  struct Shard;
+
+  // The threads are assigned to the shards in round robin order, so up to
+  // kMaxShards threads can add samples without sharing any cache line.
+  static constexpr size_t kMaxShards = 32;
+
+  Shard* GetShard();
+
   MetricReprFn repr_fn_;
-  size_t count_ = 0;
-  std::vector<Sample> samples_;
-  double accumulator_ = 0.0;
+  size_t max_samples_ = 0;
+  std::atomic<size_t> num_shards_{0};
+  std::atomic<Shard*> shards_[kMaxShards];
 };
 
 // Counters are a very lightweight form of metrics which do not need to track
@@ -1,5 +1,10 @@
 #include "tensorflow/compiler/xla/xla_client/metrics_analysis.h"
 
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
 #include "absl/types/variant.h"
 #include "tensorflow/compiler/xla/xla_client/computation_client.h"
 #include "tensorflow/compiler/xla/xla_client/metrics.h"
@@ -156,14 +161,43 @@ class XrtMetricFrequency : public Analyzer {
 class UnloweredOp : public Analyzer {
  public:
   Analysis Run() override {
-    std::stringstream ss;
+    struct FallbackInfo {
+      std::string name;
+      int64_t count = 0;
+      double time_ns = 0.0;
+    };
+
+    std::vector<FallbackInfo> fallbacks;
     MetricsArena* arena = MetricsArena::Get();
-    arena->ForEachCounter([&ss](const std::string& name, CounterData* data) {
+    arena->ForEachCounter([&](const std::string& name, CounterData* data) {
       if (absl::StrContains(name, "aten::") &&
           name != "aten::_local_scalar_dense") {
-        ss << name << ", ";
+        fallbacks.push_back({name, data->Value(), 0.0});
       }
     });
+    // The CPU fallback records the host time spent within each operator
+    // fallback, so that the most expensive ones can be reported first.
+    for (auto& fallback : fallbacks) {
+      MetricData* metric =
+          arena->GetMetric(absl::StrCat("CpuFallbackTime.", fallback.name));
+      if (metric != nullptr) {
+        fallback.time_ns = metric->Accumulator();
+      }
+    }
+    std::stable_sort(fallbacks.begin(), fallbacks.end(),
+                     [](const FallbackInfo& f1, const FallbackInfo& f2) {
+                       return f1.time_ns > f2.time_ns ||
+                              (f1.time_ns == f2.time_ns && f1.count > f2.count);
+                     });
+
+    std::stringstream ss;
+    for (auto& fallback : fallbacks) {
+      ss << fallback.name << " (" << fallback.count << " calls";
+      if (fallback.time_ns > 0) {
+        ss << ", " << MetricFnTime(fallback.time_ns);
+      }
+      ss << "), ";
+    }
 
     std::string repr = ss.str();
     if (!repr.empty()) {
@@ -1,5 +1,6 @@
 #include "tensorflow/compiler/xla/xla_client/metrics_reader.h"
 
+#include <map>
 #include <sstream>
 
 #include "tensorflow/compiler/xla/xla_client/computation_client.h"
@@ -28,8 +29,8 @@ MetricFnInfo GetMetricRenderInfo(const Percentile& percentile) {
   }
 }
 
-std::string CreateXrtMetricReport() {
-  auto xrt_metrics = ComputationClient::Get()->GetMetrics();
+std::string FormatXrtMetrics(
+    const std::map<std::string, Metric>& xrt_metrics) {
   std::stringstream ss;
   for (auto& name_metric : xrt_metrics) {
     if (name_metric.second.percentile) {
@@ -71,7 +72,14 @@ std::string CreateXrtMetricReport() {
 }  // namespace
 
 std::string CreateMetricReport() {
-  return metrics::CreateMetricReport() + CreateXrtMetricReport();
+  return metrics::CreateMetricReport() +
+         FormatXrtMetrics(ComputationClient::Get()->GetMetrics());
+}
+
+std::string CreateXrtMetricReport(const std::vector<std::string>& metrics_regex,
+                                  bool delta) {
+  return FormatXrtMetrics(
+      ComputationClient::Get()->GetMetrics(metrics_regex, delta));
 }
 
 }  // namespace metrics_reader
@@ -2,6 +2,7 @@
 #define XLA_CLIENT_METRICS_READER_H_
 
 #include <string>
+#include <vector>
 
 namespace xla {
 namespace metrics_reader {
@@ -9,6 +10,13 @@ namespace metrics_reader {
 // Creates a report with the current metrics statistics.
 std::string CreateMetricReport();
 
+// Creates a report with the XRT metrics selected by the metrics_regex regular
+// expressions (all of them if empty). If delta is true, only the metrics which
+// changed since the previous delta report with the same metrics_regex are
+// included.
+std::string CreateXrtMetricReport(const std::vector<std::string>& metrics_regex,
+                                  bool delta);
+
 }  // namespace metrics_reader
 }  // namespace xla
 
@@ -3,6 +3,8 @@
 #include <chrono>
 #include <exception>
 
+#include "tensorflow/compiler/xla/xla_client/thread_pool.h"
+
 namespace xla {
 namespace util {
 
@@ -19,6 +21,11 @@ void MultiWait::Done() {
 }
 
 void MultiWait::Wait() {
+  // When called from a thread pool worker, run the closures it scheduled while
+  // waiting, as they are likely the ones we are waiting for.
+  while (!IsCompleted() && env::RunLocalClosure()) {
+  }
+  env::ScopedBlockingWait blocking_wait;
   std::unique_lock<std::mutex> lock(mutex_);
   cv_.wait(lock, [this] { return completed_count_ >= count_; });
   if (exptr_ != nullptr) {
@@ -27,6 +34,7 @@ void MultiWait::Wait() {
 }
 
 void MultiWait::Wait(double wait_seconds) {
+  env::ScopedBlockingWait blocking_wait;
   std::unique_lock<std::mutex> lock(mutex_);
   if (!cv_.wait_for(lock, std::chrono::duration<double>(wait_seconds),
                     [this] { return completed_count_ >= count_; })) {
@@ -37,6 +45,11 @@ void MultiWait::Wait(double wait_seconds) {
   }
 }
 
+bool MultiWait::IsCompleted() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return completed_count_ >= count_;
+}
+
 void MultiWait::Reset(size_t count) {
   std::lock_guard<std::mutex> lock(mutex_);
   count_ = count;
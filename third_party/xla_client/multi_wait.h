@@ -43,6 +43,8 @@ class MultiWait {
                                          std::function<void()> func);
 
  private:
+  bool IsCompleted();
+
   void Complete(const std::function<void()>& func);
 
   std::mutex mutex_;
@@ -0,0 +1,173 @@
+#include "tensorflow/compiler/xla/xla_client/tensor_allocator.h"
+
+#include <sys/mman.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include "tensorflow/compiler/xla/xla_client/debug_macros.h"
+#include "tensorflow/compiler/xla/xla_client/metrics.h"
+#include "tensorflow/compiler/xla/xla_client/sys_util.h"
+#include "tensorflow/compiler/xla/xla_client/tf_logging.h"
+#include "tensorflow/compiler/xla/xla_client/util.h"
+#include "tensorflow/core/lib/math/math_util.h"
+
+namespace xla {
+namespace {
+
+// Allocations up to this size are only rounded up to their alignment.
+constexpr size_t kMinSizeClassBytes = 4096;
+
+metrics::Metric* RetainedBytesMetric() {
+  static metrics::Metric* metric = new metrics::Metric(
+      "TensorAllocatorRetainedBytes", metrics::MetricFnBytes);
+  return metric;
+}
+
+}  // namespace
+
+size_t TensorAllocator::AllocKey::Hash::operator()(const AllocKey& hk) const {
+  return util::StdHashCombine(hk.alignment, hk.num_bytes);
+}
+
+TensorAllocator* TensorAllocator::Get() {
+  static size_t max_size =
+      sys_util::GetEnvInt("XLA_TENSOR_ALLOCATOR_MAXSIZE", 1000000000);
+  static size_t trim_period =
+      sys_util::GetEnvInt("XLA_TENSOR_ALLOCATOR_TRIM_PERIOD", 10000);
+  static bool mlock = sys_util::GetEnvBool("XLA_TENSOR_ALLOCATOR_MLOCK", false);
+  static TensorAllocator* allocator =
+      new TensorAllocator(max_size, trim_period, mlock);
+  return allocator;
+}
+
+TensorAllocator::TensorAllocator(size_t max_size, size_t trim_period,
+                                 bool mlock)
+    : max_size_(max_size), trim_period_(trim_period), mlock_(mlock) {}
+
+TensorAllocator::~TensorAllocator() {
+  std::lock_guard<std::mutex> lock(lock_);
+  TrimCache(0);
+}
+
+size_t TensorAllocator::GetSizeClass(size_t num_bytes) {
+  if (num_bytes <= kMinSizeClassBytes) {
+    return num_bytes;
+  }
+  // Split every power of two range into four classes, which bounds the memory
+  // wasted by the rounding to 25%.
+  size_t step = size_t(1) << (63 - __builtin_clzll(num_bytes) - 2);
+  return tensorflow::MathUtil::CeilOfRatio(num_bytes, step) * step;
+}
+
+void* TensorAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
+  // We use an alignment-sized area before the memory returned to the caller,
+  // to store a pointer to its AllocBlocks.
+  alignment = std::max<size_t>(alignment, sizeof(void*));
+  // To call aligned_alloc(), num_bytes must be multiple of alignment.
+  num_bytes = tensorflow::MathUtil::CeilOfRatio(GetSizeClass(num_bytes),
+                                                alignment) *
+              alignment;
+
+  AllocKey alloc_key = {alignment, num_bytes};
+  void* block = nullptr;
+  AllocBlocks* alloc_blocks = nullptr;
+  std::lock_guard<std::mutex> lock(lock_);
+  auto it = allocs_.find(alloc_key);
+  if (it != allocs_.end()) {
+    alloc_blocks = &*it->second;
+    if (!alloc_blocks->blocks.empty()) {
+      block = alloc_blocks->blocks.back();
+      alloc_blocks->blocks.pop_back();
+    }
+    // LRU
+    alloc_list_.splice(alloc_list_.begin(), alloc_list_, it->second);
+  } else {
+    allocs_.emplace(alloc_key,
+                    alloc_list_.insert(alloc_list_.begin(), alloc_key));
+    alloc_blocks = &alloc_list_.front();
+  }
+  if (block == nullptr) {
+    XLA_COUNTER("TensorAllocatorMisses", 1);
+    TrimCache(max_size_ > num_bytes ? max_size_ - num_bytes : 0);
+    block = NewBlock(alloc_blocks);
+  } else {
+    XLA_COUNTER("TensorAllocatorHits", 1);
+  }
+  in_use_size_ += num_bytes;
+  high_water_size_ = std::max(high_water_size_, in_use_size_);
+  allocations_ += 1;
+  if (trim_period_ > 0 && allocations_ % trim_period_ == 0) {
+    TrimCache(high_water_size_);
+    high_water_size_ = in_use_size_;
+    UpdateRetainedMetric();
+  }
+  return block;
+}
+
+void TensorAllocator::DeallocateRaw(void* ptr) {
+  if (ptr != nullptr) {
+    // The pointer to AllocBlocks is right before the user memory.
+    AllocBlocks* alloc_blocks = reinterpret_cast<AllocBlocks**>(ptr)[-1];
+    std::lock_guard<std::mutex> lock(lock_);
+    in_use_size_ -= alloc_blocks->alloc_key.num_bytes;
+    if (alloc_blocks->alloc_key.num_bytes < max_size_) {
+      alloc_blocks->blocks.push_back(ptr);
+    } else {
+      // We do not cache blocks whose size is bigger than the max cache size.
+      FreeBlock(ptr, alloc_blocks);
+    }
+  }
+}
+
+size_t TensorAllocator::RetainedSize() {
+  std::lock_guard<std::mutex> lock(lock_);
+  return size_ - in_use_size_;
+}
+
+void* TensorAllocator::NewBlock(AllocBlocks* alloc_blocks) {
+  // We allocate an extra alignment sized area to store the AllocBlocks
+  // pointer.
+  size_t size =
+      alloc_blocks->alloc_key.alignment + alloc_blocks->alloc_key.num_bytes;
+  void* base = ::aligned_alloc(alloc_blocks->alloc_key.alignment, size);
+  XLA_CHECK(base != nullptr);
+  if (mlock_ && ::mlock(base, size) != 0) {
+    XLA_COUNTER("TensorAllocatorMlockFailures", 1);
+    TF_VLOG(3) << "Unable to lock " << size
+               << " bytes in memory: " << std::strerror(errno);
+  }
+  void* ptr = reinterpret_cast<char*>(base) + alloc_blocks->alloc_key.alignment;
+  // Store the pointer to AllocBlocks right before the user memory.
+  reinterpret_cast<AllocBlocks**>(ptr)[-1] = alloc_blocks;
+  size_ += alloc_blocks->alloc_key.num_bytes;
+  return ptr;
+}
+
+void TensorAllocator::FreeBlock(void* ptr, AllocBlocks* alloc_blocks) {
+  size_ -= alloc_blocks->alloc_key.num_bytes;
+  void* base = reinterpret_cast<char*>(ptr) - alloc_blocks->alloc_key.alignment;
+  if (mlock_) {
+    ::munlock(base, alloc_blocks->alloc_key.alignment +
+                        alloc_blocks->alloc_key.num_bytes);
+  }
+  std::free(base);
+}
+
+void TensorAllocator::TrimCache(size_t max_size) {
+  auto it = alloc_list_.rbegin();
+  for (; size_ > max_size && it != alloc_list_.rend(); ++it) {
+    AllocBlocks* alloc_blocks = &*it;
+    while (!alloc_blocks->blocks.empty() && size_ > max_size) {
+      FreeBlock(alloc_blocks->blocks.back(), alloc_blocks);
+      alloc_blocks->blocks.pop_back();
+    }
+  }
+}
+
+void TensorAllocator::UpdateRetainedMetric() {
+  RetainedBytesMetric()->AddSample(size_ - in_use_size_);
+}
+
+}  // namespace xla
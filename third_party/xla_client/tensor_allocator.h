@@ -0,0 +1,100 @@
+#ifndef XLA_CLIENT_TENSOR_ALLOCATOR_H_
+#define XLA_CLIENT_TENSOR_ALLOCATOR_H_
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+
+namespace xla {
+
+// A Tensorflow Allocator which caches the host staging buffers used by the
+// transfers to the devices, in order to avoid paying the kernel's
+// clear_page_c() price, and to stop churning the system allocator with the
+// identical large allocations issued by every training step.
+// The requested sizes are rounded up to size classes (four per power of two),
+// so that the buffers can be reused across shapes with similar sizes. The
+// cached buffers are released in LRU order whenever the total allocated memory
+// would exceed XLA_TENSOR_ALLOCATOR_MAXSIZE. Every
+// XLA_TENSOR_ALLOCATOR_TRIM_PERIOD allocations, the cache is also trimmed down
+// to the high-water mark of the memory in use during the last period, so that
+// the buffers left over by a change of shapes do not stay around forever.
+// The TensorAllocatorRetainedBytes metric samples the size of the cached
+// buffers not in use at every trim period.
+// If XLA_TENSOR_ALLOCATOR_MLOCK is true, the buffers are locked in memory, so
+// that they are never paged out while waiting to be reused.
+class TensorAllocator : public tensorflow::Allocator {
+ public:
+  static TensorAllocator* Get();
+
+  // Creates a private allocator. Used by tests, everything else should use the
+  // process wide one returned by Get().
+  TensorAllocator(size_t max_size, size_t trim_period, bool mlock);
+
+  ~TensorAllocator() override;
+
+  std::string Name() override { return "XLA_TensorAllocator"; }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override;
+
+  void DeallocateRaw(void* ptr) override;
+
+  // Returns the size of the buffers used for allocations of num_bytes.
+  static size_t GetSizeClass(size_t num_bytes);
+
+  // Returns the total size of the cached blocks which are not in use.
+  size_t RetainedSize();
+
+ private:
+  struct AllocKey {
+    struct Hash {
+      size_t operator()(const AllocKey& hk) const;
+    };
+
+    bool operator==(const AllocKey& rhs) const {
+      return num_bytes == rhs.num_bytes && alignment == rhs.alignment;
+    }
+
+    size_t alignment = 0;
+    size_t num_bytes = 0;
+  };
+
+  struct AllocBlocks {
+    AllocBlocks(const AllocKey& alloc_key) : alloc_key(alloc_key) {}
+
+    AllocKey alloc_key;
+    std::vector<void*> blocks;
+  };
+
+  using AllocList = std::list<AllocBlocks>;
+
+  void* NewBlock(AllocBlocks* alloc_blocks);
+
+  void FreeBlock(void* ptr, AllocBlocks* alloc_blocks);
+
+  // Frees cached blocks, least recently used first, until the total allocated
+  // size is not bigger than max_size, or no more cached blocks are left.
+  void TrimCache(size_t max_size);
+
+  void UpdateRetainedMetric();
+
+  size_t max_size_ = 0;
+  size_t trim_period_ = 0;
+  bool mlock_ = false;
+  std::mutex lock_;
+  // The total size of the allocated blocks, and the one of the blocks in use.
+  size_t size_ = 0;
+  size_t in_use_size_ = 0;
+  // The maximum in_use_size_ value since the start of the current trim period.
+  size_t high_water_size_ = 0;
+  size_t allocations_ = 0;
+  AllocList alloc_list_;
+  std::unordered_map<AllocKey, AllocList::iterator, AllocKey::Hash> allocs_;
+};
+
+}  // namespace xla
+
+#endif  // XLA_CLIENT_TENSOR_ALLOCATOR_H_
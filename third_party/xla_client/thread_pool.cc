@@ -1,23 +1,61 @@
 #include "tensorflow/compiler/xla/xla_client/thread_pool.h"
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <deque>
 #include <exception>
+#include <limits>
+#include <memory>
 #include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
+#include "absl/memory/memory.h"
 #include "tensorflow/compiler/xla/xla_client/metrics.h"
+#include "tensorflow/compiler/xla/xla_client/sys_util.h"
 #include "tensorflow/compiler/xla/xla_client/tf_logging.h"
 
 namespace xla {
 namespace env {
 namespace {
 
+constexpr size_t kNoWorker = std::numeric_limits<size_t>::max();
+// The queue depth is sampled once every this many scheduled closures.
+constexpr size_t kQueueDepthSamplingPeriod = 64;
+// How long an overflow thread waits for new work before exiting.
+constexpr std::chrono::milliseconds kOverflowIdleTime(100);
+
+// A work-stealing thread pool. Every worker has two queues: a local one, for
+// the closures scheduled from within the worker itself, which are run LIFO,
+// and a shared one, which receives (round robin) the closures scheduled from
+// other threads, run FIFO. Workers which run out of work steal the oldest
+// closures from the queues of the other workers.
+// Instead of spawning a new thread whenever there is more work than waiting
+// workers, a worker waiting within a ScopedBlockingWait first runs the closures
+// it scheduled itself (which are usually the ones it waits for), and extra
+// (overflow) threads are only started to compensate for the workers which are
+// actually blocked. At most max_overflow_threads of them can be alive, and
+// they exit once the blocked workers resume, or once they run out of work.
 class ThreadPool {
  public:
-  explicit ThreadPool(size_t num_threads) {
-    threads_.reserve(num_threads);
-    for (size_t i = 0; i < num_threads; ++i) {
-      threads_.emplace_back([this]() { Worker(); });
+  ThreadPool(const std::string& name, size_t num_threads,
+             size_t max_overflow_threads)
+      : num_threads_(std::max<size_t>(num_threads, 1)),
+        max_overflow_threads_(max_overflow_threads),
+        queue_depth_metric_(new metrics::Metric(name + "QueueDepth")),
+        steals_counter_(new metrics::Counter(name + "Steals")),
+        overflow_counter_(new metrics::Counter(name + "Overflow")),
+        overflow_capped_counter_(
+            new metrics::Counter(name + "OverflowCapped")),
+        name_(name) {
+    for (size_t i = 0; i < num_threads_; ++i) {
+      queues_.push_back(absl::make_unique<WorkQueues>());
+    }
+    threads_.reserve(num_threads_);
+    for (size_t i = 0; i < num_threads_; ++i) {
+      threads_.emplace_back([this, i]() { WorkerLoop(i); });
     }
   }
 
@@ -33,87 +71,280 @@ class ThreadPool {
   }
 
   void Schedule(std::function<void()> closure) {
-    // If we have more work scheduled than waiting worker threads, just schedule
-    // it on a separate thread. This prevents tricky thread-pool-size-deadlocks
-    // caused by an undersized thread pool and closures that end up doing sync
-    // waits on the pool threads.
-    bool scheduled = false;
-    {
-      std::lock_guard<std::mutex> lock(mutex_);
-      if (work_.size() < waiting_) {
-        work_.emplace_back(std::move(closure));
-        scheduled = true;
-      }
+    if (tls_pool == this && tls_worker != kNoWorker) {
+      WorkQueues* queues = queues_[tls_worker].get();
+      std::lock_guard<std::mutex> lock(queues->mutex);
+      queues->local.push_back(std::move(closure));
+    } else {
+      WorkQueues* queues = queues_[next_queue_++ % num_threads_].get();
+      std::lock_guard<std::mutex> lock(queues->mutex);
+      queues->shared.push_back(std::move(closure));
     }
-    if (scheduled) {
+    int64_t pending = ++pending_;
+    if (num_scheduled_++ % kQueueDepthSamplingPeriod == 0) {
+      queue_depth_metric_->AddSample(pending);
+    }
+    // The pool mutex is only taken when there is an idle thread to wake up, or
+    // when an overflow thread might be needed. The waiting threads increment
+    // idle_ before checking pending_ (and the blocking ones blocked_ before
+    // checking whether to start an overflow thread), so the (sequentially
+    // consistent) checks below cannot miss them.
+    if (idle_ > 0) {
+      std::lock_guard<std::mutex> lock(mutex_);
       cv_.notify_one();
-    } else {
-      ScheduleOnThread(std::move(closure));
+    } else if (blocked_ > overflow_threads_) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      MaybeStartOverflowThread();
+    }
+  }
+
+  // Runs the most recent closure scheduled by the current worker, if any.
+  bool RunLocalClosure() {
+    if (tls_worker == kNoWorker) {
+      return false;
+    }
+    std::function<void()> closure;
+    {
+      WorkQueues* queues = queues_[tls_worker].get();
+      std::lock_guard<std::mutex> lock(queues->mutex);
+      if (queues->local.empty()) {
+        return false;
+      }
+      closure = std::move(queues->local.back());
+      queues->local.pop_back();
+      --pending_;
     }
+    RunClosure(closure);
+    return true;
+  }
+
+  void BeginBlocking() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++blocked_;
+    MaybeStartOverflowThread();
   }
 
+  void EndBlocking() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    --blocked_;
+  }
+
+  static ThreadPool* Current() { return tls_pool; }
+
  private:
-  void Worker() {
+  struct WorkQueues {
+    std::mutex mutex;
+    std::deque<std::function<void()>> local;
+    std::deque<std::function<void()>> shared;
+  };
+
+  void WorkerLoop(size_t index) {
+    tls_pool = this;
+    tls_worker = index;
     while (true) {
-      std::function<void()> closure = GetWork();
-      if (closure == nullptr) {
+      std::function<void()> closure;
+      if (PopClosure(index, &closure)) {
+        RunClosure(closure);
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (pending_ > 0) {
+        continue;
+      }
+      if (exiting_) {
         break;
       }
-      try {
-        closure();
-      } catch (const std::exception& ex) {
-        XLA_COUNTER("ThreadPoolException", 1);
-        TF_LOG(ERROR) << "Exception from running thread pool closure: "
-                      << ex.what();
+      ++idle_;
+      cv_.wait(lock, [this] { return exiting_ || pending_ > 0; });
+      --idle_;
+    }
+  }
+
+  void OverflowLoop() {
+    tls_pool = this;
+    tls_worker = kNoWorker;
+    while (true) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (exiting_ || overflow_threads_ > blocked_) {
+          // The blocked workers are back, so we are not needed anymore.
+          --overflow_threads_;
+          break;
+        }
+      }
+      std::function<void()> closure;
+      if (PopClosure(kNoWorker, &closure)) {
+        RunClosure(closure);
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (pending_ > 0) {
+        continue;
+      }
+      ++idle_;
+      bool has_work = cv_.wait_for(lock, kOverflowIdleTime, [this] {
+        return exiting_ || pending_ > 0;
+      });
+      --idle_;
+      if (!has_work) {
+        --overflow_threads_;
+        break;
       }
     }
   }
 
-  void ScheduleOnThread(std::function<void()> closure) {
-    std::thread thread(std::move(closure));
-    thread.detach();
+  // Pops the most recent closure out of the worker local queue, or the oldest
+  // one of its shared queue. Otherwise steals the oldest closure from the
+  // queues of the other workers.
+  bool PopClosure(size_t index, std::function<void()>* closure) {
+    if (index != kNoWorker) {
+      WorkQueues* queues = queues_[index].get();
+      std::lock_guard<std::mutex> lock(queues->mutex);
+      if (!queues->local.empty()) {
+        *closure = std::move(queues->local.back());
+        queues->local.pop_back();
+        --pending_;
+        return true;
+      }
+      if (!queues->shared.empty()) {
+        *closure = std::move(queues->shared.front());
+        queues->shared.pop_front();
+        --pending_;
+        return true;
+      }
+    }
+    size_t start = index != kNoWorker ? index + 1 : next_steal_++;
+    for (size_t i = 0; i < num_threads_; ++i) {
+      size_t victim = (start + i) % num_threads_;
+      if (victim == index) {
+        continue;
+      }
+      WorkQueues* queues = queues_[victim].get();
+      std::lock_guard<std::mutex> lock(queues->mutex);
+      std::deque<std::function<void()>>* queue =
+          !queues->shared.empty() ? &queues->shared : &queues->local;
+      if (!queue->empty()) {
+        *closure = std::move(queue->front());
+        queue->pop_front();
+        --pending_;
+        steals_counter_->AddValue(1);
+        return true;
+      }
+    }
+    return false;
   }
 
-  std::function<void()> GetWork() {
-    std::unique_lock<std::mutex> lock(mutex_);
-    ++waiting_;
-    cv_.wait(lock, [this] { return exiting_ || !work_.empty(); });
-    --waiting_;
-    if (work_.empty()) {
-      return nullptr;
+  void RunClosure(const std::function<void()>& closure) {
+    try {
+      closure();
+    } catch (const std::exception& ex) {
+      XLA_COUNTER("ThreadPoolException", 1);
+      TF_LOG(ERROR) << "Exception from running thread pool closure: "
+                    << ex.what();
+    }
+  }
+
+  // Starts an overflow thread if there is queued work, no idle thread to run
+  // it, and fewer non blocked threads than num_threads_. Must be called with
+  // mutex_ held.
+  void MaybeStartOverflowThread() {
+    if (pending_ <= 0 || idle_ > 0 || blocked_ <= overflow_threads_) {
+      return;
+    }
+    if (overflow_threads_ >= max_overflow_threads_) {
+      // The queued closures now have to wait for one of the blocked threads to
+      // resume, which never happens if all of them wait on each other.
+      overflow_capped_counter_->AddValue(1);
+      if (!overflow_cap_logged_) {
+        overflow_cap_logged_ = true;
+        TF_LOG(WARNING) << name_ << " overflow thread limit ("
+                        << max_overflow_threads_ << ") reached with "
+                        << blocked_ << " blocked threads. Increase it if the "
+                        << "process stops making progress";
+      }
+      return;
     }
-    std::function<void()> closure(std::move(work_.front()));
-    work_.pop_front();
-    return closure;
+    ++overflow_threads_;
+    overflow_counter_->AddValue(1);
+    std::thread thread([this]() { OverflowLoop(); });
+    thread.detach();
   }
 
+  // The pool, and the index of the worker within it, of the current thread.
+  static thread_local ThreadPool* tls_pool;
+  static thread_local size_t tls_worker;
+
+  size_t num_threads_ = 0;
+  size_t max_overflow_threads_ = 0;
+  metrics::Metric* queue_depth_metric_ = nullptr;
+  metrics::Counter* steals_counter_ = nullptr;
+  metrics::Counter* overflow_counter_ = nullptr;
+  metrics::Counter* overflow_capped_counter_ = nullptr;
+  std::string name_;
+  std::vector<std::unique_ptr<WorkQueues>> queues_;
   std::vector<std::thread> threads_;
+  // The number of closures within the queues. It is incremented after the
+  // push, so it can go transiently negative.
+  std::atomic<int64_t> pending_{0};
+  std::atomic<size_t> next_queue_{0};
+  std::atomic<size_t> next_steal_{0};
+  std::atomic<size_t> num_scheduled_{0};
   std::mutex mutex_;
   std::condition_variable cv_;
   bool exiting_ = false;
-  std::deque<std::function<void()>> work_;
-  size_t waiting_ = 0;
+  bool overflow_cap_logged_ = false;
+  // Only modified with mutex_ held, but read without it by Schedule().
+  std::atomic<size_t> idle_{0};
+  std::atomic<size_t> blocked_{0};
+  std::atomic<size_t> overflow_threads_{0};
 };
 
+thread_local ThreadPool* ThreadPool::tls_pool = nullptr;
+thread_local size_t ThreadPool::tls_worker = kNoWorker;
+
 ThreadPool* GetThreadPool() {
   static size_t num_threads = sys_util::GetEnvInt(
       "XLA_THREAD_POOL_SIZE", std::thread::hardware_concurrency());
-  static ThreadPool* pool = new ThreadPool(num_threads);
+  static size_t max_overflow_threads = sys_util::GetEnvInt(
+      "XLA_THREAD_POOL_MAX_OVERFLOW", 4 * num_threads);
+  static ThreadPool* pool =
+      new ThreadPool("ThreadPool", num_threads, max_overflow_threads);
   return pool;
 }
 
 ThreadPool* GetIoThreadPool() {
   static size_t num_threads = sys_util::GetEnvInt(
       "XLA_IO_THREAD_POOL_SIZE", std::thread::hardware_concurrency());
-  static ThreadPool* pool = new ThreadPool(num_threads);
+  static size_t max_overflow_threads = sys_util::GetEnvInt(
+      "XLA_IO_THREAD_POOL_MAX_OVERFLOW", 4 * num_threads);
+  static ThreadPool* pool =
+      new ThreadPool("IoThreadPool", num_threads, max_overflow_threads);
   return pool;
 }
 
 }  // namespace
 
+bool RunLocalClosure() {
+  ThreadPool* pool = ThreadPool::Current();
+  return pool != nullptr && pool->RunLocalClosure();
+}
+
+ScopedBlockingWait::ScopedBlockingWait() : pool_(ThreadPool::Current()) {
+  if (pool_ != nullptr) {
+    static_cast<ThreadPool*>(pool_)->BeginBlocking();
+  }
+}
+
+ScopedBlockingWait::~ScopedBlockingWait() {
+  if (pool_ != nullptr) {
+    static_cast<ThreadPool*>(pool_)->EndBlocking();
+  }
+}
+
 class Completion::Data {
  public:
   void Wait() {
+    ScopedBlockingWait blocking_wait;
     std::unique_lock<std::mutex> lock(mutex_);
     cv_.wait(lock, [this] { return completed_; });
     if (exptr_ != nullptr) {
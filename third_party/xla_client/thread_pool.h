@@ -22,6 +22,29 @@ class Completion {
   std::shared_ptr<Data> data_;
 };
 
+// Marks a wait, within a closure running on one of the thread pools, for events
+// which might be signaled by other closures scheduled on the same pool. While
+// the closure is blocked, the pool might run extra threads, so that the queued
+// closures can still make progress. Has no effect outside of the pool threads.
+class ScopedBlockingWait {
+ public:
+  ScopedBlockingWait();
+
+  ~ScopedBlockingWait();
+
+  ScopedBlockingWait(const ScopedBlockingWait&) = delete;
+  ScopedBlockingWait& operator=(const ScopedBlockingWait&) = delete;
+
+ private:
+  void* pool_ = nullptr;
+};
+
+// If the caller is a thread pool worker, runs the most recent closure it
+// scheduled, which has not been started yet, and returns true. Meant to be
+// called in a loop by closures waiting for other closures they scheduled,
+// before blocking within a ScopedBlockingWait.
+bool RunLocalClosure();
+
 // Schedules a closure to be run. The closure should not block waiting for other
 // events.
 void ScheduleClosure(std::function<void()> closure);
@@ -5,6 +5,7 @@
 #include <functional>
 #include <limits>
 #include <list>
+#include <set>
 #include <sstream>
 #include <unordered_map>
 
@@ -18,6 +19,7 @@
 #include "tensorflow/compiler/xla/xla_client/env_vars.h"
 #include "tensorflow/compiler/xla/xla_client/multi_wait.h"
 #include "tensorflow/compiler/xla/xla_client/sys_util.h"
+#include "tensorflow/compiler/xla/xla_client/tensor_allocator.h"
 #include "tensorflow/compiler/xla/xla_client/thread_pool.h"
 #include "tensorflow/compiler/xla/xla_client/unique.h"
 #include "tensorflow/compiler/xla/xla_client/util.h"
@@ -33,129 +35,6 @@ namespace {
 
 static const char* const kLocalService = "localservice";
 
-// A simple Tensorflow Allocator which caches Tensor allocations in order to
-// avoid paying the kernel's clear_page_c() price.
-class TensorAllocator : public tensorflow::Allocator {
-  struct AllocKey {
-    struct Hash {
-      size_t operator()(const AllocKey& hk) const {
-        return util::StdHashCombine(hk.alignment, hk.num_bytes);
-      }
-    };
-
-    bool operator==(const AllocKey& rhs) const {
-      return num_bytes == rhs.num_bytes && alignment == rhs.alignment;
-    }
-
-    size_t alignment = 0;
-    size_t num_bytes = 0;
-  };
-
-  struct AllocBlocks {
-    AllocBlocks(const AllocKey& alloc_key) : alloc_key(alloc_key) {}
-
-    AllocKey alloc_key;
-    std::vector<void*> blocks;
-  };
-
-  using AllocList = std::list<AllocBlocks>;
-
- public:
-  static TensorAllocator* Get() {
-    static size_t max_size =
-        sys_util::GetEnvInt("XLA_TENSOR_ALLOCATOR_MAXSIZE", 1000000000);
-    static TensorAllocator* allocator = new TensorAllocator(max_size);
-    return allocator;
-  }
-
-  std::string Name() override { return "XLA_TensorAllocator"; }
-
-  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
-    // We use an alignment-sized area before the memory returned to the caller,
-    // to store a pointer to its AllocBlocks.
-    alignment = std::max<size_t>(alignment, sizeof(void*));
-    // To call aligned_alloc(), num_bytes must be multiple of alignment.
-    num_bytes = tensorflow::MathUtil::CeilOfRatio(num_bytes, alignment) * alignment;
-
-    AllocKey alloc_key = {alignment, num_bytes};
-    void* block = nullptr;
-    AllocBlocks* alloc_blocks = nullptr;
-    std::lock_guard<std::mutex> lock(lock_);
-    auto it = allocs_.find(alloc_key);
-    if (it != allocs_.end()) {
-      alloc_blocks = &*it->second;
-      if (!alloc_blocks->blocks.empty()) {
-        block = alloc_blocks->blocks.back();
-        alloc_blocks->blocks.pop_back();
-      }
-      // LRU
-      alloc_list_.splice(alloc_list_.begin(), alloc_list_, it->second);
-    } else {
-      allocs_.emplace(alloc_key,
-                      alloc_list_.insert(alloc_list_.begin(), alloc_key));
-      alloc_blocks = &alloc_list_.front();
-    }
-    if (block == nullptr) {
-      TrimCache(alloc_key.num_bytes);
-      block = NewBlock(alloc_blocks);
-    }
-    return block;
-  }
-
-  void DeallocateRaw(void* ptr) override {
-    if (ptr != nullptr) {
-      // The pointer to AllocBlocks is right before the user memory.
-      AllocBlocks* alloc_blocks = reinterpret_cast<AllocBlocks**>(ptr)[-1];
-      std::lock_guard<std::mutex> lock(lock_);
-      if (alloc_blocks->alloc_key.num_bytes < max_size_) {
-        alloc_blocks->blocks.push_back(ptr);
-      } else {
-        // We do not cache blocks whose size is bigger than the max cache size.
-        FreeBlock(ptr, alloc_blocks);
-      }
-    }
-  }
-
- private:
-  explicit TensorAllocator(size_t max_size) : max_size_(max_size) {}
-
-  void* NewBlock(AllocBlocks* alloc_blocks) {
-    // We allocate an extra alignment sized area to store the AllocBlocks
-    // pointer.
-    void* ptr = ::aligned_alloc(
-        alloc_blocks->alloc_key.alignment,
-        alloc_blocks->alloc_key.alignment + alloc_blocks->alloc_key.num_bytes);
-    XLA_CHECK(ptr != nullptr);
-    ptr = reinterpret_cast<char*>(ptr) + alloc_blocks->alloc_key.alignment;
-    // Store the pointer to AllocBlocks right before the user memory.
-    reinterpret_cast<AllocBlocks**>(ptr)[-1] = alloc_blocks;
-    size_ += alloc_blocks->alloc_key.num_bytes;
-    return ptr;
-  }
-
-  void FreeBlock(void* ptr, AllocBlocks* alloc_blocks) {
-    size_ -= alloc_blocks->alloc_key.num_bytes;
-    std::free(reinterpret_cast<char*>(ptr) - alloc_blocks->alloc_key.alignment);
-  }
-
-  void TrimCache(size_t num_bytes) {
-    auto it = alloc_list_.rbegin();
-    for (; size_ + num_bytes > max_size_ && it != alloc_list_.rend(); ++it) {
-      AllocBlocks* alloc_blocks = &*it;
-      while (!alloc_blocks->blocks.empty() && size_ + num_bytes > max_size_) {
-        FreeBlock(alloc_blocks->blocks.back(), alloc_blocks);
-        alloc_blocks->blocks.pop_back();
-      }
-    }
-  }
-
-  size_t max_size_ = 0;
-  std::mutex lock_;
-  size_t size_ = 0;
-  AllocList alloc_list_;
-  std::unordered_map<AllocKey, AllocList::iterator, AllocKey::Hash> allocs_;
-};
-
 bool ShouldStartLocalService(const std::set<std::string>& devices) {
   // In the tpuvm pod setup, LocalService will be started in a separate process
   bool tpuvm_mode = sys_util::GetEnvBool(env::kEnvTpuvmMode, false);
@@ -224,6 +103,18 @@ T ParseProto(const tensorflow::Tensor& tensor) {
   return proto;
 }
 
+// Tells whether two snapshots of the same metric have the same value. The
+// percentiles only change if new samples have been posted.
+bool SameMetricValue(const Metric& metric1, const Metric& metric2) {
+  if (metric1.percentile && metric2.percentile) {
+    return metric1.percentile->total_samples ==
+               metric2.percentile->total_samples &&
+           metric1.percentile->accumulator == metric2.percentile->accumulator;
+  }
+  return metric1.int64_value == metric2.int64_value &&
+         metric1.percentile.has_value() == metric2.percentile.has_value();
+}
+
 int64_t GetMaxTensorsPartitionSize() {
   // We need to limit the amount of data we send to the XRT backend since
   // Protocol Buffers does not allow sizes greater than 2GB. We keep some margin
@@ -233,6 +124,14 @@ int64_t GetMaxTensorsPartitionSize() {
   return max_partition_size;
 }
 
+// The compiled program shapes are only consumed by the layout tuner, so they
+// are only fetched (and parsed) when it is enabled.
+bool FetchCompiledProgramShapes() {
+  static bool fetch_program_shapes =
+      sys_util::GetEnvBool("XLA_LAYOUT_TUNER", false);
+  return fetch_program_shapes;
+}
+
 }  // namespace
 
 XrtComputationClient::Device::Device(const std::string& device_str) {
@@ -254,6 +153,8 @@ XrtComputationClient::XrtComputationClient(
     std::unique_ptr<tensorflow::tpu::TopologyProto> topology_proto)
     : options_(std::move(options)),
       compilation_cache_(sys_util::GetEnvInt("XLA_COMPILATION_CACHE_SIZE", 64)),
+      execute_plan_cache_(
+          sys_util::GetEnvInt("XRT_EXECUTE_PLAN_CACHE_SIZE", 32)),
       rng_seed_(0x5a2d296e9) {
   tensorflow::ConfigProto config = CreateConfigProto(options_);
   std::string local_target = GetLocalTarget(options_);
@@ -270,6 +171,8 @@ XrtComputationClient::XrtComputationClient(
     XLA_CHECK(options_.global_device_map.find(device) !=
               options_.global_device_map.end())
         << "Missing device in global map: " << device;
+    Device local_device(device);
+    local_replica_mapping_[local_device.kind].push_back(local_device.ordinal);
   }
   for (const auto& dev_target : options_.global_device_map) {
     const char* tag =
@@ -287,6 +190,7 @@ XrtComputationClient::XrtComputationClient(
     MaybeCreateLocalService(options_);
   }
   InitializeDevices(std::move(topology_proto));
+  PrewarmSessions();
   StartHandleReleaser();
 }
 
@@ -610,6 +514,9 @@ std::vector<ComputationClient::ComputationPtr> XrtComputationClient::Compile(
           session_work->feed_inputs.insert(
               {cached_node.holders[0], cache_keys[i].serialized_computation});
           session_work->outputs_handles.push_back(cached_node.outputs[0]);
+          if (FetchCompiledProgramShapes()) {
+            session_work->outputs_handles.push_back(cached_node.outputs[1]);
+          }
           session_work->index_mapping.push_back(i);
         }
       } else {
@@ -638,12 +545,16 @@ std::vector<ComputationClient::ComputationPtr> XrtComputationClient::Compile(
       for (auto li : session_work.index_mapping) {
         CompileInstance* instance = &instances[li];
         MaybeSaveLongCompileHlo(compile_time, instance->computation);
+        int64_t handle = outputs[output_index++].scalar<int64_t>()();
+        absl::optional<ProgramShape> compiled_program_shape;
+        if (FetchCompiledProgramShapes()) {
+          compiled_program_shape = ProgramShape(
+              ParseProto<ProgramShapeProto>(outputs[output_index++]));
+        }
         results[li] = std::make_shared<XrtComputation>(
             this, std::move(instance->computation), program_shapes[li],
-            std::move(instance->devices),
-            outputs[output_index].scalar<int64_t>()(),
-            instance->compilation_device);
-        ++output_index;
+            std::move(instance->devices), handle, instance->compilation_device,
+            std::move(compiled_program_shape));
 
         compilation_cache_.Add(std::move(cache_keys[li]), results[li]);
         CreateCompileHandlesCounter()->AddValue(1);
@@ -678,12 +589,13 @@ XrtComputationClient::ExecuteComputation(
   tensorflow::profiler::TraceMe activity(
       "ExecuteComputation", tensorflow::profiler::TraceMeLevel::kInfo);
 
+  std::shared_ptr<ExecutePlan> plan =
+      GetExecutePlan({device}, options.explode_tuple);
   XrtSessionCache::SessionMap session_map;
   tensorflow::ClientSession::FeedType feed_inputs;
   std::vector<tensorflow::Output> exec_ops = CreateExecuteOps(
-      &session_map, dynamic_cast<const XrtComputation&>(computation),
-      BuildParallelArguments(arguments), options.explode_tuple, {device},
-      &feed_inputs);
+      &session_map, dynamic_cast<const XrtComputation&>(computation), *plan,
+      BuildParallelArguments(arguments), {device}, &feed_inputs);
 
   XrtSession* session =
       GetSessionForDevice(session_cache_.get(), device, &session_map);
@@ -707,15 +619,22 @@ XrtComputationClient::ExecuteReplicated(
   tensorflow::profiler::TraceMe activity(
       "ExecuteReplicated", tensorflow::profiler::TraceMeLevel::kInfo);
 
+  std::shared_ptr<ExecutePlan> plan =
+      GetExecutePlan(devices, options.explode_tuple);
   XrtSessionCache::SessionMap session_map;
   tensorflow::ClientSession::FeedType feed_inputs;
   std::vector<tensorflow::Output> exec_ops = CreateExecuteOps(
-      &session_map, dynamic_cast<const XrtComputation&>(computation), arguments,
-      options.explode_tuple, devices, &feed_inputs);
+      &session_map, dynamic_cast<const XrtComputation&>(computation), *plan,
+      arguments, devices, &feed_inputs);
   std::vector<const Computation*> computations(devices.size());
   std::fill(computations.begin(), computations.end(), &computation);
+  std::vector<std::string> targets;
+  targets.reserve(plan->replicas.size());
+  for (auto& replica : plan->replicas) {
+    targets.push_back(replica.target);
+  }
 
-  return RunComputations(session_map, exec_ops, computations, devices,
+  return RunComputations(session_map, exec_ops, computations, devices, targets,
                          feed_inputs);
 }
 
@@ -725,6 +644,7 @@ XrtComputationClient::RunComputations(
     const std::vector<tensorflow::Output>& exec_ops,
     absl::Span<const Computation* const> computations,
     absl::Span<const std::string> devices,
+    absl::Span<const std::string> targets,
     const tensorflow::ClientSession::FeedType& feed_inputs) {
   tensorflow::profiler::TraceMe activity(
       "RunComputations", tensorflow::profiler::TraceMeLevel::kInfo);
@@ -742,9 +662,9 @@ XrtComputationClient::RunComputations(
   // Chosing the 1:1 approach (one session per worker), we will have N sessions
   // within the session_replicas map, which we will be executing independently.
   std::map<XrtSession*, std::vector<size_t>> session_replicas;
+  XLA_CHECK_EQ(targets.size(), devices.size());
   for (size_t i = 0; i < devices.size(); ++i) {
-    auto worker_hostport = GetWorkerForDevice(devices[i]);
-    XrtSession* session = session_map.at(worker_hostport.second).get();
+    XrtSession* session = session_map.at(targets[i]).get();
     session_replicas[session].push_back(i);
   }
   XLA_CHECK_EQ(computations.size(), devices.size());
@@ -801,14 +721,15 @@ XrtComputationClient::ExecuteParallel(
       CreateExecuteOps(&session_map, computations, arguments,
                        options.explode_tuple, devices, &feed_inputs);
   return RunComputations(session_map, exec_ops, computations, devices,
-                         feed_inputs);
+                         GetDevicesTargets(devices), feed_inputs);
 }
 
 template <typename T>
 void XrtComputationClient::SetupExecConfig(const Device& device,
+                                           size_t rng_seed,
                                            T* exec_config) const {
   exec_config->set_core_index_in_replica(0);
-  exec_config->set_rng_seed(rng_seed_);
+  exec_config->set_rng_seed(rng_seed);
   if (device.kind != "TPU") {
     // TPU ignores those fields, and given that the device list can be in the
     // thousands for POD scale, we avoid wasting time filling it up.
@@ -816,15 +737,58 @@ void XrtComputationClient::SetupExecConfig(const Device& device,
         exec_config->mutable_common_config();
     cmn_config->set_replica_id(device.ordinal);
     cmn_config->set_run_id(1);
-    for (auto& devstr : options_.devices) {
-      Device local_device(devstr);
-      if (local_device.kind == device.kind) {
-        cmn_config->add_local_replica_mapping(local_device.ordinal);
+    auto it = local_replica_mapping_.find(device.kind);
+    if (it != local_replica_mapping_.end()) {
+      for (auto ordinal : it->second) {
+        cmn_config->add_local_replica_mapping(ordinal);
       }
     }
   }
 }
 
+std::shared_ptr<XrtComputationClient::ExecutePlan>
+XrtComputationClient::GetExecutePlan(absl::Span<const std::string> devices,
+                                     bool explode_tuple) {
+  // Read the seed only once, so that a concurrent SetRngSeed() cannot make the
+  // plan configs disagree with the key they are cached with.
+  size_t rng_seed = rng_seed_;
+  ExecutePlanKey plan_key(util::ToVector<std::string>(devices), explode_tuple,
+                          rng_seed);
+  std::shared_ptr<ExecutePlan> plan = execute_plan_cache_.Get(plan_key);
+  if (plan != nullptr) {
+    XLA_COUNTER("XrtExecutePlanCacheHit", 1);
+    return plan;
+  }
+  XLA_COUNTER("XrtExecutePlanCacheMiss", 1);
+  plan = std::make_shared<ExecutePlan>();
+  plan->replicas.reserve(devices.size());
+  for (auto& device : devices) {
+    ExecutePlan::Replica replica;
+    replica.xrt_device = TorchDeviceToXrtDevice(device);
+    replica.target = GetWorkerForXrtDevice(replica.xrt_device).second;
+
+    xrt::XRTExecutionConfig exec_config;
+    exec_config.set_release_input_handles(false);
+    exec_config.set_release_compilation_handle(false);
+    exec_config.set_return_exploded_tuple(explode_tuple);
+    SetupExecConfig(Device(device), rng_seed, &exec_config);
+    replica.exec_config = exec_config.SerializeAsString();
+
+    plan->replicas.push_back(std::move(replica));
+  }
+  return execute_plan_cache_.Add(std::move(plan_key), std::move(plan));
+}
+
+std::vector<std::string> XrtComputationClient::GetDevicesTargets(
+    absl::Span<const std::string> devices) const {
+  std::vector<std::string> targets;
+  targets.reserve(devices.size());
+  for (auto& device : devices) {
+    targets.push_back(GetWorkerForDevice(device).second);
+  }
+  return targets;
+}
+
 std::vector<ComputationClient::DataPtr> XrtComputationClient::ExecuteChained(
     absl::Span<const ExecuteChainedOp> ops, const std::string& device) {
   tensorflow::profiler::TraceMe activity(
@@ -846,7 +810,7 @@ std::vector<ComputationClient::DataPtr> XrtComputationClient::ExecuteChainedXrt(
   tensorflow::Scope device_scope = session->root()->WithDevice(xrt_device);
 
   xrt::XRTChainedExecuteConfig exec_config;
-  SetupExecConfig(Device(device), &exec_config);
+  SetupExecConfig(Device(device), rng_seed_, &exec_config);
 
   xrt::XRTChainedExecutePlan plan;
   std::vector<xla::Shape> result_shapes;
@@ -923,6 +887,8 @@ XrtComputationClient::ExecuteChainedSplit(
       uses[input.op_index] += 1;
     }
   }
+  std::shared_ptr<ExecutePlan> plan =
+      GetExecutePlan({device}, /*explode_tuple=*/true);
   XrtSessionCache::SessionMap session_map;
   const std::string& xrt_device = TorchDeviceToXrtDevice(device);
   XrtSession* session =
@@ -948,8 +914,7 @@ XrtComputationClient::ExecuteChainedSplit(
 
       std::vector<tensorflow::Output> exec_ops = CreateExecuteOps(
           &session_map, dynamic_cast<const XrtComputation&>(*op.computation),
-          BuildParallelArguments(arguments), /*explode_tuple=*/true, {device},
-          &feed_inputs);
+          *plan, BuildParallelArguments(arguments), {device}, &feed_inputs);
 
       std::vector<tensorflow::Tensor> outputs;
       util::CheckComputationStatus(
@@ -1128,6 +1093,8 @@ std::vector<tensorflow::Output> XrtComputationClient::CreateExecuteOps(
     const std::vector<std::vector<DataPtr>>& arguments, bool explode_tuple,
     absl::Span<const std::string> devices,
     tensorflow::ClientSession::FeedType* feed_inputs) {
+  // All the replicas of a computation must run with the same seed.
+  size_t rng_seed = rng_seed_;
   std::vector<tensorflow::Output> exec_ops;
   for (size_t i = 0; i < computations.size(); ++i) {
     const XrtComputation* xrt_computation =
@@ -1146,7 +1113,7 @@ std::vector<tensorflow::Output> XrtComputationClient::CreateExecuteOps(
     exec_config.set_release_input_handles(false);
     exec_config.set_release_compilation_handle(false);
     exec_config.set_return_exploded_tuple(explode_tuple);
-    SetupExecConfig(Device(devices[i]), &exec_config);
+    SetupExecConfig(Device(devices[i]), rng_seed, &exec_config);
 
     feed_inputs->insert(
         {cached_node.holders[1], exec_config.SerializeAsString()});
@@ -1159,28 +1126,26 @@ std::vector<tensorflow::Output> XrtComputationClient::CreateExecuteOps(
 
 std::vector<tensorflow::Output> XrtComputationClient::CreateExecuteOps(
     XrtSessionCache::SessionMap* session_map, const XrtComputation& computation,
-    const std::vector<std::vector<DataPtr>>& arguments, bool explode_tuple,
+    const ExecutePlan& plan, const std::vector<std::vector<DataPtr>>& arguments,
     absl::Span<const std::string> devices,
     tensorflow::ClientSession::FeedType* feed_inputs) {
+  XLA_CHECK_EQ(plan.replicas.size(), arguments.size());
+  // Fetch the computation handle once, as it might have to wait for the handle
+  // barrier.
+  int64_t computation_handle = computation.get_handle();
   std::vector<tensorflow::Output> exec_ops;
+  exec_ops.reserve(arguments.size());
   for (size_t i = 0; i < arguments.size(); ++i) {
+    const ExecutePlan::Replica& replica = plan.replicas[i];
     auto inputs = GetArgumentsInputs(arguments[i], devices[i]);
-    const std::string& xrt_device = TorchDeviceToXrtDevice(devices[i]);
     XrtSession* session =
-        GetSessionForXrtDevice(session_cache_.get(), xrt_device, session_map);
-    tensorflow::Scope device_scope = session->root()->WithDevice(xrt_device);
+        GetSessionForTarget(session_cache_.get(), replica.target, session_map);
+    tensorflow::Scope device_scope =
+        session->root()->WithDevice(replica.xrt_device);
     const XrtSession::CachedNode& cached_node =
         GetExecuteNode(session, device_scope, devices[i]);
-    feed_inputs->insert({cached_node.holders[0], computation.get_handle()});
-
-    xrt::XRTExecutionConfig exec_config;
-    exec_config.set_release_input_handles(false);
-    exec_config.set_release_compilation_handle(false);
-    exec_config.set_return_exploded_tuple(explode_tuple);
-    SetupExecConfig(Device(devices[i]), &exec_config);
-
-    feed_inputs->insert(
-        {cached_node.holders[1], exec_config.SerializeAsString()});
+    feed_inputs->insert({cached_node.holders[0], computation_handle});
+    feed_inputs->insert({cached_node.holders[1], replica.exec_config});
     feed_inputs->insert({cached_node.holders[2], inputs});
 
     exec_ops.push_back(cached_node.outputs[0]);
@@ -1551,7 +1516,28 @@ XrtComputationClient::GetReplicationDevices() {
 
 void XrtComputationClient::SetRngSeed(size_t seed) { rng_seed_ = seed; }
 
-std::map<std::string, Metric> XrtComputationClient::GetMetrics() const {
+XrtComputationClient::MetricsSession* XrtComputationClient::GetMetricsSession(
+    const Worker& worker, const std::string& target) const {
+  auto it = metrics_sessions_.find(worker);
+  if (it == metrics_sessions_.end()) {
+    XLA_COUNTER("XrtMetricsSessionCount", 1);
+    tensorflow::SessionOptions session_options;
+    session_options.env = tensorflow::Env::Default();
+    session_options.target = target;
+    session_options.config = session_cache_->GetConfig();
+    std::string cpu0_device =
+        absl::StrCat("/job:", worker.name, "/replica:0/task:", worker.task_no,
+                     "/device:CPU:0");
+    auto metrics_session =
+        absl::make_unique<MetricsSession>(session_options, cpu0_device);
+    XLA_CHECK_OK(metrics_session->root.status());
+    it = metrics_sessions_.emplace(worker, std::move(metrics_session)).first;
+  }
+  return it->second.get();
+}
+
+std::map<std::string, Metric> XrtComputationClient::GetMetrics(
+    const std::vector<std::string>& metrics_regex, bool delta) const {
   static const std::map<std::string, std::string>* metric_remap =
       new std::map<std::string, std::string>{
           {"/tensorflow/xrt/ops/allocate", "XrtAllocate"},
@@ -1578,28 +1564,28 @@ std::map<std::string, Metric> XrtComputationClient::GetMetrics() const {
 
   std::map<std::string, Metric> metrics_data;
   xrt::XRTMetricsCollect metrics;
-  metrics.add_metrics_regex("/tensorflow/xrt/.*");
+  if (metrics_regex.empty()) {
+    metrics.add_metrics_regex("/tensorflow/xrt/.*");
+  }
+  for (auto& regex : metrics_regex) {
+    metrics.add_metrics_regex(regex);
+  }
+  std::string serialized_metrics = metrics.SerializeAsString();
 
+  std::lock_guard<std::mutex> lock(metrics_lock_);
   for (auto& worker_target : options_.workers_map) {
-    tensorflow::SessionOptions session_options;
-    session_options.env = tensorflow::Env::Default();
-    session_options.target = worker_target.second;
-    session_options.config = session_cache_->GetConfig();
-
-    tensorflow::Scope root = tensorflow::Scope::NewRootScope();
-    tensorflow::ClientSession session(root, session_options);
-    std::string cpu0_device = absl::StrCat(
-        "/job:", worker_target.first.name,
-        "/replica:0/task:", worker_target.first.task_no, "/device:CPU:0");
-    tensorflow::Scope cpu_system_scope = root.WithDevice(cpu0_device);
-    auto metrics_value =
-        tensorflow::ops::Const(cpu_system_scope, metrics.SerializeAsString());
-    tensorflow::Output result =
-        tensorflow::ops::XRTMetricsCollect(cpu_system_scope, metrics_value);
-    XLA_CHECK_OK(cpu_system_scope.status());
-
+    MetricsSession* metrics_session =
+        GetMetricsSession(worker_target.first, worker_target.second);
     std::vector<tensorflow::Tensor> outputs;
-    XLA_CHECK_OK(session.Run({result}, &outputs));
+    tensorflow::Status status = metrics_session->session.Run(
+        {{metrics_session->holder, serialized_metrics}},
+        {metrics_session->result}, &outputs);
+    if (!status.ok()) {
+      // The session might be broken (like after a worker restart), so the
+      // next collection creates a new one.
+      metrics_sessions_.erase(worker_target.first);
+      XLA_CHECK_OK(status);
+    }
     XLA_CHECK_EQ(outputs.size(), 1);
 
     xrt::MetricsReport report = ParseProto<xrt::MetricsReport>(outputs[0]);
@@ -1655,6 +1641,22 @@ std::map<std::string, Metric> XrtComputationClient::GetMetrics() const {
       metrics_data.emplace(std::move(metric_name), std::move(metric));
     }
   }
+  if (delta) {
+    // Every metrics selection has its own baseline, so that callers polling
+    // different metrics do not hide each other's changes.
+    std::map<std::string, Metric>& last_metrics =
+        last_delta_metrics_[metrics_regex];
+    std::map<std::string, Metric> changed_metrics;
+    for (auto& name_metric : metrics_data) {
+      auto it = last_metrics.find(name_metric.first);
+      if (it == last_metrics.end() ||
+          !SameMetricValue(it->second, name_metric.second)) {
+        changed_metrics.insert(name_metric);
+      }
+      last_metrics[name_metric.first] = std::move(name_metric.second);
+    }
+    metrics_data = std::move(changed_metrics);
+  }
   return metrics_data;
 }
 
@@ -1689,6 +1691,23 @@ void XrtComputationClient::PrepareToExit() {
   }
 }
 
+void XrtComputationClient::PrewarmSessions() {
+  size_t count = sys_util::GetEnvInt("XRT_SESSION_CACHE_PREWARM", 0);
+  if (count == 0) {
+    return;
+  }
+  std::set<std::string> targets;
+  for (auto& device : options_.devices) {
+    targets.insert(
+        GetWorkerForXrtDevice(TorchDeviceToXrtDevice(device)).second);
+  }
+  for (auto& target : targets) {
+    TF_VLOG(1) << "Prewarming " << count << " XRT sessions for " << target;
+    session_cache_->Prewarm(target, count);
+    alloc_session_cache_->Prewarm(target, count);
+  }
+}
+
 void XrtComputationClient::InitSession(XrtSession* session) const {
   struct InitNode {
     int count;
@@ -1734,8 +1753,11 @@ const XrtSession::CachedNode& XrtComputationClient::GetCompileNode(
     XLA_COUNTER("XrtCompile_Empty", 1);
     std::vector<tensorflow::ops::Placeholder> holders(
         {tensorflow::ops::Placeholder(scope, tensorflow::DT_STRING)});
-    cache->Add(std::make_shared<XrtSession::CachedNode>(
-        tensorflow::ops::XRTCompile(scope, holders[0]).handle, holders));
+    tensorflow::ops::XRTCompile compile(scope, holders[0]);
+    std::vector<tensorflow::Output> outputs(
+        {compile.handle, compile.program_shape});
+    cache->Add(
+        std::make_shared<XrtSession::CachedNode>(std::move(outputs), holders));
   }
   return cache->Get();
 }
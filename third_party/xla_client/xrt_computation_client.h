@@ -19,6 +19,7 @@
 #include "tensorflow/compiler/xla/xla_client/debug_macros.h"
 #include "tensorflow/compiler/xla/xla_client/mesh_service.h"
 #include "tensorflow/compiler/xla/xla_client/metrics.h"
+#include "tensorflow/compiler/xla/xla_client/thread_pool.h"
 #include "tensorflow/compiler/xla/xla_client/triggered_task.h"
 #include "tensorflow/compiler/xla/xla_client/util.h"
 #include "tensorflow/compiler/xla/xla_client/xrt_local_service.h"
@@ -37,6 +38,7 @@ namespace xla {
 class XrtLocker {
  public:
   void Lock() {
+    env::ScopedBlockingWait blocking_wait;
     std::unique_lock<std::mutex> lock(mutex_);
     cv_.wait(lock, [this] { return !locked_; });
     CheckResetException();
@@ -51,6 +53,7 @@ class XrtLocker {
   }
 
   void Barrier() {
+    env::ScopedBlockingWait blocking_wait;
     std::unique_lock<std::mutex> lock(mutex_);
     cv_.wait(lock, [this] { return !locked_; });
     cv_.notify_all();
@@ -174,14 +177,19 @@ class XrtComputationClient : public ComputationClient {
   struct XrtComputation : public Computation {
     XrtComputation(XrtComputationClient* self, XlaComputation computation,
                    ProgramShape program_shape, std::vector<std::string> devices,
-                   int64_t handle, std::string compilation_device)
+                   int64_t handle, std::string compilation_device,
+                   absl::optional<ProgramShape> compiled_program_shape)
         : Computation(std::move(computation), std::move(program_shape),
                       std::move(devices)),
           handle_ptr(std::make_shared<XrtHandle>(
               handle, [self, compilation_device = std::move(
                                  compilation_device)](int64_t handle) {
                 self->ReleaseXrtComputation(compilation_device, handle);
-              })) {}
+              })) {
+      if (compiled_program_shape) {
+        set_compiled_program_shape(std::move(*compiled_program_shape));
+      }
+    }
 
     int64_t get_handle() const { return handle_ptr->handle(); }
 
@@ -296,7 +304,11 @@ class XrtComputationClient : public ComputationClient {
 
   void SetRngSeed(size_t seed) override;
 
-  std::map<std::string, Metric> GetMetrics() const override;
+  using ComputationClient::GetMetrics;
+
+  std::map<std::string, Metric> GetMetrics(
+      const std::vector<std::string>& metrics_regex,
+      bool delta) const override;
 
   MemoryInfo GetMemoryInfo(const std::string& device) override;
 
@@ -335,6 +347,49 @@ class XrtComputationClient : public ComputationClient {
     std::string serialized_computation;
   };
 
+  // The key used to lookup the cached execute plans. The plan data does not
+  // depend on the computation handle, but only on the set of devices and the
+  // execution configuration knobs.
+  struct ExecutePlanKey {
+    struct Hash {
+      size_t operator()(const ExecutePlanKey& entry) const {
+        return util::HashReduce(util::MHash(entry.devices, entry.explode_tuple,
+                                            entry.rng_seed));
+      }
+    };
+
+    ExecutePlanKey(std::vector<std::string> devices, bool explode_tuple,
+                   size_t rng_seed)
+        : devices(std::move(devices)),
+          explode_tuple(explode_tuple),
+          rng_seed(rng_seed) {}
+
+    bool operator==(const ExecutePlanKey& rhs) const {
+      return devices == rhs.devices && explode_tuple == rhs.explode_tuple &&
+             rng_seed == rhs.rng_seed;
+    }
+
+    std::vector<std::string> devices;
+    bool explode_tuple = true;
+    size_t rng_seed = 0;
+  };
+
+  // Holds all the per replica information which is required to feed an
+  // XRTExecute operation, and which does not depend on the data handles.
+  // Re-creating these at every ExecuteReplicated() call costs device string
+  // parsing and protobuf serializations which grow with the number of replicas.
+  struct ExecutePlan {
+    struct Replica {
+      std::string xrt_device;
+      // The session target (worker host:port) serving the replica device.
+      std::string target;
+      // The serialized xrt::XRTExecutionConfig proto for the replica.
+      std::string exec_config;
+    };
+
+    std::vector<Replica> replicas;
+  };
+
   // When we split a batch operation into per-session batches, we use this data
   // structure to collect the per-session work.
   struct SessionWork {
@@ -356,8 +411,20 @@ class XrtComputationClient : public ComputationClient {
 
   const std::string& TorchDeviceToXrtDevice(const std::string& device) const;
 
+  // The rng_seed is passed in by the callers, which read the current seed only
+  // once when they use it for other purposes as well (like a cache key).
   template <typename T>
-  void SetupExecConfig(const Device& device, T* exec_config) const;
+  void SetupExecConfig(const Device& device, size_t rng_seed,
+                       T* exec_config) const;
+
+  // Retrieves the cached execute plan for the given devices, creating one if
+  // missing.
+  std::shared_ptr<ExecutePlan> GetExecutePlan(
+      absl::Span<const std::string> devices, bool explode_tuple);
+
+  // Returns the session targets (worker host:port) for the given devices.
+  std::vector<std::string> GetDevicesTargets(
+      absl::Span<const std::string> devices) const;
 
   std::unique_ptr<xrt::XLAComputation> CreateXrtComputation(
       const XlaComputation& computation, absl::Span<const std::string> devices,
@@ -375,8 +442,8 @@ class XrtComputationClient : public ComputationClient {
 
   std::vector<tensorflow::Output> CreateExecuteOps(
       XrtSessionCache::SessionMap* session_map,
-      const XrtComputation& computation,
-      const std::vector<std::vector<DataPtr>>& arguments, bool explode_tuple,
+      const XrtComputation& computation, const ExecutePlan& plan,
+      const std::vector<std::vector<DataPtr>>& arguments,
       absl::Span<const std::string> devices,
       tensorflow::ClientSession::FeedType* feed_inputs);
 
@@ -385,6 +452,7 @@ class XrtComputationClient : public ComputationClient {
       const std::vector<tensorflow::Output>& exec_ops,
       absl::Span<const Computation* const> computations,
       absl::Span<const std::string> devices,
+      absl::Span<const std::string> targets,
       const tensorflow::ClientSession::FeedType& feed_inputs);
 
   std::vector<DataPtr> TransferToServerHelper(
@@ -444,6 +512,10 @@ class XrtComputationClient : public ComputationClient {
       const tensorflow::Tensor& xrt_result, const Shape& result_shape,
       const std::string& device);
 
+  // Creates XRT_SESSION_CACHE_PREWARM sessions for each local worker target,
+  // with their XRT graph nodes already built.
+  void PrewarmSessions();
+
   void InitSession(XrtSession* session) const;
 
   // Implement the chained execution using the XRTExecuteChained op support.
@@ -603,15 +675,48 @@ class XrtComputationClient : public ComputationClient {
   // Checks whether a local GRPC service is required, and starts it if need it.
   void MaybeCreateLocalService(const Options& options);
 
+  // The session and graph collecting the XRT metrics of a worker. The
+  // serialized xrt::XRTMetricsCollect request is fed to the holder, so the
+  // same graph serves any metrics selection.
+  struct MetricsSession {
+    MetricsSession(const tensorflow::SessionOptions& session_options,
+                   const std::string& device)
+        : root(tensorflow::Scope::NewRootScope()),
+          session(root, session_options),
+          holder(root.WithDevice(device), tensorflow::DT_STRING),
+          result(tensorflow::ops::XRTMetricsCollect(root.WithDevice(device),
+                                                    holder)) {}
+
+    tensorflow::Scope root;
+    tensorflow::ClientSession session;
+    tensorflow::ops::Placeholder holder;
+    tensorflow::Output result;
+  };
+
+  MetricsSession* GetMetricsSession(const Worker& worker,
+                                    const std::string& target) const;
+
   Options options_;
   std::mutex lock_;
   std::map<std::string, std::vector<int>> device_mesh_coords_;
+  // Access to the metrics sessions, and to the metrics returned by the last
+  // delta collection of every metrics selection, must be done while holding
+  // metrics_lock_.
+  mutable std::mutex metrics_lock_;
+  mutable std::map<Worker, std::unique_ptr<MetricsSession>> metrics_sessions_;
+  mutable std::map<std::vector<std::string>, std::map<std::string, Metric>>
+      last_delta_metrics_;
   std::unique_ptr<XrtSessionCache> session_cache_;
   std::unique_ptr<XrtSessionCache> alloc_session_cache_;
   std::unique_ptr<util::TriggeredTask> triggered_task_;
   XrtLocalService* local_service_ = nullptr;
   util::Cache<CompilationCacheKey, Computation, CompilationCacheKey::Hash>
       compilation_cache_;
+  util::Cache<ExecutePlanKey, ExecutePlan, ExecutePlanKey::Hash>
+      execute_plan_cache_;
+  // Maps a device kind (ie, "GPU") to the ordinals of the local devices of such
+  // kind. Used to fill the local_replica_mapping of the execution configs.
+  std::map<std::string, std::vector<int>> local_replica_mapping_;
   std::atomic<size_t> rng_seed_;
   // Access to the following members must be done while holding lock_.
   // XRT thread safety semantics.
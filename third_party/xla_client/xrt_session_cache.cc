@@ -1,27 +1,81 @@
 #include "tensorflow/compiler/xla/xla_client/xrt_session_cache.h"
 
+#include <algorithm>
+#include <exception>
+#include <vector>
+
 #include "tensorflow/compiler/xla/xla_client/metrics.h"
+#include "tensorflow/compiler/xla/xla_client/multi_wait.h"
 #include "tensorflow/compiler/xla/xla_client/sys_util.h"
+#include "tensorflow/compiler/xla/xla_client/thread_pool.h"
 
 namespace xla {
+namespace {
+
+metrics::Metric* SessionCreateMetric() {
+  static metrics::Metric* metric =
+      new metrics::Metric("XrtSessionCreateTime", metrics::MetricFnTime);
+  return metric;
+}
+
+metrics::Metric* SessionWaitMetric() {
+  static metrics::Metric* metric =
+      new metrics::Metric("XrtSessionWaitTime", metrics::MetricFnTime);
+  return metric;
+}
+
+}  // namespace
 
 XrtSessionCache::XrtSessionCache(tensorflow::ConfigProto config,
                                  std::function<void(XrtSession*)> initfn,
                                  std::string local_target)
     : config_(std::move(config)),
       initfn_(std::move(initfn)),
-      local_target_(std::move(local_target)) {}
+      local_target_(std::move(local_target)),
+      max_size_(sys_util::GetEnvInt("XRT_SESSION_CACHE_MAX_SIZE", 0)),
+      wait_timeout_(sys_util::GetEnvInt("XRT_SESSION_CACHE_WAIT_MS", 5000)) {}
 
 XrtSessionCache::Ref XrtSessionCache::GetSession(const std::string& target) {
-  std::lock_guard<std::mutex> lock(lock_);
-  auto& session_queue = session_map_[target];
-  if (!session_queue.empty()) {
-    std::shared_ptr<XrtSession> session = std::move(session_queue.back());
-    session_queue.pop_back();
-    session->Reset();
-    return Ref(this, std::move(session));
+  std::unique_lock<std::mutex> lock(lock_);
+  TargetSessions* target_sessions = &session_map_[target];
+  if (target_sessions->free_sessions.empty() && max_size_ > 0 &&
+      target_sessions->size >= max_size_) {
+    metrics::TimedSection timed(SessionWaitMetric());
+    // The sessions are released by other (possibly queued) closures.
+    env::ScopedBlockingWait blocking_wait;
+    if (!cv_.wait_for(lock, wait_timeout_, [&]() {
+          return !target_sessions->free_sessions.empty() ||
+                 target_sessions->size < max_size_;
+        })) {
+      XLA_COUNTER("XrtSessionCapOverflow", 1);
+    }
   }
-  return Ref(this, CreateSession(target));
+  std::shared_ptr<XrtSession> session;
+  if (!target_sessions->free_sessions.empty()) {
+    session = std::move(target_sessions->free_sessions.back());
+    target_sessions->free_sessions.pop_back();
+  } else {
+    target_sessions->size += 1;
+  }
+  XLA_VALUE_METRIC(
+      "XrtSessionsInUse",
+      target_sessions->size - target_sessions->free_sessions.size());
+  lock.unlock();
+
+  // Sessions are created and reset outside of the lock, so that a slow
+  // session creation does not stall the callers for other targets. If that
+  // fails, the session is dropped, and its slot given back.
+  try {
+    if (session != nullptr) {
+      session->Reset();
+    } else {
+      session = CreateSession(target);
+    }
+  } catch (...) {
+    ReleaseSlots(target, 1);
+    throw;
+  }
+  return Ref(this, std::move(session));
 }
 
 XrtSession* XrtSessionCache::GetSession(const std::string& target,
@@ -34,13 +88,68 @@ XrtSession* XrtSessionCache::GetSession(const std::string& target,
 }
 
 void XrtSessionCache::AddSession(std::shared_ptr<XrtSession> session) {
-  std::lock_guard<std::mutex> lock(lock_);
-  session_map_[session->target()].push_back(std::move(session));
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    session_map_[session->target()].free_sessions.push_back(
+        std::move(session));
+  }
+  cv_.notify_one();
+}
+
+void XrtSessionCache::Prewarm(const std::string& target, size_t count) {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    TargetSessions* target_sessions = &session_map_[target];
+    if (max_size_ > 0) {
+      count = std::min(count, max_size_ - std::min(max_size_,
+                                                   target_sessions->size));
+    }
+    target_sessions->size += count;
+  }
+  std::vector<std::shared_ptr<XrtSession>> sessions(count);
+  auto mwait = std::make_shared<util::MultiWait>(count);
+  for (size_t i = 0; i < count; ++i) {
+    auto create_fn = [&, i]() { sessions[i] = CreateSession(target); };
+    env::ScheduleIoClosure(
+        util::MultiWait::Completer(mwait, std::move(create_fn)));
+  }
+  std::exception_ptr exptr;
+  try {
+    mwait->Wait();
+  } catch (...) {
+    exptr = std::current_exception();
+  }
+  // MultiWait::Wait() returns once all the closures are done, so the failed
+  // creations are the missing sessions, whose slots are given back.
+  size_t failed = 0;
+  for (auto& session : sessions) {
+    if (session != nullptr) {
+      AddSession(std::move(session));
+    } else {
+      ++failed;
+    }
+  }
+  if (failed > 0) {
+    ReleaseSlots(target, failed);
+  }
+  if (exptr != nullptr) {
+    std::rethrow_exception(exptr);
+  }
+}
+
+void XrtSessionCache::ReleaseSlots(const std::string& target, size_t count) {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    session_map_[target].size -= count;
+  }
+  // Waiters for a free session can now create their own.
+  cv_.notify_all();
 }
 
 std::shared_ptr<XrtSession> XrtSessionCache::CreateSession(
     const std::string& target) const {
   XLA_COUNTER("XrtSessionCount", 1);
+  metrics::TimedSection timed(SessionCreateMetric());
   tensorflow::SessionOptions session_options;
   session_options.env = tensorflow::Env::Default();
   session_options.target = target;
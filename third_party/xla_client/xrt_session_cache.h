@@ -1,6 +1,8 @@
 #ifndef XLA_CLIENT_XRT_SESSION_CACHE_H_
 #define XLA_CLIENT_XRT_SESSION_CACHE_H_
 
+#include <chrono>
+#include <condition_variable>
 #include <deque>
 #include <functional>
 #include <map>
@@ -16,6 +18,11 @@ namespace xla {
 
 // Caches XrtSession objects. The XrtSession objects handed out by this class
 // will be at exclusive use of the caller.
+// If XRT_SESSION_CACHE_MAX_SIZE is greater than zero, at most that many
+// sessions are created for every target, and callers finding none free wait
+// for one to be returned. Since a caller can hold many sessions at once, a
+// wait longer than XRT_SESSION_CACHE_WAIT_MS creates a session beyond the cap,
+// instead of risking a deadlock.
 class XrtSessionCache {
  public:
   // A reference to an existing XrtSession. Its destructor will return it to the
@@ -84,14 +91,32 @@ class XrtSessionCache {
 
   void AddSession(std::shared_ptr<XrtSession> session);
 
+  // Creates count sessions for target (in parallel) and adds them to the
+  // cache, so that the first steps do not pay the session and graph creation
+  // cost.
+  void Prewarm(const std::string& target, size_t count);
+
  private:
+  struct TargetSessions {
+    std::deque<std::shared_ptr<XrtSession>> free_sessions;
+    // The number of sessions created for the target, free or in use.
+    size_t size = 0;
+  };
+
   std::shared_ptr<XrtSession> CreateSession(const std::string& target) const;
 
+  // Gives back the slots of count sessions of target, which failed to be
+  // created (or reset).
+  void ReleaseSlots(const std::string& target, size_t count);
+
   tensorflow::ConfigProto config_;
   std::function<void(XrtSession*)> initfn_;
   std::string local_target_;
+  size_t max_size_ = 0;
+  std::chrono::milliseconds wait_timeout_;
   std::mutex lock_;
-  std::map<std::string, std::deque<std::shared_ptr<XrtSession>>> session_map_;
+  std::condition_variable cv_;
+  std::map<std::string, TargetSessions> session_map_;
 };
 
 }  // namespace xla
@@ -322,6 +322,7 @@ def set_replication(device, devices):
     torch_xla._XLAC._xla_set_replication_devices([])
     devctx.device_index = 0
   devctx.all_reduce_token = None
+  devctx.chain_tokens = None
   torch_xla._XLAC._xla_set_default_device(device)
 
 
@@ -468,6 +469,29 @@ def _get_all_reduce_token():
   return token, devctx
 
 
+def _get_per_tensor_dims(tensors, dim):
+  dims = list(dim) if isinstance(dim, (list, tuple)) else [dim] * len(tensors)
+  assert len(dims) == len(tensors), \
+    'The number of dimensions must match the number of tensors'
+  return [d + t.dim() if d < 0 else d for t, d in zip(tensors, dims)]
+
+
+def _get_chain_token(chain):
+  # Named token chains allow collectives which do not need to be ordered with
+  # respect to the main all-reduce chain (like pipeline stage transfers), to be
+  # scheduled by XLA independently from it.
+  devctx = _get_device_context()
+  chain_tokens = getattr(devctx, 'chain_tokens', None)
+  if chain_tokens is None:
+    chain_tokens = dict()
+    devctx.chain_tokens = chain_tokens
+  token = chain_tokens.get(chain, None)
+  if token is None:
+    token = torch_xla._XLAC._xla_create_token(devctx.device)
+    chain_tokens[chain] = token
+  return token, chain_tokens
+
+
 def _torch_all_reduce(reduce_type, inputs, group=None):
   import torch.distributed as dist
 
@@ -586,22 +610,25 @@ def all_gather(value, dim=0, groups=None, output=None):
   """Performs an all-gather operation along a given dimension.
 
   Args:
-    value (torch.Tensor): The input tensor.
-    dim (int): The gather dimension.
+    value (torch.Tensor or list): The input tensor, or a list of tensors. When
+      a list is passed, all the tensors are gathered with a single fused
+      collective operation (one for each tensor type).
+    dim (int or list): The gather dimension. When `value` is a list, this can
+      be a list holding the gather dimension for each tensor.
       Default: 0
     groups (list, optional): A list of list, representing the replica groups for
       the `all_gather()` operation. Example: `[[0, 1, 2, 3], [4, 5, 6, 7]]`
         defines two groups, one with the `[0, 1, 2, 3]` replicas and one with
         the `[4, 5, 6, 7]` replicas. If `None` there will be only one group with
         all the replicas in it.
-    output (torch.Tensor): Optional output tensor.
+    output (torch.Tensor): Optional output tensor. Not supported when `value`
+      is a list.
 
   Returns:
     A tensor which has, in the ``dim`` dimension, all the values from the
-    participating replicas.
+    participating replicas. If `value` is a list, a list with the gathered
+    tensors.
   """
-  if dim < 0:
-    dim = value.dim() + dim
   token, devctx = _get_all_reduce_token()
   if groups:
     shard_count = len(groups[0])
@@ -610,6 +637,16 @@ def all_gather(value, dim=0, groups=None, output=None):
   else:
     # All replicas belong to a single group
     shard_count = xrt_world_size()
+  if not isinstance(value, torch.Tensor):
+    assert output is None, 'Output tensors not supported for tensor lists'
+    dims = _get_per_tensor_dims(value, dim)
+    result = torch_xla._XLAC._xla_all_gather(value, token, dims, shard_count,
+                                             groups or [])
+    devctx.all_reduce_token = result[1]
+    return result[0]
+
+  if dim < 0:
+    dim = value.dim() + dim
   if output != None:
     # Call the out of place version of the all_gather
     new_token = torch_xla._XLAC._xla_all_gather_out(output, value, token, dim,
@@ -654,7 +691,43 @@ def all_to_all(value,
   return result[0]
 
 
-def collective_permute(value, pairs):
+def _host_collective_permute(value, pairs, cctx, token_chain):
+  import torch.distributed as dist
+
+  # The sends of a chain complete before the next permute on the same chain is
+  # issued, like the in graph token chains order them. The sends of different
+  # chains, and the computations issued after them, are free to overlap.
+  devctx = _get_device_context()
+  pending_sends = getattr(devctx, 'host_permute_sends', None)
+  if pending_sends is None:
+    pending_sends = dict()
+    devctx.host_permute_sends = pending_sends
+  for work, _ in pending_sends.pop(token_chain, []):
+    work.wait()
+
+  cpu_value = torch_xla._XLAC._xla_get_cpu_tensors([value])[0]
+  sends = []
+  recv_work = None
+  # Replicas which are not the target of any pair receive zeros, like the in
+  # graph collective permute does.
+  result = torch.zeros_like(cpu_value)
+  for source, target in pairs:
+    if source == cctx.ordinal and target == cctx.ordinal:
+      result = cpu_value.clone()
+    elif source == cctx.ordinal:
+      sends.append((dist.isend(cpu_value, target), cpu_value))
+    elif target == cctx.ordinal:
+      assert recv_work is None, (
+          'Replica {} is the target of multiple pairs: {}'.format(
+              cctx.ordinal, pairs))
+      recv_work = dist.irecv(result, source)
+  pending_sends[token_chain] = sends
+  if recv_work is not None:
+    recv_work.wait()
+  return result.to(value.device)
+
+
+def collective_permute(value, pairs, token_chain=None):
   """Performs a XLA `CollectivePermute()` operation on the input tensor.
 
   WARNING: This function is not very reliable, may produce wrong results under
@@ -669,13 +742,30 @@ def collective_permute(value, pairs):
       operation. Example: `[[0, 1], [1, 2], [2, 0]]` defines three pairs. The
         tensor will be sent from replica 0 to replica 1, replica 1 to replica 2,
         and replica 2 to replica 0.
+    token_chain (string, optional): The name of the token chain used to order
+      the operation. Collectives issued on different chains are not ordered
+      with respect to each other, which lets XLA overlap them with unrelated
+      computations and collectives. If `None`, the default chain shared with
+      all the other collective operations is used.
+      Default: None
 
   Returns:
     The result `torch.Tensor` of the `collective_permute()` operation.
   """
-  token, devctx = _get_all_reduce_token()
-  result = torch_xla._XLAC._xla_collective_permute(value, token, pairs)
-  devctx.all_reduce_token = result[1]
+  cctx = CollectiveContext()
+  if cctx.requires_interhost_reduce and cctx.replica_devcount <= 1:
+    # XLA CPU devices run one per process and have no in graph collectives, so
+    # the permute goes through torch.distributed point to point transfers, with
+    # only the replicas within the pairs exchanging data.
+    return _host_collective_permute(value, pairs, cctx, token_chain)
+  if token_chain is None:
+    token, devctx = _get_all_reduce_token()
+    result = torch_xla._XLAC._xla_collective_permute(value, token, pairs)
+    devctx.all_reduce_token = result[1]
+  else:
+    token, chain_tokens = _get_chain_token(token_chain)
+    result = torch_xla._XLAC._xla_collective_permute(value, token, pairs)
+    chain_tokens[token_chain] = result[1]
   return result[0]
 
 
@@ -694,23 +784,37 @@ def reduce_scatter(reduce_type,
     reduce_type (string): One of ``xm.REDUCE_SUM``, ``xm.REDUCE_MUL``,
       ``xm.REDUCE_AND``, ``xm.REDUCE_OR``, ``xm.REDUCE_MIN`` and
       ``xm.REDUCE_MAX``.
-    input: A single `torch.Tensor` all reduce + scatter op to.
+    input: A single `torch.Tensor` all reduce + scatter op to, or a list of
+      tensors. When a list is passed, all the tensors are reduced with a single
+      fused collective operation (one for each tensor type).
     scale (float): A default scaling value to be applied after the reduce.
-    scatter_dim (int): Dimension number to which apply scatter operation.
+    scatter_dim (int or list): Dimension number to which apply scatter
+      operation. When `input` is a list, this can be a list holding the scatter
+      dimension for each tensor.
     shard_count (int): The number of ways to split up the scatter_dim in.
     groups (list): A list of list, representing the replica groups for
       the `all_reduce()` operation. Example: `[[0, 1, 2, 3], [4, 5, 6, 7]]`
         defines two groups, one with the `[0, 1, 2, 3]` replicas and one with
         the `[4, 5, 6, 7]` replicas. If `None` there will be only one group with
         all the replicas in it.
-    output: Optional output tensor
+    output: Optional output tensor. Not supported when `input` is a list.
 
   Returns:
     A `torch.Tensor` with all the values reduced accross replicas. Each process
     gets a shard split along the `scatter_dim`. All other dimensions are
-    the same as the input.
+    the same as the input. If `input` is a list, a list with the results for
+    each tensor.
   """
   token, devctx = _get_all_reduce_token()
+  if not isinstance(input, torch.Tensor):
+    assert output is None, 'Output tensors not supported for tensor lists'
+    scatter_dims = _get_per_tensor_dims(input, scatter_dim)
+    result = torch_xla._XLAC._xla_reduce_scatter(reduce_type, input, token,
+                                                 scale, scatter_dims,
+                                                 shard_count, groups or [])
+    devctx.all_reduce_token = result[1]
+    return result[0]
+
   if output != None:
     # Call the out of place version of the reduce_scatter
     new_token = torch_xla._XLAC._xla_reduce_scatter_out(reduce_type, output,
@@ -791,6 +895,7 @@ def mark_step():
     ms.save_metrics()
   devctx = _run_step_closures()
   devctx.all_reduce_token = None
+  devctx.chain_tokens = None
 
 
 def wait_device_ops(devices=[]):
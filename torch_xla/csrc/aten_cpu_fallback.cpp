@@ -1,30 +1,254 @@
 #include "torch_xla/csrc/aten_cpu_fallback.h"
 
+#include <ATen/ATen.h>
 #include <tensorflow/compiler/xla/xla_client/debug_macros.h>
 #include <tensorflow/compiler/xla/xla_client/metrics.h>
 #include <tensorflow/compiler/xla/xla_client/tf_logging.h>
+#include <torch/csrc/lazy/core/tensor_util.h>
+#include <torch_xla/csrc/aten_xla_bridge.h>
 #include <torch_xla/csrc/function_call_tracker.h>
+#include <torch_xla/csrc/tensor.h>
+#include <torch_xla/csrc/tensor_util.h>
 
+#include <mutex>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace torch_xla {
+namespace {
 
-static std::unordered_map<std::string, ::xla::metrics::Counter*>
-    _cpu_fallback_counters;
+struct FallbackMetrics {
+  explicit FallbackMetrics(const std::string& name)
+      : counter(name),
+        time_metric(absl::StrCat("CpuFallbackTime.", name),
+                    ::xla::metrics::MetricFnTime) {}
 
-void xla_cpu_fallback(const c10::OperatorHandle& op, torch::jit::Stack* stack) {
-  XLA_FN_TRACK(3);
-  const auto name = c10::toString(op.operator_name());
+  ::xla::metrics::Counter counter;
+  // The host time spent within the fallback, including the copies of the
+  // tensors to and from the device.
+  ::xla::metrics::Metric time_metric;
+};
+
+// Manually applying the XLA_COUNTER and XLA_TIMED macros.
+// We need to do it ourselves and explicitly keep a mapping of metrics because
+// this boxed fallback kernel is used by multiple operators, and the macros
+// stamp out a static object with a fixed name at the code location that they
+// are called.
+// The metrics are keyed by the address of the operator schema, which is stable
+// while the operator is registered. Every thread keeps its own copy of the
+// mapping, so the global one (and its lock) is only used the first time a
+// thread calls the fallback of a given operator, and fallbacks of different
+// operators called in turn do not pay for any name formatting or locking.
+FallbackMetrics* GetFallbackMetrics(const c10::OperatorHandle& op) {
+  static thread_local std::unordered_map<const void*, FallbackMetrics*>
+      thread_metrics;
+  const void* key = &op.schema();
+  auto thread_it = thread_metrics.find(key);
+  if (thread_it != thread_metrics.end()) {
+    return thread_it->second;
+  }
+  static std::mutex* lock = new std::mutex();
+  static auto* fallback_metrics =
+      new std::unordered_map<const void*, FallbackMetrics*>();
+  std::lock_guard<std::mutex> guard(*lock);
+  auto it = fallback_metrics->find(key);
+  if (it == fallback_metrics->end()) {
+    std::string name = c10::toString(op.operator_name());
+    it = fallback_metrics->emplace(key, new FallbackMetrics(name)).first;
+  }
+  thread_metrics.emplace(key, it->second);
+  return it->second;
+}
+
+// The position of an XLA tensor argument on the stack. The list_index is -1
+// for tensor arguments, and the index within the list for tensor list (or
+// optional tensor list, like the indices of index_put) ones.
+struct TensorArgPosition {
+  size_t arg_index;
+  int64_t list_index;
+};
+
+bool IsMutableAlias(const c10::Argument& argument) {
+  const c10::AliasInfo* alias_info = argument.alias_info();
+  return alias_info != nullptr && alias_info->isWrite();
+}
 
-  // Manually applying the XLA_COUNTER macro.
-  // We need to do it ourselves and explicitly keep a mapping of counters
-  // because this boxed fallback kernel is used by multiple operators,
-  // and the macro stamps out a static Counter object with a fixed name
-  // at the code location that it was called.
-  if (_cpu_fallback_counters.find(name) == _cpu_fallback_counters.end()) {
-    _cpu_fallback_counters[name] = new ::xla::metrics::Counter(name);
+// An XLA specific version of at::native::cpu_fallback(), which fetches all the
+// XLA tensor arguments (including the ones within tensor lists) with a single
+// batched device transfer, and uploads all the results, together with the
+// updated values of the mutated arguments, with another single one.
+// Returned mutable aliases of the arguments are replaced by the original XLA
+// arguments, like at::native::cpu_fallback() does.
+void BatchedCpuFallback(const c10::OperatorHandle& op,
+                        torch::jit::Stack* stack) {
+  const auto& schema_args = op.schema().arguments();
+  size_t arguments_begin = stack->size() - schema_args.size();
+  std::vector<c10::IValue> arguments(stack->begin() + arguments_begin,
+                                     stack->end());
+
+  std::vector<at::Tensor> xla_tensors;
+  std::vector<TensorArgPosition> positions;
+  for (size_t i = 0; i < arguments.size(); ++i) {
+    if (arguments[i].isTensor()) {
+      const at::Tensor& tensor = arguments[i].toTensor();
+      if (tensor.defined() && bridge::TryGetXlaTensor(tensor)) {
+        xla_tensors.push_back(tensor);
+        positions.push_back({i, -1});
+      }
+    } else if (arguments[i].isTensorList()) {
+      c10::List<at::Tensor> tensor_list = arguments[i].toTensorList();
+      for (size_t j = 0; j < tensor_list.size(); ++j) {
+        at::Tensor tensor = tensor_list.get(j);
+        if (tensor.defined() && bridge::TryGetXlaTensor(tensor)) {
+          xla_tensors.push_back(std::move(tensor));
+          positions.push_back({i, static_cast<int64_t>(j)});
+        }
+      }
+    } else if (arguments[i].isList()) {
+      // Tensor?[] arguments are generic lists of tensors and Nones.
+      c10::List<c10::IValue> list = arguments[i].toList();
+      for (size_t j = 0; j < list.size(); ++j) {
+        c10::IValue element = list.get(j);
+        if (!element.isTensor()) {
+          continue;
+        }
+        const at::Tensor& tensor = element.toTensor();
+        if (tensor.defined() && bridge::TryGetXlaTensor(tensor)) {
+          xla_tensors.push_back(tensor);
+          positions.push_back({i, static_cast<int64_t>(j)});
+        }
+      }
+    }
+  }
+  if (xla_tensors.empty()) {
+    // Without XLA tensor arguments there is nothing to batch, nor a device to
+    // move the results to.
+    at::native::cpu_fallback(op, stack);
+    return;
+  }
+  Device device = bridge::GetXlaTensor(xla_tensors.front()).GetDevice();
+
+  std::vector<at::Tensor> cpu_tensors =
+      bridge::XlaCreateTensorList(xla_tensors);
+  std::vector<c10::List<at::Tensor>> cpu_lists(arguments.size());
+  std::vector<c10::List<c10::IValue>> cpu_generic_lists(arguments.size());
+  for (size_t i = 0; i < positions.size(); ++i) {
+    const TensorArgPosition& position = positions[i];
+    const c10::IValue& argument = arguments[position.arg_index];
+    if (position.list_index < 0) {
+      (*stack)[arguments_begin + position.arg_index] =
+          c10::IValue(cpu_tensors[i]);
+    } else if (argument.isTensorList()) {
+      c10::List<at::Tensor>& cpu_list = cpu_lists[position.arg_index];
+      if (cpu_list.empty()) {
+        cpu_list = argument.toTensorList().copy();
+      }
+      cpu_list.set(position.list_index, cpu_tensors[i]);
+    } else {
+      c10::List<c10::IValue>& cpu_list = cpu_generic_lists[position.arg_index];
+      if (cpu_list.empty()) {
+        cpu_list = argument.toList().copy();
+      }
+      cpu_list.set(position.list_index, c10::IValue(cpu_tensors[i]));
+    }
+  }
+  for (size_t i = 0; i < cpu_lists.size(); ++i) {
+    if (!cpu_lists[i].empty()) {
+      (*stack)[arguments_begin + i] = c10::IValue(cpu_lists[i]);
+    } else if (!cpu_generic_lists[i].empty()) {
+      (*stack)[arguments_begin + i] = c10::IValue(cpu_generic_lists[i]);
+    }
   }
-  _cpu_fallback_counters[name]->AddValue(1);
+
+  op.redispatchBoxed(c10::DispatchKeySet(c10::DispatchKey::CPU), stack);
+
+  // Collect the tensors to be uploaded: the updated values of the mutated
+  // arguments first, and then the returned tensors which do not alias them.
+  std::vector<at::Tensor> upload_tensors;
+  std::vector<at::Tensor> mutated_tensors;
+  for (size_t i = 0; i < positions.size(); ++i) {
+    if (IsMutableAlias(schema_args[positions[i].arg_index])) {
+      upload_tensors.push_back(torch::lazy::CopyTensor(
+          cpu_tensors[i], xla_tensors[i].scalar_type(), /*copy=*/false));
+      mutated_tensors.push_back(xla_tensors[i]);
+    }
+  }
+  const auto& schema_returns = op.schema().returns();
+  size_t returns_begin = stack->size() - schema_returns.size();
+  std::vector<bool> upload_returns(schema_returns.size(), false);
+  for (size_t i = 0; i < schema_returns.size(); ++i) {
+    c10::IValue& stack_return = (*stack)[returns_begin + i];
+    if (stack_return.isTensor()) {
+      if (!stack_return.toTensor().defined()) {
+        continue;
+      }
+      if (IsMutableAlias(schema_returns[i])) {
+        const c10::AliasInfo* alias_info = schema_returns[i].alias_info();
+        bool found_alias = false;
+        for (size_t j = 0; j < schema_args.size() && !found_alias; ++j) {
+          const c10::AliasInfo* arg_alias_info = schema_args[j].alias_info();
+          if (arg_alias_info != nullptr && *arg_alias_info == *alias_info) {
+            stack_return = arguments[j];
+            found_alias = true;
+          }
+        }
+        XLA_CHECK(found_alias) << "Unable to find the argument aliased by the "
+                               << "return " << i << " of " << op.schema();
+        continue;
+      }
+      upload_tensors.push_back(stack_return.toTensor());
+      upload_returns[i] = true;
+    } else if (stack_return.isTensorList()) {
+      // Undefined tensors within the returned lists are kept as they are.
+      for (const at::Tensor& tensor : stack_return.toTensorList().vec()) {
+        if (tensor.defined()) {
+          upload_tensors.push_back(tensor);
+        }
+      }
+      upload_returns[i] = true;
+    }
+  }
+
+  std::vector<std::string> devices(upload_tensors.size(), device.ToString());
+  std::vector<xla::ComputationClient::DataPtr> uploaded_data =
+      CreateTensorsData(upload_tensors, devices);
+  size_t data_index = 0;
+  auto next_tensor = [&](at::ScalarType scalar_type) {
+    XLATensor xtensor =
+        XLATensor::Create(uploaded_data[data_index++], scalar_type);
+    return bridge::AtenFromXlaTensor(std::move(xtensor));
+  };
+  for (auto& tensor : mutated_tensors) {
+    at::_copy_from_and_resize(next_tensor(tensor.scalar_type()), tensor);
+  }
+  for (size_t i = 0; i < schema_returns.size(); ++i) {
+    c10::IValue& stack_return = (*stack)[returns_begin + i];
+    if (!upload_returns[i]) {
+      continue;
+    }
+    if (stack_return.isTensor()) {
+      stack_return =
+          c10::IValue(next_tensor(stack_return.toTensor().scalar_type()));
+    } else {
+      c10::List<at::Tensor> tensor_list;
+      for (const at::Tensor& tensor : stack_return.toTensorList().vec()) {
+        tensor_list.push_back(
+            tensor.defined() ? next_tensor(tensor.scalar_type()) : tensor);
+      }
+      stack_return = c10::IValue(tensor_list);
+    }
+  }
+  XLA_CHECK_EQ(data_index, uploaded_data.size());
+}
+
+}  // namespace
+
+void xla_cpu_fallback(const c10::OperatorHandle& op, torch::jit::Stack* stack) {
+  XLA_FN_TRACK(3);
+  FallbackMetrics* metrics = GetFallbackMetrics(op);
+  metrics->counter.AddValue(1);
+  ::xla::metrics::TimedSection timed(&metrics->time_metric);
 
   auto& args = op.schema().arguments();
   auto arguments = torch::jit::last(stack, args.size());
@@ -38,7 +262,7 @@ void xla_cpu_fallback(const c10::OperatorHandle& op, torch::jit::Stack* stack) {
   }
 
   // Call the actual boxed CPU fallback.
-  at::native::cpu_fallback(op, stack);
+  BatchedCpuFallback(op, stack);
 }
 
 TORCH_LIBRARY_IMPL(_, XLA, m) {
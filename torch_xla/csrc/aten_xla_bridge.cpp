@@ -2,6 +2,7 @@
 
 #include <map>
 #include <string>
+#include <typeinfo>
 #include <vector>
 
 #include "absl/strings/str_cat.h"
@@ -47,7 +48,15 @@ AtenXlaDeviceMapper* AtenXlaDeviceMapper::Get() {
 }
 
 XLATensorImpl* GetXlaTensorImpl(const at::Tensor& tensor) {
-  return dynamic_cast<XLATensorImpl*>(tensor.unsafeGetTensorImpl());
+  // This sits on the path of every XLA operation, so the dispatch key is used
+  // to cheaply reject the non XLA tensors. Wrapper impls (like the batched
+  // ones) carry the XLA key as well, hence the exact type check.
+  c10::TensorImpl* impl = tensor.unsafeGetTensorImpl();
+  if (impl == nullptr || !impl->key_set().has(c10::DispatchKey::XLA) ||
+      typeid(*impl) != typeid(XLATensorImpl)) {
+    return nullptr;
+  }
+  return static_cast<XLATensorImpl*>(impl);
 }
 
 }  // namespace
@@ -72,8 +81,7 @@ XLATensor GetXlaTensor(const at::Tensor& tensor) {
 }
 
 void ReplaceXlaTensor(const at::Tensor& tensor, XLATensor new_xla_tensor) {
-  XLATensorImpl* impl =
-      dynamic_cast<XLATensorImpl*>(tensor.unsafeGetTensorImpl());
+  XLATensorImpl* impl = GetXlaTensorImpl(tensor);
   XLA_CHECK(impl != nullptr)
       << "Input tensor is not an XLA tensor: " << tensor.toString();
   impl->set_tensor(std::move(new_xla_tensor));
@@ -0,0 +1,545 @@
+#include "torch_xla/csrc/checkpoint_io.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <numeric>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/compiler/xla/xla_client/computation_client.h"
+#include "tensorflow/compiler/xla/xla_client/debug_macros.h"
+#include "tensorflow/compiler/xla/xla_client/metrics.h"
+#include "tensorflow/compiler/xla/xla_client/thread_pool.h"
+#include "tensorflow/compiler/xla/xla_client/util.h"
+#include "tensorflow/core/platform/env.h"
+#include "torch_xla/csrc/aten_xla_bridge.h"
+#include "torch_xla/csrc/tensor.h"
+#include "torch_xla/csrc/tensor_util.h"
+
+namespace torch_xla {
+namespace {
+
+// The file starts with the magic (whose last two characters are the format
+// version), followed by the number of tensors and the offset of the first data
+// blob. Then, for every tensor, its type code (see kTypeCodes), rank, sizes,
+// and the offset and size of its data blob. All the header values are stored
+// as little endian 64 bit integers, and the tensor data in little endian
+// order.
+constexpr char kMagic[8] = {'X', 'L', 'A', 'T', 'S', 'R', '0', '2'};
+constexpr size_t kVersionSize = 2;
+constexpr int64_t kAlignment = 64;
+constexpr int64_t kPrefixSize = sizeof(kMagic) + 2 * sizeof(int64_t);
+
+// The codes used to store the tensor types within the files. They must never
+// change, unlike the at::ScalarType values.
+struct TypeCode {
+  at::ScalarType type;
+  int64_t code;
+};
+
+constexpr TypeCode kTypeCodes[] = {
+    {at::ScalarType::Bool, 1},
+    {at::ScalarType::Byte, 2},
+    {at::ScalarType::Char, 3},
+    {at::ScalarType::Short, 4},
+    {at::ScalarType::Int, 5},
+    {at::ScalarType::Long, 6},
+    {at::ScalarType::Half, 7},
+    {at::ScalarType::BFloat16, 8},
+    {at::ScalarType::Float, 9},
+    {at::ScalarType::Double, 10},
+    {at::ScalarType::ComplexFloat, 11},
+    {at::ScalarType::ComplexDouble, 12},
+};
+
+int64_t TypeToCode(at::ScalarType type) {
+  for (auto& type_code : kTypeCodes) {
+    if (type_code.type == type) {
+      return type_code.code;
+    }
+  }
+  XLA_ERROR() << "Tensor type not supported by the tensors file format: "
+              << type;
+}
+
+at::ScalarType CodeToType(int64_t code, const std::string& path) {
+  for (auto& type_code : kTypeCodes) {
+    if (type_code.code == code) {
+      return type_code.type;
+    }
+  }
+  XLA_ERROR() << "Unknown tensor type code " << code << " in " << path;
+}
+
+// The tensor data blobs are the raw host tensor memory.
+void CheckLittleEndianHost() {
+  const uint16_t value = 1;
+  XLA_CHECK_EQ(*reinterpret_cast<const uint8_t*>(&value), 1)
+      << "Tensors files can only be used on little endian hosts";
+}
+
+struct TensorEntry {
+  at::ScalarType type;
+  std::vector<int64_t> sizes;
+  int64_t offset = 0;
+  int64_t nbytes = 0;
+};
+
+int64_t AlignOffset(int64_t offset) {
+  return (offset + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+void AppendValue(int64_t value, std::string* data) {
+  uint64_t uvalue = static_cast<uint64_t>(value);
+  for (size_t i = 0; i < sizeof(uvalue); ++i, uvalue >>= 8) {
+    data->push_back(static_cast<char>(uvalue & 0xff));
+  }
+}
+
+// Assigns the data offsets to the entries, and returns the serialized header,
+// padded up to the offset of the first data blob.
+std::string CreateHeader(std::vector<TensorEntry>* entries) {
+  int64_t header_size = kPrefixSize;
+  for (auto& entry : *entries) {
+    header_size += (4 + entry.sizes.size()) * sizeof(int64_t);
+  }
+  int64_t offset = AlignOffset(header_size);
+  std::string header(kMagic, sizeof(kMagic));
+  AppendValue(entries->size(), &header);
+  AppendValue(offset, &header);
+  for (auto& entry : *entries) {
+    entry.offset = offset;
+    offset = AlignOffset(offset + entry.nbytes);
+    AppendValue(TypeToCode(entry.type), &header);
+    AppendValue(entry.sizes.size(), &header);
+    for (auto size : entry.sizes) {
+      AppendValue(size, &header);
+    }
+    AppendValue(entry.offset, &header);
+    AppendValue(entry.nbytes, &header);
+  }
+  header.resize(AlignOffset(header_size), 0);
+  return header;
+}
+
+void ReadFully(tensorflow::RandomAccessFile* file, int64_t offset, size_t size,
+               char* buffer) {
+  tensorflow::StringPiece result;
+  XLA_CHECK_OK(file->Read(offset, size, &result, buffer));
+  XLA_CHECK_EQ(result.size(), size);
+  // Some file systems return pointers to their own memory.
+  if (result.data() != buffer) {
+    std::memcpy(buffer, result.data(), size);
+  }
+}
+
+class HeaderParser {
+ public:
+  HeaderParser(const char* data, size_t size, const std::string& path)
+      : data_(data), size_(size), path_(path) {
+    XLA_CHECK_GE(size_, sizeof(kMagic)) << "Not a tensors file: " << path_;
+    size_t prefix_size = sizeof(kMagic) - kVersionSize;
+    XLA_CHECK_EQ(std::memcmp(data_, kMagic, prefix_size), 0)
+        << "Not a tensors file: " << path_;
+    XLA_CHECK_EQ(std::memcmp(data_ + prefix_size, kMagic + prefix_size,
+                             kVersionSize),
+                 0)
+        << "Unsupported tensors file version '"
+        << std::string(data_ + prefix_size, kVersionSize) << "' in " << path_;
+    position_ = sizeof(kMagic);
+  }
+
+  int64_t Next() {
+    XLA_CHECK_LE(position_ + sizeof(int64_t), size_)
+        << "Truncated tensors header in " << path_;
+    const uint8_t* bytes =
+        reinterpret_cast<const uint8_t*>(data_ + position_);
+    uint64_t value = 0;
+    for (size_t i = sizeof(value); i > 0; --i) {
+      value = (value << 8) | bytes[i - 1];
+    }
+    position_ += sizeof(value);
+    return static_cast<int64_t>(value);
+  }
+
+ private:
+  const char* data_;
+  size_t size_;
+  const std::string& path_;
+  size_t position_;
+};
+
+// Parses the header held by data, which must include at least all the bytes up
+// to the offset of the first data blob.
+std::vector<TensorEntry> ParseHeader(const char* data, size_t size,
+                                     const std::string& path) {
+  CheckLittleEndianHost();
+  HeaderParser parser(data, size, path);
+  int64_t num_tensors = parser.Next();
+  int64_t data_offset = parser.Next();
+  XLA_CHECK_LE(data_offset, size) << "Truncated tensors header in " << path;
+  std::vector<TensorEntry> entries(num_tensors);
+  for (auto& entry : entries) {
+    entry.type = CodeToType(parser.Next(), path);
+    entry.sizes.resize(parser.Next());
+    for (auto& size : entry.sizes) {
+      size = parser.Next();
+    }
+    entry.offset = parser.Next();
+    entry.nbytes = parser.Next();
+    XLA_CHECK_EQ(entry.nbytes, xla::util::Multiply<int64_t>(entry.sizes) *
+                                   c10::elementSize(entry.type))
+        << "Corrupted tensors header in " << path;
+  }
+  return entries;
+}
+
+std::vector<TensorEntry> ReadHeader(tensorflow::RandomAccessFile* file,
+                                    const std::string& path) {
+  std::string prefix(kPrefixSize, 0);
+  ReadFully(file, 0, prefix.size(), &prefix[0]);
+  HeaderParser parser(prefix.data(), prefix.size(), path);
+  parser.Next();
+  int64_t data_offset = parser.Next();
+  XLA_CHECK_GE(data_offset, kPrefixSize);
+
+  std::string header(data_offset, 0);
+  ReadFully(file, 0, header.size(), &header[0]);
+  return ParseHeader(header.data(), header.size(), path);
+}
+
+// Splits the entries into groups of consecutive tensors, whose data size is
+// at most group_bytes (unless a single tensor is bigger than that).
+std::vector<std::vector<size_t>> SplitGroups(
+    const std::vector<TensorEntry>& entries, int64_t group_bytes) {
+  std::vector<std::vector<size_t>> groups;
+  int64_t current_bytes = 0;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    if (groups.empty() ||
+        (!groups.back().empty() &&
+         current_bytes + entries[i].nbytes > group_bytes)) {
+      groups.emplace_back();
+      current_bytes = 0;
+    }
+    groups.back().push_back(i);
+    current_bytes += entries[i].nbytes;
+  }
+  return groups;
+}
+
+struct SaveState {
+  std::unique_ptr<tensorflow::WritableFile> file;
+  std::vector<TensorEntry> entries;
+  // For every tensor, either the CPU tensor or the device data to be saved.
+  std::vector<at::Tensor> cpu_tensors;
+  std::vector<xla::ComputationClient::DataPtr> handles;
+  // The current end of the file. Only accessed by the writes, which are
+  // serialized.
+  int64_t position = 0;
+};
+
+struct SaveGroup {
+  std::vector<size_t> indices;
+  std::vector<xla::Literal> literals;
+  std::vector<at::Tensor> tensors;
+};
+
+void FetchGroup(const SaveState& state, SaveGroup* group) {
+  XLA_TIMED("CheckpointSaveFetch");
+  std::vector<xla::ComputationClient::DataPtr> handles;
+  for (auto index : group->indices) {
+    if (state.handles[index] != nullptr) {
+      handles.push_back(state.handles[index]);
+    }
+  }
+  if (!handles.empty()) {
+    group->literals =
+        xla::ComputationClient::Get()->TransferFromServer(handles);
+  }
+}
+
+void ConvertGroup(const SaveState& state, SaveGroup* group) {
+  XLA_TIMED("CheckpointSaveConvert");
+  size_t literal_index = 0;
+  for (auto index : group->indices) {
+    const TensorEntry& entry = state.entries[index];
+    at::Tensor tensor;
+    if (state.handles[index] != nullptr) {
+      tensor = MakeTensorFromXlaLiteral(group->literals[literal_index++],
+                                        entry.type);
+    } else {
+      tensor = state.cpu_tensors[index].contiguous();
+    }
+    group->tensors.push_back(std::move(tensor));
+  }
+  // Release the literals memory as soon as the tensors are created.
+  group->literals.clear();
+}
+
+void WriteGroup(SaveState* state, SaveGroup* group) {
+  XLA_TIMED("CheckpointSaveWrite");
+  static const char kPadding[kAlignment] = {};
+  for (size_t i = 0; i < group->indices.size(); ++i) {
+    const TensorEntry& entry = state->entries[group->indices[i]];
+    const at::Tensor& tensor = group->tensors[i];
+    XLA_CHECK_EQ(tensor.numel() * tensor.element_size(), entry.nbytes);
+    XLA_CHECK_LE(entry.offset - state->position, kAlignment);
+    XLA_CHECK_OK(state->file->Append(
+        tensorflow::StringPiece(kPadding, entry.offset - state->position)));
+    XLA_CHECK_OK(state->file->Append(tensorflow::StringPiece(
+        static_cast<const char*>(tensor.data_ptr()), entry.nbytes)));
+    state->position = entry.offset + entry.nbytes;
+  }
+  // Drop the host tensors, to bound the memory held by the pipeline.
+  group->tensors.clear();
+}
+
+std::vector<at::Tensor> ReadGroup(tensorflow::RandomAccessFile* file,
+                                  const std::vector<TensorEntry>& entries,
+                                  const std::vector<size_t>& indices) {
+  XLA_TIMED("CheckpointLoadRead");
+  std::vector<at::Tensor> tensors;
+  for (auto index : indices) {
+    const TensorEntry& entry = entries[index];
+    at::Tensor tensor = at::empty(entry.sizes, at::TensorOptions(entry.type));
+    if (entry.nbytes > 0) {
+      ReadFully(file, entry.offset, entry.nbytes,
+                static_cast<char*>(tensor.data_ptr()));
+    }
+    tensors.push_back(std::move(tensor));
+  }
+  return tensors;
+}
+
+std::vector<size_t> AllIndices(size_t count) {
+  std::vector<size_t> indices(count);
+  std::iota(indices.begin(), indices.end(), 0);
+  return indices;
+}
+
+void UploadGroup(const std::vector<at::Tensor>& host_tensors,
+                 const Device& device, std::vector<at::Tensor>* tensors) {
+  XLA_TIMED("CheckpointLoadUpload");
+  std::vector<std::string> devices(host_tensors.size(), device.ToString());
+  std::vector<xla::ComputationClient::DataPtr> handles =
+      CreateTensorsData(host_tensors, devices);
+  for (size_t i = 0; i < handles.size(); ++i) {
+    tensors->push_back(bridge::AtenFromXlaTensor(XLATensor::Create(
+        std::move(handles[i]), host_tensors[i].scalar_type())));
+  }
+}
+
+// A private, copy-on-write mapping of a whole file. Until written, its pages
+// are the ones of the page cache, shared with all the other processes mapping
+// or reading the same file.
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    XLA_CHECK_GE(fd, 0) << "Unable to open " << path << ": "
+                        << std::strerror(errno);
+    struct stat st;
+    int rc = fstat(fd, &st);
+    if (rc == 0 && st.st_size > 0) {
+      size_ = st.st_size;
+      data_ = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd,
+                   /*offset=*/0);
+    }
+    int error = errno;
+    close(fd);
+    XLA_CHECK_EQ(rc, 0) << "Unable to stat " << path << ": "
+                        << std::strerror(error);
+    XLA_CHECK_GT(size_, 0) << "Not a tensors file: " << path;
+    XLA_CHECK_NE(data_, MAP_FAILED) << "Unable to map " << path << ": "
+                                    << std::strerror(error);
+    // The tensors are consumed front to back, so let the kernel read ahead
+    // aggressively.
+    madvise(data_, size_, MADV_SEQUENTIAL);
+  }
+
+  ~MappedFile() { munmap(data_, size_); }
+
+  char* data() const { return static_cast<char*>(data_); }
+
+  size_t size() const { return size_; }
+
+  // Asks the kernel to start reading the given range into the page cache,
+  // without waiting for it.
+  void Prefetch(int64_t offset, int64_t size) const {
+    static const int64_t page_size = sysconf(_SC_PAGESIZE);
+    int64_t start = offset / page_size * page_size;
+    madvise(data() + start, offset + size - start, MADV_WILLNEED);
+  }
+
+ private:
+  void* data_ = MAP_FAILED;
+  size_t size_ = 0;
+};
+
+std::vector<at::Tensor> MapGroup(const std::shared_ptr<MappedFile>& mapping,
+                                 const std::vector<TensorEntry>& entries,
+                                 const std::vector<size_t>& indices) {
+  std::vector<at::Tensor> tensors;
+  for (auto index : indices) {
+    const TensorEntry& entry = entries[index];
+    // Every tensor keeps the mapping alive.
+    tensors.push_back(at::from_blob(
+        mapping->data() + entry.offset, entry.sizes,
+        [mapping](void*) {}, at::TensorOptions(entry.type)));
+  }
+  return tensors;
+}
+
+std::vector<at::Tensor> LoadMappedTensors(const std::string& path,
+                                          const c10::optional<Device>& device,
+                                          int64_t group_bytes) {
+  auto mapping = std::make_shared<MappedFile>(path);
+  std::vector<TensorEntry> entries =
+      ParseHeader(mapping->data(), mapping->size(), path);
+  for (auto& entry : entries) {
+    XLA_CHECK_LE(entry.offset + entry.nbytes, mapping->size())
+        << "Truncated tensors file " << path;
+  }
+  if (!device) {
+    return MapGroup(mapping, entries, AllIndices(entries.size()));
+  }
+
+  // While a group is uploaded, the pages of the next one are brought into the
+  // page cache by the kernel.
+  std::vector<std::vector<size_t>> groups = SplitGroups(entries, group_bytes);
+  std::vector<at::Tensor> tensors;
+  tensors.reserve(entries.size());
+  for (size_t i = 0; i < groups.size(); ++i) {
+    if (i + 1 < groups.size()) {
+      const TensorEntry& first = entries[groups[i + 1].front()];
+      const TensorEntry& last = entries[groups[i + 1].back()];
+      mapping->Prefetch(first.offset, last.offset + last.nbytes - first.offset);
+    }
+    UploadGroup(MapGroup(mapping, entries, groups[i]), *device, &tensors);
+  }
+  return tensors;
+}
+
+}  // namespace
+
+void SaveTensorsStreaming(const std::vector<at::Tensor>& tensors,
+                          const std::string& path, int64_t group_bytes) {
+  CheckLittleEndianHost();
+  auto state = std::make_shared<SaveState>();
+  for (auto& tensor : tensors) {
+    XLA_CHECK(tensor.defined()) << "Cannot save undefined tensors";
+    TensorEntry entry;
+    auto xtensor = bridge::TryGetXlaTensor(tensor);
+    if (xtensor) {
+      entry.type = xtensor->dtype();
+      entry.sizes =
+          xla::util::ToVector<int64_t>(xtensor->shape().get().dimensions());
+      state->handles.push_back(xtensor->GetXlaData());
+      state->cpu_tensors.emplace_back();
+    } else {
+      entry.type = tensor.scalar_type();
+      entry.sizes = xla::util::ToVector<int64_t>(tensor.sizes());
+      state->handles.push_back(nullptr);
+      state->cpu_tensors.push_back(tensor);
+    }
+    entry.nbytes = xla::util::Multiply<int64_t>(entry.sizes) *
+                   c10::elementSize(entry.type);
+    state->entries.push_back(std::move(entry));
+  }
+  std::string header = CreateHeader(&state->entries);
+  XLA_CHECK_OK(
+      tensorflow::Env::Default()->NewWritableFile(path, &state->file));
+  XLA_CHECK_OK(state->file->Append(header));
+  state->position = header.size();
+
+  // While the caller thread fetches a group from the devices, the previous one
+  // is converted to host tensors on the thread pool, and the one before that
+  // is written on the IO thread pool. Each stage holds at most one group.
+  std::unique_ptr<xla::env::Completion> convert_done;
+  std::unique_ptr<xla::env::Completion> write_done;
+  std::shared_ptr<SaveGroup> converting;
+  for (auto& indices : SplitGroups(state->entries, group_bytes)) {
+    auto group = std::make_shared<SaveGroup>();
+    group->indices = std::move(indices);
+    FetchGroup(*state, group.get());
+    if (convert_done != nullptr) {
+      convert_done->Wait();
+      if (write_done != nullptr) {
+        write_done->Wait();
+      }
+      write_done = absl::make_unique<xla::env::Completion>(
+          xla::env::ScheduleIoClosureWithCompletion([state, converting]() {
+            WriteGroup(state.get(), converting.get());
+          }));
+    }
+    converting = group;
+    convert_done = absl::make_unique<xla::env::Completion>(
+        xla::env::ScheduleClosureWithCompletion(
+            [state, group]() { ConvertGroup(*state, group.get()); }));
+  }
+  if (convert_done != nullptr) {
+    convert_done->Wait();
+    if (write_done != nullptr) {
+      write_done->Wait();
+    }
+    WriteGroup(state.get(), converting.get());
+  }
+  XLA_CHECK_OK(state->file->Close());
+}
+
+std::vector<at::Tensor> LoadTensorsStreaming(
+    const std::string& path, const c10::optional<Device>& device,
+    int64_t group_bytes, bool use_mmap) {
+  if (use_mmap) {
+    return LoadMappedTensors(path, device, group_bytes);
+  }
+  std::shared_ptr<tensorflow::RandomAccessFile> file;
+  {
+    std::unique_ptr<tensorflow::RandomAccessFile> tf_file;
+    XLA_CHECK_OK(
+        tensorflow::Env::Default()->NewRandomAccessFile(path, &tf_file));
+    file = std::move(tf_file);
+  }
+  auto entries =
+      std::make_shared<std::vector<TensorEntry>>(ReadHeader(file.get(), path));
+  if (!device) {
+    return ReadGroup(file.get(), *entries, AllIndices(entries->size()));
+  }
+
+  // The read of the next group, on the IO thread pool, overlaps with the upload
+  // of the current one.
+  auto groups = std::make_shared<std::vector<std::vector<size_t>>>(
+      SplitGroups(*entries, group_bytes));
+  auto schedule_read = [&](size_t group_index) {
+    auto host_tensors = std::make_shared<std::vector<at::Tensor>>();
+    auto completion = absl::make_unique<xla::env::Completion>(
+        xla::env::ScheduleIoClosureWithCompletion(
+            [file, entries, groups, group_index, host_tensors]() {
+              *host_tensors =
+                  ReadGroup(file.get(), *entries, (*groups)[group_index]);
+            }));
+    return std::make_pair(std::move(completion), host_tensors);
+  };
+  std::vector<at::Tensor> tensors;
+  tensors.reserve(entries->size());
+  if (groups->empty()) {
+    return tensors;
+  }
+  auto pending_read = schedule_read(0);
+  for (size_t i = 0; i < groups->size(); ++i) {
+    pending_read.first->Wait();
+    std::vector<at::Tensor> host_tensors = std::move(*pending_read.second);
+    if (i + 1 < groups->size()) {
+      pending_read = schedule_read(i + 1);
+    }
+    UploadGroup(host_tensors, *device, &tensors);
+  }
+  return tensors;
+}
+
+}  // namespace torch_xla
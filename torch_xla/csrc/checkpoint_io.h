@@ -0,0 +1,40 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+#include <c10/util/Optional.h>
+
+#include <string>
+#include <vector>
+
+#include "torch_xla/csrc/device.h"
+
+namespace torch_xla {
+
+// Writes the tensors into a single file at path, which can be on any file
+// system supported by the TF Env. The file holds a header with the type and
+// shape of every tensor, followed by the raw tensor data, each blob aligned to
+// 64 bytes.
+// The XLA tensors are fetched from their devices in groups of at most
+// group_bytes, and the device fetch of a group, its conversion to host tensors
+// and the file write of the previous group run concurrently. The host memory
+// used is bounded by a few groups, instead of by the total size of the tensors.
+// XLA tensors holding pending IR graphs are synced one by one, so callers
+// should sync them all together before calling this API.
+void SaveTensorsStreaming(const std::vector<at::Tensor>& tensors,
+                          const std::string& path, int64_t group_bytes);
+
+// Loads the tensors written by SaveTensorsStreaming(). If device is specified,
+// the tensors are read in groups of at most group_bytes, and each group is
+// uploaded to the device while the next one is being read. Otherwise the CPU
+// tensors are returned.
+// If use_mmap is true, path must be on a local file system, and the file is
+// mapped in memory instead of being read. The returned CPU tensors then point
+// straight into the copy-on-write mapping, so processes loading the same file
+// share its pages through the page cache, and no data is read until the
+// tensors are accessed. The device uploads copy the mapped pages straight
+// into the transfer buffers.
+std::vector<at::Tensor> LoadTensorsStreaming(
+    const std::string& path, const c10::optional<Device>& device,
+    int64_t group_bytes, bool use_mmap = false);
+
+}  // namespace torch_xla
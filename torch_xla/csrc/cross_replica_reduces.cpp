@@ -82,6 +82,44 @@ std::vector<xla::ReplicaGroup> CreateReduceGroups(
   return reduce_groups;
 }
 
+// Transposes the dim dimension of input to be the major one.
+xla::XlaOp MoveDimToFront(xla::XlaOp input, int64_t dim) {
+  if (dim == 0) {
+    return input;
+  }
+  int64_t rank = XlaHelpers::ShapeOfXlaOp(input).rank();
+  std::vector<int64_t> permutation({dim});
+  for (int64_t i = 0; i < rank; ++i) {
+    if (i != dim) {
+      permutation.push_back(i);
+    }
+  }
+  return xla::Transpose(input, permutation);
+}
+
+// Inverse of MoveDimToFront().
+xla::XlaOp MoveFrontToDim(xla::XlaOp input, int64_t dim) {
+  if (dim == 0) {
+    return input;
+  }
+  int64_t rank = XlaHelpers::ShapeOfXlaOp(input).rank();
+  std::vector<int64_t> permutation;
+  for (int64_t i = 1; i <= dim; ++i) {
+    permutation.push_back(i);
+  }
+  permutation.push_back(0);
+  for (int64_t i = dim + 1; i < rank; ++i) {
+    permutation.push_back(i);
+  }
+  return xla::Transpose(input, permutation);
+}
+
+xla::XlaOp ConcatColumns(absl::Span<const xla::XlaOp> inputs) {
+  return inputs.size() == 1
+             ? inputs.front()
+             : xla::ConcatInDim(inputs.front().builder(), inputs, 1);
+}
+
 }  // namespace
 
 std::vector<xla::XlaOp> BuildAllReduce(
@@ -89,23 +127,37 @@ std::vector<xla::XlaOp> BuildAllReduce(
     xla::XlaOp token, double scale,
     const std::vector<std::vector<int64_t>>& groups) {
   std::vector<xla::ReplicaGroup> reduce_groups = CreateReduceGroups(groups);
-  // TODO: We use pseudo-tokens ATM, which are real values. This need to be
-  // switched to use the real XLA Token once support has been added to XLA
-  // AllReduce().
   xla::XlaOp chained_token = token;
   ReduceContext redux = GetReduceContext(operands);
   std::vector<xla::XlaOp> result(operands.size());
   for (auto& type_ctx : redux.contexts) {
-    xla::XlaOp token_op = MaybeConvertTo(chained_token, type_ctx.first);
-    type_ctx.second.ops.push_back(token_op);
-    type_ctx.second.operand_shapes.push_back(
-        XlaHelpers::ShapeOfXlaOp(token_op));
-
-    xla::XlaOp reduce = xla::AllReduce(
-        xla::Tuple(operands[0].builder(), type_ctx.second.ops),
-        GetReduceComutation(reduce_type, type_ctx.first), reduce_groups,
-        /*channel_id=*/absl::nullopt,
-        MakeReduceShape(type_ctx.second.operand_shapes));
+    xla::XlaOp reduce;
+    if (TokenHandler::IsRealToken(token)) {
+      // XLA AllReduce() does not take token operands, so the ordering is
+      // enforced by the token handler barriers, without touching the data.
+      TokenHandler token_handler(chained_token);
+      reduce = xla::AllReduce(
+          token_handler.GetInput(
+              xla::Tuple(operands[0].builder(), type_ctx.second.ops),
+              /*input_shape=*/nullptr),
+          GetReduceComutation(reduce_type, type_ctx.first), reduce_groups,
+          /*channel_id=*/absl::nullopt,
+          MakeReduceShape(type_ctx.second.operand_shapes));
+      chained_token = token_handler.GetNewToken(reduce);
+    } else {
+      // With pseudo-tokens, the token is reduced together with the operands.
+      xla::XlaOp token_op = MaybeConvertTo(chained_token, type_ctx.first);
+      type_ctx.second.ops.push_back(token_op);
+      type_ctx.second.operand_shapes.push_back(
+          XlaHelpers::ShapeOfXlaOp(token_op));
+      reduce = xla::AllReduce(
+          xla::Tuple(operands[0].builder(), type_ctx.second.ops),
+          GetReduceComutation(reduce_type, type_ctx.first), reduce_groups,
+          /*channel_id=*/absl::nullopt,
+          MakeReduceShape(type_ctx.second.operand_shapes));
+      chained_token =
+          xla::GetTupleElement(reduce, type_ctx.second.indices.size());
+    }
     for (size_t i = 0; i < type_ctx.second.indices.size(); ++i) {
       size_t op_idx = type_ctx.second.indices[i];
       xla::XlaOp gte = xla::GetTupleElement(reduce, i);
@@ -117,11 +169,11 @@ std::vector<xla::XlaOp> BuildAllReduce(
       }
       result[op_idx] = gte;
     }
-    chained_token =
-        xla::GetTupleElement(reduce, type_ctx.second.indices.size());
   }
-  result.push_back(
-      MaybeConvertTo(chained_token, XlaHelpers::TypeOfXlaOp(token)));
+  result.push_back(TokenHandler::IsRealToken(token)
+                       ? chained_token
+                       : MaybeConvertTo(chained_token,
+                                        XlaHelpers::TypeOfXlaOp(token)));
   return result;
 }
 
@@ -153,6 +205,55 @@ AllGatherResult BuildAllGather(
   return {all_gather_result, token_handler.GetNewToken(all_gather_result)};
 }
 
+std::vector<xla::XlaOp> BuildAllGatherCoalesced(
+    absl::Span<const xla::XlaOp> inputs, xla::XlaOp token,
+    absl::Span<const int64_t> dims, int64_t shard_count,
+    const std::vector<std::vector<int64_t>>& groups) {
+  XLA_CHECK_EQ(inputs.size(), dims.size());
+  std::vector<xla::ReplicaGroup> reduce_groups = CreateReduceGroups(groups);
+  xla::XlaOp chained_token = token;
+  ReduceContext redux = GetReduceContext(inputs);
+  std::vector<xla::XlaOp> result(inputs.size());
+  for (auto& type_ctx : redux.contexts) {
+    // Each input gets its gather dimension moved to the front, and is then
+    // flattened into a [1, N] row. All the rows are packed into a single
+    // [1, SUM(N)] tensor, whose gather on dimension 0 leaves each input's
+    // gathered values within a [shard_count, N] column band.
+    std::vector<xla::XlaOp> rows;
+    std::vector<xla::Shape> front_shapes;
+    for (size_t i = 0; i < type_ctx.second.indices.size(); ++i) {
+      size_t op_idx = type_ctx.second.indices[i];
+      XLA_CHECK_GT(type_ctx.second.operand_shapes[i].rank(), 0)
+          << "Cannot all-gather scalar tensors";
+      xla::XlaOp front = MoveDimToFront(type_ctx.second.ops[i], dims[op_idx]);
+      front_shapes.push_back(XlaHelpers::ShapeOfXlaOp(front));
+      rows.push_back(xla::Reshape(
+          front, {1, xla::ShapeUtil::ElementsIn(front_shapes.back())}));
+    }
+    TokenHandler token_handler(chained_token);
+    xla::XlaOp gathered = xla::AllGather(
+        token_handler.GetInput(ConcatColumns(rows), /*input_shape=*/nullptr),
+        /*all_gather_dimension=*/0, shard_count, reduce_groups);
+    chained_token = token_handler.GetNewToken(gathered);
+
+    int64_t offset = 0;
+    for (size_t i = 0; i < type_ctx.second.indices.size(); ++i) {
+      size_t op_idx = type_ctx.second.indices[i];
+      int64_t size = xla::ShapeUtil::ElementsIn(front_shapes[i]);
+      xla::XlaOp band =
+          xla::SliceInDim(gathered, offset, offset + size, 1, /*dimno=*/1);
+      offset += size;
+      std::vector<int64_t> dimensions(front_shapes[i].dimensions().begin(),
+                                      front_shapes[i].dimensions().end());
+      dimensions[0] *= shard_count;
+      result[op_idx] =
+          MoveFrontToDim(xla::Reshape(band, dimensions), dims[op_idx]);
+    }
+  }
+  result.push_back(chained_token);
+  return result;
+}
+
 CollectivePermuteResult BuildCollectivePermute(
     xla::XlaOp input, xla::XlaOp token,
     const std::vector<std::pair<int64_t, int64_t>>& source_target_pairs) {
@@ -192,4 +293,72 @@ ReduceScatterResult BuildReduceScatter(
   return {reduce_result, token_handler.GetNewToken(reduce_result)};
 }
 
+std::vector<xla::XlaOp> BuildReduceScatterCoalesced(
+    AllReduceType reduce_type, absl::Span<const xla::XlaOp> inputs,
+    xla::XlaOp token, double scale, absl::Span<const int64_t> scatter_dims,
+    int64_t shard_count, const std::vector<std::vector<int64_t>>& groups) {
+  XLA_CHECK_EQ(inputs.size(), scatter_dims.size());
+  std::vector<xla::ReplicaGroup> reduce_groups = CreateReduceGroups(groups);
+  xla::XlaOp chained_token = token;
+  ReduceContext redux = GetReduceContext(inputs);
+  std::vector<xla::XlaOp> result(inputs.size());
+  for (auto& type_ctx : redux.contexts) {
+    // Each input gets its scatter dimension moved to the front, and is then
+    // reshaped to [shard_count, N], so that the shard going to each replica
+    // is a row. All of them are packed into a single [shard_count, SUM(N)]
+    // tensor, which gets reduce-scattered on dimension 0.
+    std::vector<xla::XlaOp> columns;
+    std::vector<xla::Shape> front_shapes;
+    for (size_t i = 0; i < type_ctx.second.indices.size(); ++i) {
+      size_t op_idx = type_ctx.second.indices[i];
+      XLA_CHECK_GT(type_ctx.second.operand_shapes[i].rank(), 0)
+          << "Cannot reduce-scatter scalar tensors";
+      xla::XlaOp front =
+          MoveDimToFront(type_ctx.second.ops[i], scatter_dims[op_idx]);
+      front_shapes.push_back(XlaHelpers::ShapeOfXlaOp(front));
+      XLA_CHECK_EQ(front_shapes.back().dimensions(0) % shard_count, 0)
+          << "Scatter dimension " << scatter_dims[op_idx] << " of "
+          << type_ctx.second.operand_shapes[i]
+          << " is not divisible by the shard count " << shard_count;
+      columns.push_back(xla::Reshape(
+          front,
+          {shard_count,
+           xla::ShapeUtil::ElementsIn(front_shapes.back()) / shard_count}));
+    }
+    xla::XlaOp packed = ConcatColumns(columns);
+    const xla::Shape& packed_shape = XlaHelpers::ShapeOfXlaOp(packed);
+    xla::Shape reduce_shape = MakeArrayShapeFromDimensions(
+        packed_shape.dimensions(), packed_shape.dynamic_dimensions(),
+        type_ctx.first, GetCurrentDevice().device_type.hw_type);
+    TokenHandler token_handler(chained_token);
+    xla::XlaOp reduced = xla::ReduceScatter(
+        token_handler.GetInput(packed, &packed_shape),
+        GetReduceComutation(reduce_type, type_ctx.first),
+        /*scatter_dimension=*/0, shard_count, reduce_groups,
+        /*channel_id=*/absl::nullopt, reduce_shape.layout());
+    if (scale != 1.0) {
+      xla::XlaOp scaling_value = XlaHelpers::ScalarValue<float>(
+          scale, type_ctx.first, reduced.builder());
+      reduced = reduced * scaling_value;
+    }
+    chained_token = token_handler.GetNewToken(reduced);
+
+    int64_t offset = 0;
+    for (size_t i = 0; i < type_ctx.second.indices.size(); ++i) {
+      size_t op_idx = type_ctx.second.indices[i];
+      int64_t size = xla::ShapeUtil::ElementsIn(front_shapes[i]) / shard_count;
+      xla::XlaOp shard =
+          xla::SliceInDim(reduced, offset, offset + size, 1, /*dimno=*/1);
+      offset += size;
+      std::vector<int64_t> dimensions(front_shapes[i].dimensions().begin(),
+                                      front_shapes[i].dimensions().end());
+      dimensions[0] /= shard_count;
+      result[op_idx] =
+          MoveFrontToDim(xla::Reshape(shard, dimensions), scatter_dims[op_idx]);
+    }
+  }
+  result.push_back(chained_token);
+  return result;
+}
+
 }  // namespace torch_xla
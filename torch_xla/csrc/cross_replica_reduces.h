@@ -50,6 +50,14 @@ AllGatherResult BuildAllGather(xla::XlaOp input, xla::XlaOp token, int64_t dim,
                                int64_t shard_count,
                                const std::vector<std::vector<int64_t>>& groups);
 
+// Gathers all the inputs, each one along its own dimension from dims, using a
+// single XLA AllGather() for each input element type. Returns the gathered
+// tensors, followed by the new token.
+std::vector<xla::XlaOp> BuildAllGatherCoalesced(
+    absl::Span<const xla::XlaOp> inputs, xla::XlaOp token,
+    absl::Span<const int64_t> dims, int64_t shard_count,
+    const std::vector<std::vector<int64_t>>& groups);
+
 CollectivePermuteResult BuildCollectivePermute(
     xla::XlaOp input, xla::XlaOp token,
     const std::vector<std::pair<int64_t, int64_t>>& source_target_pairs);
@@ -59,4 +67,12 @@ ReduceScatterResult BuildReduceScatter(
     int64_t scatter_dim, int64_t shard_count,
     const std::vector<std::vector<int64_t>>& groups);
 
+// Reduces and scatters all the inputs, each one along its own dimension from
+// scatter_dims, using a single XLA ReduceScatter() for each input element type.
+// Returns the scattered tensors, followed by the new token.
+std::vector<xla::XlaOp> BuildReduceScatterCoalesced(
+    AllReduceType reduce_type, absl::Span<const xla::XlaOp> inputs,
+    xla::XlaOp token, double scale, absl::Span<const int64_t> scatter_dims,
+    int64_t shard_count, const std::vector<std::vector<int64_t>>& groups);
+
 }  // namespace torch_xla
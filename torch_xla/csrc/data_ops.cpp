@@ -32,6 +32,26 @@ bool IsSparseGather(const xla::Shape& input_shape,
   return index_elements < input_elements / dense_gather_factor;
 }
 
+// Returns the dimension along which the slice at next_indices, of next_sizes,
+// starts right where the one at indices, of sizes, ends, with the two slices
+// matching along all the other dimensions. Returns -1 if there is none.
+int64_t AdjacentSliceDim(absl::Span<const int64_t> indices,
+                         absl::Span<const int64_t> sizes,
+                         absl::Span<const int64_t> next_indices,
+                         absl::Span<const int64_t> next_sizes) {
+  int64_t adjacent_dim = -1;
+  for (size_t dim = 0; dim < indices.size(); ++dim) {
+    if (indices[dim] == next_indices[dim] && sizes[dim] == next_sizes[dim]) {
+      continue;
+    }
+    if (adjacent_dim >= 0 || indices[dim] + sizes[dim] != next_indices[dim]) {
+      return -1;
+    }
+    adjacent_dim = dim;
+  }
+  return adjacent_dim;
+}
+
 }  // namespace
 
 bool IsSparseGather(xla::XlaOp input, xla::XlaOp index, int64_t dim) {
@@ -225,6 +245,57 @@ xla::XlaOp BuildUpdateSlice(xla::XlaOp input, xla::XlaOp source,
   return xla::DynamicUpdateSlice(input, reshaped_source, start_indices);
 }
 
+xla::XlaOp BuildUpdateSlices(
+    xla::XlaOp input, absl::Span<const xla::XlaOp> sources,
+    absl::Span<const std::vector<int64_t>> base_indices) {
+  XLA_CHECK_EQ(sources.size(), base_indices.size());
+  const xla::Shape& input_shape = XlaHelpers::ShapeOfXlaOp(input);
+  xla::XlaOp result = input;
+  // The pending run of adjacent updates. Being adjacent, the updates of a run
+  // are disjoint, so they can be applied together.
+  std::vector<xla::XlaOp> run_sources;
+  std::vector<int64_t> run_indices;
+  std::vector<int64_t> run_sizes;
+  int64_t run_dim = -1;
+  auto flush_run = [&]() {
+    if (!run_sources.empty()) {
+      xla::XlaOp source =
+          run_sources.size() == 1
+              ? run_sources.front()
+              : xla::ConcatInDim(input.builder(), run_sources, run_dim);
+      result = BuildUpdateSlice(result, source, run_indices);
+      run_sources.clear();
+      run_dim = -1;
+    }
+  };
+  for (size_t i = 0; i < sources.size(); ++i) {
+    xla::XlaOp source = sources[i];
+    const xla::Shape& source_shape = XlaHelpers::ShapeOfXlaOp(source);
+    if (source_shape.element_type() != input_shape.element_type()) {
+      source = ConvertTo(source, source_shape.element_type(),
+                         input_shape.element_type(), /*device=*/nullptr);
+    }
+    source = XlaHelpers::ReshapeToRank(source, input_shape.rank());
+    std::vector<int64_t> source_sizes = XlaHelpers::SizesOfXlaOp(source);
+    int64_t dim = run_sources.empty()
+                      ? -1
+                      : AdjacentSliceDim(run_indices, run_sizes,
+                                         base_indices[i], source_sizes);
+    if (dim >= 0 && (run_dim < 0 || dim == run_dim)) {
+      run_sources.push_back(source);
+      run_sizes[dim] += source_sizes[dim];
+      run_dim = dim;
+    } else {
+      flush_run();
+      run_sources.push_back(source);
+      run_indices = base_indices[i];
+      run_sizes = std::move(source_sizes);
+    }
+  }
+  flush_run();
+  return result;
+}
+
 xla::XlaOp BuildSlice(xla::XlaOp input, absl::Span<const int64_t> base_indices,
                       absl::Span<const int64_t> sizes) {
   XLA_CHECK_EQ(base_indices.size(), sizes.size());
@@ -69,6 +69,14 @@ std::vector<xla::XlaOp> BuildSplit(xla::XlaOp input,
 xla::XlaOp BuildUpdateSlice(xla::XlaOp input, xla::XlaOp source,
                             absl::Span<const int64_t> base_indices);
 
+// Applies, in order, the updates of input with the sources at the matching
+// base_indices. Runs of updates which are adjacent along the same dimension
+// (like the ones writing the consecutive rows of a tensor) are concatenated
+// and applied by a single dynamic update slice.
+xla::XlaOp BuildUpdateSlices(
+    xla::XlaOp input, absl::Span<const xla::XlaOp> sources,
+    absl::Span<const std::vector<int64_t>> base_indices);
+
 xla::XlaOp BuildSlice(xla::XlaOp input, absl::Span<const int64_t> base_indices,
                       absl::Span<const int64_t> sizes);
 
@@ -1,13 +1,21 @@
 #include "torch_xla/csrc/debug_util.h"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
 #include <fstream>
 #include <mutex>
+#include <set>
 #include <sstream>
+#include <thread>
 #include <unordered_set>
 
 #include "absl/memory/memory.h"
 #include "absl/strings/str_split.h"
 #include "tensorflow/compiler/xla/xla_client/debug_macros.h"
+#include "tensorflow/compiler/xla/xla_client/metrics.h"
 #include "tensorflow/compiler/xla/xla_client/sys_util.h"
 #include "tensorflow/compiler/xla/xla_client/unique.h"
 #include "torch/csrc/lazy/core/hash.h"
@@ -44,67 +52,66 @@ std::unordered_set<std::string>* LoadExperiments() {
   return xset.release();
 }
 
-}  // namespace
-
-DebugUtil::GraphFormat DebugUtil::GetDefaultGraphFormat() {
-  static GraphFormat format = DefaultGraphFormat();
-  return format;
-}
-
-std::string DebugUtil::GetTensorsGraphInfo(absl::Span<const XLATensor> tensors,
-                                           const std::vector<size_t>* indices,
-                                           GraphFormat format) {
+struct GraphRoots {
   std::vector<const torch::lazy::Node*> root_nodes;
+  // Holds references to the root nodes, so that the graph stays alive until
+  // rendered.
   std::vector<ir::Value> root_values;
   std::vector<torch::lazy::hash_t> root_hashes;
+  Device device;
+};
+
+GraphRoots CollectGraphRoots(absl::Span<const XLATensor> tensors,
+                             const std::vector<size_t>* indices) {
+  GraphRoots roots;
   xla::util::Unique<Device> unique_device;
+  auto add_tensor = [&](const XLATensor& tensor) {
+    ir::Value ir_value = tensor.CurrentIrValue();
+    if (ir_value) {
+      roots.root_nodes.push_back(ir_value.node.get());
+      roots.root_hashes.push_back(ir_value.hash());
+      roots.root_values.push_back(std::move(ir_value));
+      unique_device.set(tensor.GetDevice());
+    }
+  };
   if (indices != nullptr) {
     for (auto index : *indices) {
-      const XLATensor& tensor = tensors[index];
-      ir::Value ir_value = tensor.CurrentIrValue();
-      if (ir_value) {
-        root_nodes.push_back(ir_value.node.get());
-        root_hashes.push_back(ir_value.hash());
-        root_values.push_back(std::move(ir_value));
-        unique_device.set(tensor.GetDevice());
-      }
+      add_tensor(tensors[index]);
     }
   } else {
     for (auto& tensor : tensors) {
-      ir::Value ir_value = tensor.CurrentIrValue();
-      if (ir_value) {
-        root_nodes.push_back(ir_value.node.get());
-        root_hashes.push_back(ir_value.hash());
-        root_values.push_back(std::move(ir_value));
-        unique_device.set(tensor.GetDevice());
-      }
+      add_tensor(tensor);
     }
   }
+  roots.device = unique_device ? *unique_device : GetCurrentDevice();
+  return roots;
+}
+
+std::string RenderGraphInfo(
+    const std::vector<torch::lazy::SourceLocation>& frames,
+    const GraphRoots& roots, DebugUtil::GraphFormat format) {
   std::stringstream ss;
-  std::vector<torch::lazy::SourceLocation> frames =
-      torch::lazy::GetPythonFrames();
   ss << "TensorsGraphInfo:\n";
   for (auto& location : frames) {
     ss << "  " << location.function << " (" << location.file << ":"
        << location.line << ")\n";
   }
   ss << "\nHashes: (";
-  for (size_t i = 0; i < root_hashes.size(); ++i) {
+  for (size_t i = 0; i < roots.root_hashes.size(); ++i) {
     if (i > 0) {
       ss << ", ";
     }
-    ss << torch::lazy::HashToString(root_hashes[i]);
+    ss << torch::lazy::HashToString(roots.root_hashes[i]);
   }
   ss << ")\n";
 
   std::string graph_str;
-  if (format == GraphFormat::kText) {
-    graph_str = ir::DumpUtil::ToText(root_nodes);
-  } else if (format == GraphFormat::kDot) {
-    graph_str = ir::DumpUtil::ToDot(root_nodes);
-  } else if (format == GraphFormat::kHlo) {
-    graph_str = ir::DumpUtil::ToHlo(
-        root_values, unique_device ? *unique_device : GetCurrentDevice());
+  if (format == DebugUtil::GraphFormat::kText) {
+    graph_str = ir::DumpUtil::ToText(roots.root_nodes);
+  } else if (format == DebugUtil::GraphFormat::kDot) {
+    graph_str = ir::DumpUtil::ToDot(roots.root_nodes);
+  } else if (format == DebugUtil::GraphFormat::kHlo) {
+    graph_str = ir::DumpUtil::ToHlo(roots.root_values, roots.device);
   } else {
     XLA_ERROR() << "Invalid graph format: " << format;
   }
@@ -112,6 +119,196 @@ std::string DebugUtil::GetTensorsGraphInfo(absl::Span<const XLATensor> tensors,
   return ss.str();
 }
 
+// Writes the graph reports of XLA_SAVE_TENSORS_FILE. Unless
+// XLA_SAVE_TENSORS_ASYNC is false, the reports are rendered and written by a
+// background thread, fed by a queue of at most XLA_SAVE_TENSORS_QUEUE_SIZE
+// entries. The graphs arriving with a full queue are dropped (and counted by
+// the SaveTensorsGraphDropped counter), so that dumping never stalls the graph
+// syncs. XLA_SAVE_TENSORS_SAMPLE_RATE=N saves only one every N graphs, and
+// XLA_SAVE_TENSORS_DEDUP saves every distinct graph (by hash) only once.
+// The queued graphs (with the device data they reference) are kept alive until
+// rendered, so at most XLA_SAVE_TENSORS_MAX_RETAINED_GRAPHS of them are queued
+// as such. Past that, the graphs are rendered by the thread syncing them, and
+// only their reports are queued.
+class GraphDumper {
+ public:
+  struct Dump {
+    std::string name;
+    GraphRoots roots;
+    std::vector<torch::lazy::SourceLocation> frames;
+    DebugUtil::GraphFormat format;
+    torch::lazy::hash_t graph_hash;
+    // The rendered report, if the graph has not been retained.
+    std::string info;
+    bool retained = false;
+  };
+
+  explicit GraphDumper(std::string save_file)
+      : save_file_(std::move(save_file)),
+        async_(xla::sys_util::GetEnvBool("XLA_SAVE_TENSORS_ASYNC", true)),
+        dedup_(xla::sys_util::GetEnvBool("XLA_SAVE_TENSORS_DEDUP", false)),
+        sample_rate_(std::max<int64_t>(
+            xla::sys_util::GetEnvInt("XLA_SAVE_TENSORS_SAMPLE_RATE", 1), 1)),
+        max_queue_size_(
+            xla::sys_util::GetEnvInt("XLA_SAVE_TENSORS_QUEUE_SIZE", 64)),
+        max_retained_graphs_(xla::sys_util::GetEnvInt(
+            "XLA_SAVE_TENSORS_MAX_RETAINED_GRAPHS", 8)) {
+    if (async_) {
+      writer_ = std::thread([this]() { Run(); });
+    }
+  }
+
+  bool ShouldSample() { return sample_count_++ % sample_rate_ == 0; }
+
+  bool ShouldDump(const GraphRoots& roots) {
+    if (!dedup_) {
+      return true;
+    }
+    std::lock_guard<std::mutex> lock(lock_);
+    return dumped_hashes_.insert(GraphHash(roots)).second;
+  }
+
+  void Add(Dump dump) {
+    if (!async_) {
+      Write(dump);
+      return;
+    }
+    dump.graph_hash = GraphHash(dump.roots);
+    bool retained = false;
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      if (!CanQueue(dump)) {
+        return;
+      }
+      retained = retained_graphs_ < max_retained_graphs_;
+      if (retained) {
+        ++retained_graphs_;
+        dump.retained = true;
+        queue_.push_back(std::move(dump));
+      }
+    }
+    if (!retained) {
+      // Too many queued graphs are kept alive already, so render this one here
+      // and only queue its report.
+      dump.info = RenderGraphInfo(dump.frames, dump.roots, dump.format);
+      dump.roots = GraphRoots();
+      std::lock_guard<std::mutex> lock(lock_);
+      if (!CanQueue(dump)) {
+        return;
+      }
+      queue_.push_back(std::move(dump));
+    }
+    cv_.notify_one();
+  }
+
+  // Waits for the pending reports to be written, and stops the writer thread.
+  void Stop() {
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      stopped_ = true;
+    }
+    cv_.notify_one();
+    if (writer_.joinable()) {
+      writer_.join();
+    }
+  }
+
+ private:
+  static torch::lazy::hash_t GraphHash(const GraphRoots& roots) {
+    torch::lazy::hash_t hash(static_cast<uint64_t>(0));
+    for (auto& root_hash : roots.root_hashes) {
+      hash = torch::lazy::HashCombine(hash, root_hash);
+    }
+    return hash;
+  }
+
+  // Called with lock_ held.
+  bool CanQueue(const Dump& dump) {
+    if (stopped_ || queue_.size() >= max_queue_size_) {
+      XLA_COUNTER("SaveTensorsGraphDropped", 1);
+      if (dedup_) {
+        // Let a later instance of the same graph be saved.
+        dumped_hashes_.erase(dump.graph_hash);
+      }
+      return false;
+    }
+    return true;
+  }
+
+  void Run() {
+    while (true) {
+      Dump dump;
+      {
+        std::unique_lock<std::mutex> lock(lock_);
+        cv_.wait(lock, [this]() { return stopped_ || !queue_.empty(); });
+        if (queue_.empty()) {
+          break;
+        }
+        dump = std::move(queue_.front());
+        queue_.pop_front();
+      }
+      Write(dump);
+      if (dump.retained) {
+        // Release the graph before making room for another one.
+        dump.roots = GraphRoots();
+        std::lock_guard<std::mutex> lock(lock_);
+        --retained_graphs_;
+      }
+    }
+  }
+
+  void Write(const Dump& dump) {
+    std::string info =
+        dump.info.empty()
+            ? RenderGraphInfo(dump.frames, dump.roots, dump.format)
+            : dump.info;
+    std::lock_guard<std::mutex> guard(write_lock_);
+    std::ofstream graph_file(save_file_, std::ios_base::app);
+    graph_file << "[" << dump.name << "]\n" << info << "\n";
+  }
+
+  const std::string save_file_;
+  const bool async_;
+  const bool dedup_;
+  const int64_t sample_rate_;
+  const size_t max_queue_size_;
+  const size_t max_retained_graphs_;
+  std::atomic<int64_t> sample_count_{0};
+  std::mutex lock_;
+  std::mutex write_lock_;
+  std::condition_variable cv_;
+  std::deque<Dump> queue_;
+  size_t retained_graphs_ = 0;
+  std::set<torch::lazy::hash_t> dumped_hashes_;
+  bool stopped_ = false;
+  std::thread writer_;
+};
+
+GraphDumper* GetGraphDumper(const std::string& save_file) {
+  static GraphDumper* dumper = [&]() {
+    GraphDumper* graph_dumper = new GraphDumper(save_file);
+    // Drain the pending reports at exit, as they are usually the ones
+    // explaining what happened last.
+    std::atexit([]() { dumper->Stop(); });
+    return graph_dumper;
+  }();
+  return dumper;
+}
+
+}  // namespace
+
+DebugUtil::GraphFormat DebugUtil::GetDefaultGraphFormat() {
+  static GraphFormat format = DefaultGraphFormat();
+  return format;
+}
+
+std::string DebugUtil::GetTensorsGraphInfo(absl::Span<const XLATensor> tensors,
+                                           const std::vector<size_t>* indices,
+                                           GraphFormat format) {
+  GraphRoots roots = CollectGraphRoots(tensors, indices);
+  return RenderGraphInfo(torch::lazy::GetPythonFrames(), roots, format);
+}
+
 void DebugUtil::SaveTensorsGraphInfo(const char* name,
                                      absl::Span<const XLATensor> tensors,
                                      const std::vector<size_t>* indices,
@@ -119,11 +316,21 @@ void DebugUtil::SaveTensorsGraphInfo(const char* name,
   static const std::string save_file =
       xla::sys_util::GetEnvOrdinalPath("XLA_SAVE_TENSORS_FILE", "");
   if (!save_file.empty()) {
-    static std::mutex lock;
-    std::string info = GetTensorsGraphInfo(tensors, indices, format);
-    std::lock_guard<std::mutex> guard(lock);
-    std::ofstream graph_file(save_file, std::ios_base::app);
-    graph_file << "[" << name << "]\n" << info << "\n";
+    GraphDumper* dumper = GetGraphDumper(save_file);
+    if (!dumper->ShouldSample()) {
+      return;
+    }
+    // Only the graph identity is captured here, the rendering happening
+    // within the dumper.
+    GraphDumper::Dump dump;
+    dump.name = name;
+    dump.roots = CollectGraphRoots(tensors, indices);
+    if (!dumper->ShouldDump(dump.roots)) {
+      return;
+    }
+    dump.frames = torch::lazy::GetPythonFrames();
+    dump.format = format;
+    dumper->Add(std::move(dump));
   }
 }
 
@@ -0,0 +1,302 @@
+#include "torch_xla/csrc/example_pipeline.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "tensorflow/compiler/xla/xla_client/debug_macros.h"
+#include "tensorflow/compiler/xla/xla_client/metrics.h"
+#include "tensorflow/compiler/xla/xla_client/record_reader.h"
+#include "tensorflow/compiler/xla/xla_client/util.h"
+#include "tensorflow/core/example/example.pb.h"
+#include "tensorflow/core/example/feature.pb.h"
+#include "torch_xla/csrc/aten_xla_bridge.h"
+#include "torch_xla/csrc/tensor.h"
+#include "torch_xla/csrc/tensor_util.h"
+
+namespace torch_xla {
+namespace {
+
+template <typename D, typename S>
+void CopyFeatureValues(const S* values, int64_t count,
+                       const ExamplePipeline::FeatureSpec& spec, int64_t row,
+                       at::Tensor* tensor) {
+  int64_t row_elements = xla::util::Multiply<int64_t>(spec.shape);
+  XLA_CHECK(count == row_elements || (spec.pad && count < row_elements))
+      << "Feature " << spec.name << " has " << count
+      << " values, while its shape requires " << row_elements;
+  D* dest = tensor->data_ptr<D>() + row * row_elements;
+  std::copy(values, values + count, dest);
+  std::fill(dest + count, dest + row_elements,
+            static_cast<D>(spec.padding_value));
+}
+
+void FillRow(const tensorflow::Example& example,
+             const std::vector<ExamplePipeline::FeatureSpec>& features,
+             int64_t row, std::vector<at::Tensor>* tensors) {
+  const auto& feature_map = example.features().feature();
+  for (size_t i = 0; i < features.size(); ++i) {
+    const ExamplePipeline::FeatureSpec& spec = features[i];
+    at::Tensor* tensor = &(*tensors)[i];
+    auto it = feature_map.find(spec.name);
+    if (it == feature_map.end()) {
+      XLA_CHECK(spec.pad) << "Feature " << spec.name << " not found";
+      tensor->select(/*dim=*/0, row).fill_(spec.padding_value);
+      continue;
+    }
+    const tensorflow::Feature& feature = it->second;
+    switch (feature.kind_case()) {
+      case tensorflow::Feature::kFloatList: {
+        XLA_CHECK_EQ(spec.type, at::kFloat) << "Feature " << spec.name;
+        const tensorflow::FloatList& fvalue = feature.float_list();
+        CopyFeatureValues<float>(fvalue.value().data(), fvalue.value_size(),
+                                 spec, row, tensor);
+      } break;
+      case tensorflow::Feature::kInt64List: {
+        const tensorflow::Int64List& ivalue = feature.int64_list();
+        if (spec.type == at::kLong) {
+          CopyFeatureValues<int64_t>(ivalue.value().data(),
+                                     ivalue.value_size(), spec, row, tensor);
+        } else {
+          XLA_CHECK_EQ(spec.type, at::kInt) << "Feature " << spec.name;
+          for (int64_t value : ivalue.value()) {
+            XLA_CHECK(value >= std::numeric_limits<int32_t>::min() &&
+                      value <= std::numeric_limits<int32_t>::max())
+                << "Feature " << spec.name << " value " << value
+                << " does not fit the int32 type";
+          }
+          CopyFeatureValues<int32_t>(ivalue.value().data(),
+                                     ivalue.value_size(), spec, row, tensor);
+        }
+      } break;
+      case tensorflow::Feature::kBytesList: {
+        const tensorflow::BytesList& bvalue = feature.bytes_list();
+        XLA_CHECK_EQ(bvalue.value_size(), 1)
+            << "Feature " << spec.name << " must have a single bytes value";
+        const std::string& svalue = bvalue.value(0);
+        if (spec.type == at::kByte) {
+          CopyFeatureValues<uint8_t>(
+              reinterpret_cast<const uint8_t*>(svalue.data()), svalue.size(),
+              spec, row, tensor);
+        } else {
+          XLA_CHECK_EQ(spec.type, at::kChar) << "Feature " << spec.name;
+          CopyFeatureValues<int8_t>(
+              reinterpret_cast<const int8_t*>(svalue.data()), svalue.size(),
+              spec, row, tensor);
+        }
+      } break;
+      default:
+        XLA_ERROR() << "Unsupported data type for feature " << spec.name;
+    }
+  }
+}
+
+}  // namespace
+
+struct ExamplePipeline::Batch {
+  std::vector<at::Tensor> tensors;
+  // The number of rows assigned to the readers. Protected by the pipeline
+  // mutex.
+  int64_t rows = 0;
+  std::atomic<int64_t> completed_rows{0};
+};
+
+template <typename T>
+bool ExamplePipeline::Queue<T>::Push(T value) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_.wait(lock, [this] { return closed_ || values_.size() < capacity_; });
+  if (closed_) {
+    return false;
+  }
+  values_.push_back(std::move(value));
+  cv_.notify_all();
+  return true;
+}
+
+template <typename T>
+bool ExamplePipeline::Queue<T>::Pop(T* value) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_.wait(lock, [this] { return closed_ || !values_.empty(); });
+  if (values_.empty()) {
+    return false;
+  }
+  *value = std::move(values_.front());
+  values_.pop_front();
+  cv_.notify_all();
+  return true;
+}
+
+template <typename T>
+void ExamplePipeline::Queue<T>::Close() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  closed_ = true;
+  cv_.notify_all();
+}
+
+ExamplePipeline::ExamplePipeline(Options options,
+                                 std::vector<FeatureSpec> features)
+    : options_(std::move(options)),
+      features_(std::move(features)),
+      host_queue_(std::max<int64_t>(options_.prefetch, 1)),
+      device_queue_(std::max<int64_t>(options_.prefetch, 1)) {
+  XLA_CHECK_GT(options_.batch_size, 0);
+  XLA_CHECK(!features_.empty());
+  num_readers_ = std::min<size_t>(std::max<int64_t>(options_.num_readers, 1),
+                                  options_.files.size());
+  active_readers_ = num_readers_;
+  for (size_t i = 0; i < num_readers_; ++i) {
+    threads_.emplace_back([this, i]() { ReaderLoop(i); });
+  }
+  if (num_readers_ == 0) {
+    host_queue_.Close();
+  }
+  if (options_.device) {
+    threads_.emplace_back([this]() { UploadLoop(); });
+  }
+}
+
+ExamplePipeline::~ExamplePipeline() {
+  cancelled_ = true;
+  host_queue_.Close();
+  device_queue_.Close();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+std::vector<at::Tensor> ExamplePipeline::Next() {
+  std::vector<at::Tensor> tensors;
+  if (options_.device) {
+    device_queue_.Pop(&tensors);
+  } else {
+    std::shared_ptr<Batch> batch;
+    if (host_queue_.Pop(&batch)) {
+      tensors = std::move(batch->tensors);
+    }
+  }
+  if (tensors.empty()) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+  }
+  return tensors;
+}
+
+std::shared_ptr<ExamplePipeline::Batch> ExamplePipeline::NewBatch() const {
+  auto batch = std::make_shared<Batch>();
+  for (auto& spec : features_) {
+    std::vector<int64_t> sizes({options_.batch_size});
+    sizes.insert(sizes.end(), spec.shape.begin(), spec.shape.end());
+    batch->tensors.push_back(at::empty(sizes, at::TensorOptions(spec.type)));
+  }
+  return batch;
+}
+
+std::shared_ptr<ExamplePipeline::Batch> ExamplePipeline::ClaimRow(
+    int64_t* row) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (current_batch_ == nullptr) {
+    current_batch_ = NewBatch();
+  }
+  std::shared_ptr<Batch> batch = current_batch_;
+  *row = batch->rows;
+  batch->rows += 1;
+  if (batch->rows == options_.batch_size) {
+    current_batch_ = nullptr;
+  }
+  return batch;
+}
+
+void ExamplePipeline::CompleteRow(const std::shared_ptr<Batch>& batch) {
+  if (batch->completed_rows.fetch_add(1) + 1 == options_.batch_size) {
+    XLA_COUNTER("ExamplePipelineBatches", 1);
+    host_queue_.Push(batch);
+  }
+}
+
+void ExamplePipeline::ReaderLoop(size_t reader_index) {
+  try {
+    for (size_t i = reader_index; i < options_.files.size() && !cancelled_;
+         i += num_readers_) {
+      xla::util::RecordReader reader(options_.files[i], options_.compression,
+                                     options_.buffer_size);
+      xla::util::RecordReader::Data value;
+      while (!cancelled_ && reader.Read(&value)) {
+        tensorflow::Example example;
+        XLA_CHECK(example.ParseFromArray(value.data(), value.size()))
+            << "Unable to parse TF example from " << reader.path();
+        int64_t row;
+        std::shared_ptr<Batch> batch = ClaimRow(&row);
+        FillRow(example, features_, row, &batch->tensors);
+        CompleteRow(batch);
+      }
+    }
+  } catch (...) {
+    SetError(std::current_exception());
+  }
+  ReaderDone();
+}
+
+void ExamplePipeline::ReaderDone() {
+  if (active_readers_.fetch_sub(1) != 1) {
+    return;
+  }
+  // All the readers are done, so all the rows of the current batch have been
+  // completed, unless one of them failed.
+  std::shared_ptr<Batch> batch;
+  bool failed = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    batch = std::move(current_batch_);
+    failed = error_ != nullptr;
+  }
+  if (batch != nullptr && !options_.drop_last && !cancelled_ && !failed) {
+    for (auto& tensor : batch->tensors) {
+      tensor = tensor.narrow(/*dim=*/0, /*start=*/0, batch->rows);
+    }
+    XLA_COUNTER("ExamplePipelineBatches", 1);
+    host_queue_.Push(std::move(batch));
+  }
+  host_queue_.Close();
+}
+
+void ExamplePipeline::UploadLoop() {
+  try {
+    std::vector<std::string> devices(features_.size(),
+                                     options_.device->ToString());
+    std::shared_ptr<Batch> batch;
+    while (host_queue_.Pop(&batch)) {
+      std::vector<at::Tensor> tensors;
+      {
+        XLA_TIMED("ExamplePipelineUpload");
+        std::vector<xla::ComputationClient::DataPtr> handles =
+            CreateTensorsData(batch->tensors, devices,
+                              /*transfer_async=*/true);
+        for (size_t i = 0; i < handles.size(); ++i) {
+          tensors.push_back(bridge::AtenFromXlaTensor(XLATensor::Create(
+              std::move(handles[i]), batch->tensors[i].scalar_type())));
+        }
+      }
+      batch = nullptr;
+      if (!device_queue_.Push(std::move(tensors))) {
+        break;
+      }
+    }
+  } catch (...) {
+    SetError(std::current_exception());
+  }
+  device_queue_.Close();
+}
+
+void ExamplePipeline::SetError(std::exception_ptr error) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!error_) {
+      error_ = std::move(error);
+    }
+  }
+  host_queue_.Close();
+  device_queue_.Close();
+}
+
+}  // namespace torch_xla
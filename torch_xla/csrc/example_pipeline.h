@@ -0,0 +1,125 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+#include <c10/util/Optional.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "torch_xla/csrc/device.h"
+
+namespace torch_xla {
+
+// Reads TfExample records out of a set of TfRecord files, and collates them
+// into batches of tensors, entirely outside of Python.
+// The files are sharded among a set of reader threads, each one parsing its
+// records straight into the rows of preallocated batch tensors. If a device is
+// specified, the completed batches are uploaded by a separate thread, so that
+// the transfer of the next batches overlaps with the computation running on
+// the current one.
+class ExamplePipeline {
+ public:
+  struct FeatureSpec {
+    std::string name;
+    // The type of the batch tensor. Float lists can be read into kFloat,
+    // int64 lists into kLong or kInt, and bytes lists (holding a single
+    // value) into kByte or kChar.
+    at::ScalarType type;
+    // The shape of the feature for a single example. The batch tensor will
+    // have shape [batch_size] + shape.
+    std::vector<int64_t> shape;
+    // Whether examples with fewer (or missing) values are allowed, in which
+    // case the remaining elements are filled with padding_value.
+    bool pad = false;
+    double padding_value = 0;
+  };
+
+  struct Options {
+    std::vector<std::string> files;
+    std::string compression;
+    int64_t buffer_size = 16 * 1024 * 1024;
+    int64_t batch_size = 1;
+    int64_t num_readers = 4;
+    // The maximum number of completed batches queued, both on the host and
+    // on the device side.
+    int64_t prefetch = 2;
+    // Whether the final batch should be dropped if smaller than batch_size.
+    bool drop_last = false;
+    // The device the batches are uploaded to. If missing, the batches are
+    // returned as CPU tensors.
+    c10::optional<Device> device;
+  };
+
+  ExamplePipeline(Options options, std::vector<FeatureSpec> features);
+
+  // Cancels the pending reads and uploads, and joins the pipeline threads.
+  ~ExamplePipeline();
+
+  // Returns the tensors of the next batch, in feature order, or an empty
+  // vector once all the records have been consumed. Blocks until a batch is
+  // available, so it should be called without holding the GIL. Errors hit by
+  // the pipeline threads are rethrown from here.
+  std::vector<at::Tensor> Next();
+
+ private:
+  struct Batch;
+
+  // A closable, bounded FIFO queue.
+  template <typename T>
+  class Queue {
+   public:
+    explicit Queue(size_t capacity) : capacity_(capacity) {}
+
+    // Returns false if the queue has been closed.
+    bool Push(T value);
+
+    // Returns false if the queue has been closed, and no more values are
+    // available.
+    bool Pop(T* value);
+
+    void Close();
+
+   private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<T> values_;
+    size_t capacity_;
+    bool closed_ = false;
+  };
+
+  std::shared_ptr<Batch> NewBatch() const;
+
+  // Assigns a row of the batch currently being filled to the caller.
+  std::shared_ptr<Batch> ClaimRow(int64_t* row);
+
+  void CompleteRow(const std::shared_ptr<Batch>& batch);
+
+  void ReaderLoop(size_t reader_index);
+
+  void ReaderDone();
+
+  void UploadLoop();
+
+  void SetError(std::exception_ptr error);
+
+  Options options_;
+  std::vector<FeatureSpec> features_;
+  std::mutex mutex_;
+  std::shared_ptr<Batch> current_batch_;
+  std::exception_ptr error_;
+  size_t num_readers_ = 0;
+  std::atomic<bool> cancelled_{false};
+  std::atomic<size_t> active_readers_{0};
+  Queue<std::shared_ptr<Batch>> host_queue_;
+  Queue<std::vector<at::Tensor>> device_queue_;
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace torch_xla
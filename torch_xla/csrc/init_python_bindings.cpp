@@ -2,6 +2,8 @@
 #include <c10/core/Device.h>
 #include <c10/util/Optional.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <sstream>
 #include <string>
@@ -37,12 +39,15 @@
 #include "torch/csrc/lazy/core/ir_util.h"
 #include "torch_xla/csrc/XLANativeFunctions.h"
 #include "torch_xla/csrc/aten_xla_bridge.h"
+#include "torch_xla/csrc/checkpoint_io.h"
 #include "torch_xla/csrc/computation.h"
 #include "torch_xla/csrc/device.h"
+#include "torch_xla/csrc/example_pipeline.h"
 #include "torch_xla/csrc/helpers.h"
 #include "torch_xla/csrc/ir.h"
 #include "torch_xla/csrc/ir_dump_util.h"
 #include "torch_xla/csrc/ir_util.h"
+#include "torch_xla/csrc/ops/ops.h"
 #include "torch_xla/csrc/tensor_impl.h"
 #include "torch_xla/csrc/tensor_util.h"
 #include "torch_xla/csrc/torch_util.h"
@@ -175,6 +180,20 @@ std::vector<std::pair<int64_t, int64_t>> CreateSourceTargetPairs(
   return source_target_pairs;
 }
 
+py::tuple CoalescedResultTuple(const std::vector<at::Tensor>& inputs,
+                               const std::vector<at::Tensor>& results,
+                               const std::shared_ptr<ir::Value>& token) {
+  py::list result_list;
+  for (size_t i = 0; i < results.size(); ++i) {
+    result_list.append(torch::autograd::make_variable(
+        results[i], /*requires_grad=*/inputs[i].requires_grad()));
+  }
+  auto result_tuple = py::tuple(2);
+  result_tuple[0] = result_list;
+  result_tuple[1] = token;
+  return result_tuple;
+}
+
 std::shared_ptr<ir::Value> AllReduceInPlace(
     const std::string& reduce_type, const std::vector<at::Tensor>& tensors,
     const std::shared_ptr<ir::Value>& token, double scale,
@@ -213,6 +232,22 @@ std::pair<at::Tensor, std::shared_ptr<ir::Value>> ReduceScatter(
       std::make_shared<ir::Value>(new_token));
 }
 
+std::pair<std::vector<at::Tensor>, std::shared_ptr<ir::Value>>
+ReduceScatterCoalesced(
+    const std::string& reduce_type, const std::vector<at::Tensor>& inputs,
+    const std::shared_ptr<ir::Value>& token, double scale,
+    std::vector<int64_t> scatter_dims, int64_t shard_count,
+    const std::vector<std::vector<int64_t>>& replica_groups) {
+  std::vector<XLATensor> results;
+  ir::Value new_token;
+  std::tie(results, new_token) = XLATensor::reduce_scatter(
+      GetXlaTensors(inputs, /*want_all=*/true), *token,
+      GetReduceType(reduce_type), scale, std::move(scatter_dims), shard_count,
+      replica_groups);
+  return {bridge::AtenFromXlaTensors(results),
+          std::make_shared<ir::Value>(new_token)};
+}
+
 std::shared_ptr<ir::Value> ReduceScatterOut(
     const std::string& reduce_type, at::Tensor& output, const at::Tensor& input,
     const std::shared_ptr<ir::Value>& token, double scale, int64_t scatter_dim,
@@ -238,6 +273,20 @@ std::pair<at::Tensor, std::shared_ptr<ir::Value>> AllGather(
           std::make_shared<ir::Value>(new_token)};
 }
 
+std::pair<std::vector<at::Tensor>, std::shared_ptr<ir::Value>>
+AllGatherCoalesced(const std::vector<at::Tensor>& inputs,
+                   const std::shared_ptr<ir::Value>& token,
+                   std::vector<int64_t> dims, int64_t shard_count,
+                   const std::vector<std::vector<int64_t>>& replica_groups) {
+  std::vector<XLATensor> results;
+  ir::Value new_token;
+  std::tie(results, new_token) = XLATensor::all_gather(
+      GetXlaTensors(inputs, /*want_all=*/true), *token, std::move(dims),
+      shard_count, replica_groups);
+  return {bridge::AtenFromXlaTensors(results),
+          std::make_shared<ir::Value>(new_token)};
+}
+
 std::shared_ptr<ir::Value> AllGatherOut(
     at::Tensor& output, const at::Tensor& input,
     const std::shared_ptr<ir::Value>& token, int64_t dim, int64_t shard_count,
@@ -380,10 +429,20 @@ std::vector<at::Tensor> GetXlaTensorsFromAten(
   return xla_tensors;
 }
 
+bool UsePseudoTokens() {
+  static const bool use_pseudo_tokens =
+      xla::sys_util::GetEnvBool("XLA_USE_PSEUDO_TOKENS", false);
+  return use_pseudo_tokens;
+}
+
 std::shared_ptr<ir::Value> CreateToken(const std::string& device_str) {
-  // This should be using xla::CreateToken() once we have added Token support to
-  // XLA AllReduce(). Meanwhile we use a constant as token, and we handle it
-  // accordingly in cross_replica_reduces.cpp.
+  if (!UsePseudoTokens()) {
+    // Real XLA tokens carry no data, and the collective lowerings sequence the
+    // operations with optimization barriers (see token_handler.h).
+    return std::make_shared<ir::Value>(ir::ops::CreateToken());
+  }
+  // The pseudo-token fallback uses a constant zero as token, which the
+  // collective lowerings fold into their inputs and results.
   // This needs to be device data (hence coming in as XLA computation parameter)
   // as otherwise the XLA compiler passes will remove it, vanishing its
   // sequencing effects.
@@ -522,6 +581,68 @@ py::object RecordReadExample(
   return example;
 }
 
+at::ScalarType FeatureTypeFromName(const std::string& name) {
+  static const std::unordered_map<std::string, at::ScalarType>* types =
+      new std::unordered_map<std::string, at::ScalarType>({
+          {"float32", at::kFloat},
+          {"int64", at::kLong},
+          {"int32", at::kInt},
+          {"uint8", at::kByte},
+          {"int8", at::kChar},
+      });
+  auto it = types->find(name);
+  XLA_CHECK(it != types->end()) << "Unsupported feature type: " << name;
+  return it->second;
+}
+
+std::shared_ptr<ExamplePipeline> CreateExamplePipeline(
+    std::vector<std::string> files, const py::list& features,
+    int64_t batch_size, const std::string& compression, int64_t buffer_size,
+    int64_t num_readers, int64_t prefetch, bool drop_last,
+    const std::string& device) {
+  std::vector<ExamplePipeline::FeatureSpec> feature_specs;
+  for (auto& feature : features) {
+    py::tuple spec = feature.cast<py::tuple>();
+    XLA_CHECK_EQ(spec.size(), 5);
+    ExamplePipeline::FeatureSpec feature_spec;
+    feature_spec.name = spec[0].cast<std::string>();
+    feature_spec.type = FeatureTypeFromName(spec[1].cast<std::string>());
+    feature_spec.shape = spec[2].cast<std::vector<int64_t>>();
+    feature_spec.pad = spec[3].cast<bool>();
+    feature_spec.padding_value = spec[4].cast<double>();
+    feature_specs.push_back(std::move(feature_spec));
+  }
+  ExamplePipeline::Options options;
+  options.files = std::move(files);
+  options.compression = compression;
+  options.buffer_size = buffer_size;
+  options.batch_size = batch_size;
+  options.num_readers = num_readers;
+  options.prefetch = prefetch;
+  options.drop_last = drop_last;
+  options.device = GetOptionalDevice(device);
+  NoGilSection nogil;
+  return std::make_shared<ExamplePipeline>(std::move(options),
+                                           std::move(feature_specs));
+}
+
+py::object ExamplePipelineNext(
+    const std::shared_ptr<ExamplePipeline>& pipeline) {
+  std::vector<at::Tensor> tensors;
+  {
+    NoGilSection nogil;
+    tensors = pipeline->Next();
+  }
+  if (tensors.empty()) {
+    return py::none();
+  }
+  auto batch = py::list(tensors.size());
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    batch[i] = torch::autograd::make_variable(tensors[i]);
+  }
+  return batch;
+}
+
 std::unique_ptr<tensorflow::RandomAccessFile> OpenTfFile(
     const std::string& path) {
   tensorflow::Env* env = tensorflow::Env::Default();
@@ -544,36 +665,69 @@ py::object StatTfFile(const std::string& path) {
   return py_stat;
 }
 
+// Reads size bytes at offset into buffer. The range is split into chunks of
+// XLA_TFFILE_READ_CHUNK_SIZE bytes, which are read concurrently by at most
+// XLA_TFFILE_READ_THREADS workers of the IO thread pool.
+void ReadTfFileRange(tensorflow::RandomAccessFile* file, uint64_t offset,
+                     size_t size, char* buffer) {
+  static const size_t chunk_size = std::max<int64_t>(
+      xla::sys_util::GetEnvInt("XLA_TFFILE_READ_CHUNK_SIZE", 8 * 1024 * 1024),
+      1);
+  static const size_t max_threads = xla::sys_util::GetEnvInt(
+      "XLA_TFFILE_READ_THREADS", std::thread::hardware_concurrency());
+  size_t num_chunks = (size + chunk_size - 1) / chunk_size;
+  std::atomic<size_t> next_chunk(0);
+  auto read_chunks = [&]() {
+    for (size_t chunk = next_chunk++; chunk < num_chunks;
+         chunk = next_chunk++) {
+      uint64_t base = static_cast<uint64_t>(chunk) * chunk_size;
+      size_t read_size = std::min<size_t>(chunk_size, size - base);
+      tensorflow::StringPiece result;
+      XLA_CHECK_OK(
+          file->Read(offset + base, read_size, &result, buffer + base));
+      XLA_CHECK_EQ(result.size(), read_size);
+      // Some file systems return pointers to their own memory.
+      if (result.data() != buffer + base) {
+        std::memcpy(buffer + base, result.data(), read_size);
+      }
+    }
+  };
+  size_t num_threads =
+      std::min<size_t>(num_chunks, std::max<size_t>(max_threads, 1));
+  if (num_threads <= 1) {
+    read_chunks();
+    return;
+  }
+  auto mwait = std::make_shared<xla::util::MultiWait>(num_threads);
+  for (size_t i = 0; i < num_threads; ++i) {
+    xla::env::ScheduleIoClosure(xla::util::MultiWait::Completer(
+        mwait, [&read_chunks]() { read_chunks(); }));
+  }
+  mwait->Wait();
+}
+
 py::bytes ReadTfFile(tensorflow::RandomAccessFile* file, uint64_t offset,
                      size_t size) {
-  static const size_t kMinReadSize = 1024 * 1024;
-  std::unique_ptr<char[]> buffer;
+  // Read straight into the storage of the returned bytes object.
+  auto data = py::reinterpret_steal<py::bytes>(
+      PyBytes_FromStringAndSize(nullptr, size));
+  XLA_CHECK(data) << "Unable to allocate " << size << " bytes";
+  char* buffer = PyBytes_AsString(data.ptr());
   {
     NoGilSection nogil;
-    buffer.reset(new char[size]);
-
-    size_t num_threads = std::max<size_t>(size / kMinReadSize, 1);
-    num_threads =
-        std::min<size_t>(num_threads, std::thread::hardware_concurrency());
-    size_t block_size = size / num_threads;
-
-    auto mwait = std::make_shared<xla::util::MultiWait>(num_threads);
-    for (size_t i = 0; i < num_threads; ++i) {
-      auto reader = [&, i]() {
-        uint64_t base = static_cast<uint64_t>(i) * block_size;
-        size_t tsize =
-            (i + 1 < num_threads) ? block_size : (size - i * block_size);
-
-        tensorflow::StringPiece result;
-        XLA_CHECK_OK(
-            file->Read(offset + base, tsize, &result, buffer.get() + base));
-      };
-      xla::env::ScheduleIoClosure(
-          xla::util::MultiWait::Completer(mwait, std::move(reader)));
-    }
-    mwait->Wait();
+    ReadTfFileRange(file, offset, size, buffer);
   }
-  return py::bytes(buffer.get(), size);
+  return data;
+}
+
+void ReadTfFileIntoTensor(tensorflow::RandomAccessFile* file, uint64_t offset,
+                          const at::Tensor& tensor) {
+  XLA_CHECK(tensor.device().is_cpu())
+      << "Tensor must be on CPU: " << tensor.device();
+  XLA_CHECK(tensor.is_contiguous()) << "Tensor must be contiguous";
+  NoGilSection nogil;
+  ReadTfFileRange(file, offset, tensor.numel() * tensor.element_size(),
+                  static_cast<char*>(tensor.data_ptr()));
 }
 
 std::unique_ptr<tensorflow::WritableFile> CreateTfFile(
@@ -958,6 +1112,22 @@ void InitXlaModuleBindings(py::module m) {
           result_tuple[1] = new_token;
           return result_tuple;
         });
+  m.def("_xla_all_gather",
+        [](const std::vector<at::Tensor>& inputs,
+           const std::shared_ptr<ir::Value>& token,
+           const std::vector<int64_t>& dims, int64_t shard_count,
+           const py::list& groups) {
+          std::vector<std::vector<int64_t>> replica_groups =
+              CreateReduceGroups(groups);
+          std::vector<at::Tensor> results;
+          std::shared_ptr<ir::Value> new_token;
+          {
+            NoGilSection nogil;
+            std::tie(results, new_token) = AllGatherCoalesced(
+                inputs, token, dims, shard_count, replica_groups);
+          }
+          return CoalescedResultTuple(inputs, results, new_token);
+        });
   m.def("_xla_all_gather_out", [](at::Tensor& output, const at::Tensor& input,
                                   const std::shared_ptr<ir::Value>& token,
                                   int64_t dim, int64_t shard_count,
@@ -1011,6 +1181,24 @@ void InitXlaModuleBindings(py::module m) {
           result_tuple[1] = new_token;
           return result_tuple;
         });
+  m.def("_xla_reduce_scatter",
+        [](const std::string& reduce_type,
+           const std::vector<at::Tensor>& inputs,
+           const std::shared_ptr<ir::Value>& token, double scale,
+           const std::vector<int64_t>& scatter_dims, int64_t shard_count,
+           const py::list& groups) {
+          std::vector<std::vector<int64_t>> replica_groups =
+              CreateReduceGroups(groups);
+          std::vector<at::Tensor> results;
+          std::shared_ptr<ir::Value> new_token;
+          {
+            NoGilSection nogil;
+            std::tie(results, new_token) = ReduceScatterCoalesced(
+                reduce_type, inputs, token, scale, scatter_dims, shard_count,
+                replica_groups);
+          }
+          return CoalescedResultTuple(inputs, results, new_token);
+        });
   m.def("_xla_reduce_scatter_out",
         [](const std::string& reduce_type, at::Tensor& output,
            const at::Tensor& input, const std::shared_ptr<ir::Value>& token,
@@ -1080,6 +1268,15 @@ void InitXlaModuleBindings(py::module m) {
   });
   m.def("_xla_metrics_report",
         []() { return xla::metrics_reader::CreateMetricReport(); });
+  m.def(
+      "_xla_xrt_metrics_report",
+      [](const std::vector<std::string>& metrics_regex, bool delta) {
+        NoGilSection nogil;
+        return xla::metrics_reader::CreateXrtMetricReport(metrics_regex,
+                                                          delta);
+      },
+      py::arg("metrics_regex") = std::vector<std::string>(),
+      py::arg("delta") = false);
   m.def("_xla_tensors_report",
         [](size_t nodes_threshold, const std::string& device) {
           return GetLiveTensorsReport(nodes_threshold, device);
@@ -1120,6 +1317,27 @@ void InitXlaModuleBindings(py::module m) {
           return RecordReadExample(reader);
         });
 
+  py::class_<ExamplePipeline, std::shared_ptr<ExamplePipeline>>(
+      m, "ExamplePipeline");
+  m.def("_xla_create_tfexample_pipeline",
+        [](std::vector<std::string> files, const py::list& features,
+           int64_t batch_size, const std::string& compression,
+           int64_t buffer_size, int64_t num_readers, int64_t prefetch,
+           bool drop_last, const std::string& device) {
+          return CreateExamplePipeline(std::move(files), features, batch_size,
+                                       compression, buffer_size, num_readers,
+                                       prefetch, drop_last, device);
+        },
+        py::arg("files"), py::arg("features"), py::arg("batch_size"),
+        py::arg("compression") = "",
+        py::arg("buffer_size") = 16 * 1024 * 1024, py::arg("num_readers") = 4,
+        py::arg("prefetch") = 2, py::arg("drop_last") = false,
+        py::arg("device") = "");
+  m.def("_xla_tfexample_pipeline_next",
+        [](const std::shared_ptr<ExamplePipeline>& pipeline) {
+          return ExamplePipelineNext(pipeline);
+        });
+
   py::class_<tensorflow::RandomAccessFile>(m, "TfRdFile");
   m.def("_xla_tffile_open", [](const std::string& path) {
     std::unique_ptr<tensorflow::RandomAccessFile> file;
@@ -1136,6 +1354,11 @@ void InitXlaModuleBindings(py::module m) {
         [](tensorflow::RandomAccessFile* file, uint64_t offset, size_t size) {
           return ReadTfFile(file, offset, size);
         });
+  m.def("_xla_tffile_read_into",
+        [](tensorflow::RandomAccessFile* file, uint64_t offset,
+           const at::Tensor& tensor) {
+          ReadTfFileIntoTensor(file, offset, tensor);
+        });
 
   py::class_<tensorflow::WritableFile>(m, "TfWrFile");
   m.def("_xla_tffile_create", [](const std::string& path) {
@@ -1164,6 +1387,33 @@ void InitXlaModuleBindings(py::module m) {
     RemoveTfFile(path);
   });
 
+  m.def("_xla_save_tensors_stream",
+        [](const std::vector<at::Tensor>& tensors, const std::string& path,
+           int64_t group_bytes) {
+          NoGilSection nogil;
+          SaveTensorsStreaming(tensors, path, group_bytes);
+        },
+        py::arg("tensors"), py::arg("path"),
+        py::arg("group_bytes") = 256 * 1024 * 1024);
+  m.def("_xla_load_tensors_stream",
+        [](const std::string& path, const std::string& device,
+           int64_t group_bytes, bool use_mmap) {
+          std::vector<at::Tensor> result;
+          {
+            NoGilSection nogil;
+            std::vector<at::Tensor> tensors = LoadTensorsStreaming(
+                path, GetOptionalDevice(device), group_bytes, use_mmap);
+            result.reserve(tensors.size());
+            for (auto& tensor : tensors) {
+              result.push_back(torch::autograd::make_variable(tensor));
+            }
+          }
+          return result;
+        },
+        py::arg("path"), py::arg("device") = "",
+        py::arg("group_bytes") = 256 * 1024 * 1024,
+        py::arg("use_mmap") = false);
+
   py::class_<xla::XlaBuilder, op_builder::BuilderPtr>(m, "XlaBuilder");
   py::class_<op_builder::Op, op_builder::OpPtr>(m, "XlaOp");
   py::class_<Computation, ComputationPtr>(m, "XlaComputation");
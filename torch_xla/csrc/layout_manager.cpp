@@ -1,16 +1,21 @@
 #include "torch_xla/csrc/layout_manager.h"
 
 #include <algorithm>
+#include <atomic>
 #include <exception>
 #include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <string>
 #include <unordered_map>
 
+#include "absl/strings/str_join.h"
 #include "absl/strings/str_split.h"
 #include "tensorflow/compiler/xla/shape_util.h"
 #include "tensorflow/compiler/xla/xla_client/debug_macros.h"
+#include "tensorflow/compiler/xla/xla_client/metrics.h"
 #include "tensorflow/compiler/xla/xla_client/sys_util.h"
 #include "tensorflow/compiler/xla/xla_client/tf_logging.h"
 #include "tensorflow/compiler/xla/xla_client/util.h"
@@ -32,7 +37,59 @@ class LayoutManager {
     return it != layouts_.end() ? &it->second->layout : nullptr;
   }
 
+  bool TunerEnabled() const { return tuner_enabled_; }
+
+  bool SetTunerEnabled(bool enabled) {
+    return tuner_enabled_.exchange(enabled);
+  }
+
+  void ClearTunedLayouts() {
+    std::lock_guard<std::mutex> lock(tuned_lock_);
+    tuned_layouts_.clear();
+  }
+
+  bool GetTunedLayout(absl::Span<const int64_t> dimensions,
+                      xla::PrimitiveType type,
+                      std::vector<int64_t>* layout) const {
+    TunedKey key(type, std::vector<int64_t>(dimensions.begin(),
+                                            dimensions.end()));
+    std::lock_guard<std::mutex> lock(tuned_lock_);
+    auto it = tuned_layouts_.find(key);
+    if (it == tuned_layouts_.end()) {
+      return false;
+    }
+    *layout = it->second;
+    return true;
+  }
+
+  void RecordLayout(const xla::Shape& shape) {
+    // Shapes with explicit XLA_LAYOUTS entries are not tuned.
+    if (shape.rank() < 2 || !shape.has_layout() || shape.is_dynamic() ||
+        GetLayout(shape.dimensions()) != nullptr) {
+      return;
+    }
+    TunedKey key(shape.element_type(),
+                 torch::lazy::ToVector<int64_t>(shape.dimensions()));
+    std::vector<int64_t> layout =
+        torch::lazy::ToVector<int64_t>(shape.layout().minor_to_major());
+    std::lock_guard<std::mutex> lock(tuned_lock_);
+    if (tuned_layouts_.size() >= max_tuned_layouts_ &&
+        tuned_layouts_.count(key) == 0) {
+      // Recorded layouts are never evicted, as changing them would change the
+      // graphs using them. Shapes past the limit use the default heuristics.
+      XLA_COUNTER("TunedLayoutsDropped", 1);
+      return;
+    }
+    if (tuned_layouts_.emplace(std::move(key), layout).second) {
+      XLA_COUNTER("TunedLayouts", 1);
+      TF_VLOG(3) << "Tuned layout {" << absl::StrJoin(layout, ",")
+                 << "} for shape " << shape;
+    }
+  }
+
  private:
+  using TunedKey = std::pair<xla::PrimitiveType, std::vector<int64_t>>;
+
   struct LayoutEntry {
     std::vector<int64_t> dimensions;
     std::vector<int64_t> layout;
@@ -48,7 +105,10 @@ class LayoutManager {
       std::unordered_map<absl::Span<const int64_t>,
                          std::shared_ptr<LayoutEntry>, DimensionsHasher>;
 
-  LayoutManager() {
+  LayoutManager()
+      : tuner_enabled_(xla::sys_util::GetEnvBool("XLA_LAYOUT_TUNER", false)),
+        max_tuned_layouts_(
+            xla::sys_util::GetEnvInt("XLA_LAYOUT_TUNER_MAX_SHAPES", 4096)) {
     try {
       PopulateLayouts();
     } catch (const std::exception& ex) {
@@ -103,6 +163,10 @@ class LayoutManager {
   }
 
   LayoutMap layouts_;
+  std::atomic<bool> tuner_enabled_;
+  size_t max_tuned_layouts_ = 0;
+  mutable std::mutex tuned_lock_;
+  std::map<TunedKey, std::vector<int64_t>> tuned_layouts_;
 };
 
 double PaddingFactor(int64_t size, int padding) {
@@ -176,15 +240,44 @@ xla::Shape MakeArrayShapeFromDimensions(
     absl::Span<const int64_t> dimensions,
     absl::Span<const bool> dynamic_dimensions, xla::PrimitiveType type,
     DeviceType device_type) {
-  auto layout_ptr = LayoutManager::Get()->GetLayout(dimensions);
+  LayoutManager* mgr = LayoutManager::Get();
+  auto layout_ptr = mgr->GetLayout(dimensions);
   if (layout_ptr != nullptr) {
     return MakeShapeWithLayout(type, dimensions, dynamic_dimensions,
                                *layout_ptr);
   }
+  std::vector<int64_t> tuned_layout;
+  if (dimensions.size() > 1 && mgr->TunerEnabled() &&
+      mgr->GetTunedLayout(dimensions, type, &tuned_layout)) {
+    return MakeShapeWithLayout(type, dimensions, dynamic_dimensions,
+                               tuned_layout);
+  }
   if (dimensions.size() > 1 && device_type.hw_type == TorchXLADeviceType::TPU) {
     return MakeTpuShape(dimensions, dynamic_dimensions, type);
   }
   return MakeTorchTensorLayout(dimensions, dynamic_dimensions, type);
 }
 
+bool SetLayoutTuner(bool enabled) {
+  return LayoutManager::Get()->SetTunerEnabled(enabled);
+}
+
+void ClearTunedLayouts() { LayoutManager::Get()->ClearTunedLayouts(); }
+
+void RecordCompiledLayouts(const xla::ProgramShape& program_shape) {
+  LayoutManager* mgr = LayoutManager::Get();
+  if (!mgr->TunerEnabled()) {
+    return;
+  }
+  auto record_fn = [&](const xla::Shape& subshape, const xla::ShapeIndex&) {
+    if (subshape.IsArray()) {
+      mgr->RecordLayout(subshape);
+    }
+  };
+  for (auto& parameter : program_shape.parameters()) {
+    xla::ShapeUtil::ForEachSubshape(parameter, record_fn);
+  }
+  xla::ShapeUtil::ForEachSubshape(program_shape.result(), record_fn);
+}
+
 }  // namespace torch_xla
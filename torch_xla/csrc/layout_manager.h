@@ -22,4 +22,20 @@ xla::Shape MakeArrayShapeFromDimensions(
     absl::Span<const bool> dynamic_dimensions, xla::PrimitiveType type,
     DeviceType device_type);
 
+// When the layout tuner is enabled (XLA_LAYOUT_TUNER), records the layouts the
+// compiler picked for the array parameters and results of a computation, so
+// that MakeArrayShapeFromDimensions() returns them for the shapes with the same
+// dimensions and type. Device uploads and requested result shapes then match
+// what the compiled graphs prefer, instead of requiring relayout copies.
+// The first layout recorded for a shape sticks, to keep the graphs (and their
+// compilation cache keys) stable.
+void RecordCompiledLayouts(const xla::ProgramShape& program_shape);
+
+// Enables or disables the layout tuner, overriding XLA_LAYOUT_TUNER, and
+// returns its previous state. Used by tests.
+bool SetLayoutTuner(bool enabled);
+
+// Drops all the layouts recorded by the layout tuner. Used by tests.
+void ClearTunedLayouts();
+
 }  // namespace torch_xla
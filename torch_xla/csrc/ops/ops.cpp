@@ -24,8 +24,10 @@
 #include "torch_xla/csrc/ops/log_softmax_backward.h"
 #include "torch_xla/csrc/ops/permute.h"
 #include "torch_xla/csrc/ops/softmax_backward.h"
+#include "torch_xla/csrc/ops/xla_ops.h"
 #include "torch_xla/csrc/ops/sum.h"
 #include "torch_xla/csrc/pooling.h"
+#include "torch_xla/csrc/random.h"
 #include "torch_xla/csrc/tensor_util.h"
 #include "torch_xla/csrc/torch_util.h"
 #include "torch_xla/csrc/xla_lower_util.h"
@@ -1031,6 +1033,47 @@ NodePtr Softplus(const Value& input, const Value& beta,
                    std::move(lower_fn));
 }
 
+NodePtr CreateToken() {
+  auto lower_fn = [](const Node& node, LoweringContext* loctx) -> XlaOpVector {
+    return node.ReturnOp(xla::CreateToken(loctx->builder()), loctx);
+  };
+  return GenericOp(xla_create_token, xla::ShapeUtil::MakeTokenShape(),
+                   std::move(lower_fn), /*num_outputs=*/1,
+                   /*hash_seed=*/(uint32_t)0x5a2d296e9);
+}
+
+NodePtr RngSeed(const Value& seed, uint64_t offset) {
+  auto lower_fn = [offset](const Node& node,
+                           LoweringContext* loctx) -> XlaOpVector {
+    xla::XlaOp xla_seed = loctx->GetOutputOp(node.operand(0));
+    return node.ReturnOp(MakeCounterSeed(xla_seed, offset), loctx);
+  };
+  return GenericOp(xla_rng_seed, {seed},
+                   xla::ShapeUtil::MakeShape(xla::PrimitiveType::U64, {2}),
+                   std::move(lower_fn), /*num_outputs=*/1,
+                   torch::lazy::MHash(offset));
+}
+
+NodePtr UpdateSlices(const Value& input, absl::Span<const Value> sources,
+                     std::vector<std::vector<int64_t>> base_indices) {
+  XLA_CHECK_EQ(sources.size(), base_indices.size());
+  torch::lazy::hash_t hash_seed = torch::lazy::MHash(base_indices);
+  auto lower_fn = [base_indices](const Node& node,
+                                 LoweringContext* loctx) -> XlaOpVector {
+    xla::XlaOp input = loctx->GetOutputOp(node.operand(0));
+    std::vector<xla::XlaOp> sources;
+    for (size_t i = 0; i < base_indices.size(); ++i) {
+      sources.push_back(loctx->GetOutputOp(node.operand(i + 1)));
+    }
+    return node.ReturnOp(BuildUpdateSlices(input, sources, base_indices),
+                         loctx);
+  };
+  std::vector<Value> operands({input});
+  operands.insert(operands.end(), sources.begin(), sources.end());
+  return GenericOp(xla_update_slices, operands, input.xla_shape(),
+                   std::move(lower_fn), /*num_outputs=*/1, hash_seed);
+}
+
 }  // namespace ops
 }  // namespace ir
 }  // namespace torch_xla
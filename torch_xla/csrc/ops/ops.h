@@ -247,6 +247,19 @@ NodePtr SLogDet(const Value& input);
 
 NodePtr Softplus(const Value& input, const Value& beta, const Value& threshold);
 
+// Creates an XLA token, used to sequence the collective operations.
+NodePtr CreateToken();
+
+// Creates the counter based seed for the random operation at the given offset
+// within the current step, from the step base seed.
+NodePtr RngSeed(const Value& seed, uint64_t offset);
+
+// Writes the sources into input, each one starting at the matching
+// base_indices entry, in order. Equivalent to a chain of UpdateSlice nodes,
+// but within a single IR node, whose adjacent updates are lowered together.
+NodePtr UpdateSlices(const Value& input, absl::Span<const Value> sources,
+                     std::vector<std::vector<int64_t>> base_indices);
+
 }  // namespace ops
 }  // namespace ir
 }  // namespace torch_xla
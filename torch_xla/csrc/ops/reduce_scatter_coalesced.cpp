@@ -0,0 +1,101 @@
+#include "torch_xla/csrc/ops/reduce_scatter_coalesced.h"
+
+#include "absl/strings/str_join.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "torch/csrc/lazy/core/util.h"
+#include "torch_xla/csrc/lowering_context.h"
+#include "torch_xla/csrc/ops/infer_output_shape.h"
+#include "torch_xla/csrc/ops/xla_ops.h"
+
+namespace torch_xla {
+namespace ir {
+namespace ops {
+namespace {
+
+xla::Shape NodeOutputShape(AllReduceType reduce_type,
+                           absl::Span<const Value> inputs, const Value& token,
+                           double scale, absl::Span<const int64_t> scatter_dims,
+                           int64_t shard_count,
+                           const std::vector<std::vector<int64_t>>& groups) {
+  auto shape_fn = [&](absl::Span<const xla::XlaOp> operands) -> xla::XlaOp {
+    std::vector<xla::XlaOp> results = BuildReduceScatterCoalesced(
+        reduce_type, operands.subspan(0, inputs.size()), operands.back(), scale,
+        scatter_dims, shard_count, groups);
+    return xla::Tuple(operands[0].builder(), results);
+  };
+  std::vector<xla::Shape> input_shapes;
+  input_shapes.reserve(inputs.size() + 1);
+  for (auto& input : inputs) {
+    input_shapes.push_back(input.xla_shape());
+  }
+  input_shapes.push_back(token.xla_shape());
+  return InferOutputShape(input_shapes, shape_fn);
+}
+
+std::vector<Value> GetOperandList(absl::Span<const Value> inputs,
+                                  const Value& token) {
+  std::vector<Value> operand_list(inputs.begin(), inputs.end());
+  operand_list.push_back(token);
+  return operand_list;
+}
+
+}  // namespace
+
+ReduceScatterCoalesced::ReduceScatterCoalesced(
+    AllReduceType reduce_type, absl::Span<const Value> inputs,
+    const Value& token, double scale, std::vector<int64_t> scatter_dims,
+    int64_t shard_count, std::vector<std::vector<int64_t>> groups)
+    : Node(xla_reduce_scatter_coalesced, GetOperandList(inputs, token),
+           [&]() {
+             return NodeOutputShape(reduce_type, inputs, token, scale,
+                                    scatter_dims, shard_count, groups);
+           },
+           /*num_outputs=*/inputs.size() + 1,
+           torch::lazy::MHash(torch::lazy::GetEnumValue(reduce_type), scale,
+                              scatter_dims, shard_count, groups)),
+      reduce_type_(reduce_type),
+      scale_(scale),
+      scatter_dims_(std::move(scatter_dims)),
+      shard_count_(shard_count),
+      groups_(std::move(groups)) {}
+
+NodePtr ReduceScatterCoalesced::Clone(OpList operands) const {
+  std::vector<Value> inputs(operands.begin(), operands.end() - 1);
+  return ir::MakeNode<ReduceScatterCoalesced>(reduce_type_, inputs,
+                                              operands.back(), scale_,
+                                              scatter_dims_, shard_count_,
+                                              groups_);
+}
+
+XlaOpVector ReduceScatterCoalesced::Lower(LoweringContext* loctx) const {
+  auto& operand_list = operands();
+  std::vector<xla::XlaOp> inputs;
+  inputs.reserve(operand_list.size());
+  for (size_t i = 0; i + 1 < operand_list.size(); ++i) {
+    inputs.push_back(loctx->GetOutputOp(operand_list[i]));
+  }
+  xla::XlaOp token = loctx->GetOutputOp(operand_list.back());
+  return ReturnOps(BuildReduceScatterCoalesced(reduce_type_, inputs, token,
+                                               scale_, scatter_dims_,
+                                               shard_count_, groups_),
+                   loctx);
+}
+
+std::string ReduceScatterCoalesced::ToString() const {
+  std::stringstream ss;
+  ss << Node::ToString()
+     << ", reduce_type=" << torch::lazy::GetEnumValue(reduce_type_)
+     << ", scale=" << scale_ << ", scatter_dims=("
+     << absl::StrJoin(scatter_dims_, ", ") << "), shard_count=" << shard_count_
+     << ", groups=(";
+  for (size_t i = 0; i < groups_.size(); ++i) {
+    ss << (i == 0 ? "(" : ",(");
+    ss << absl::StrJoin(groups_[i], ", ") << ")";
+  }
+  ss << ")";
+  return ss.str();
+}
+
+}  // namespace ops
+}  // namespace ir
+}  // namespace torch_xla
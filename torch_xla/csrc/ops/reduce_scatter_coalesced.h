@@ -0,0 +1,44 @@
+#pragma once
+
+#include "torch_xla/csrc/cross_replica_reduces.h"
+#include "torch_xla/csrc/ir.h"
+
+namespace torch_xla {
+namespace ir {
+namespace ops {
+
+class ReduceScatterCoalesced : public Node {
+ public:
+  ReduceScatterCoalesced(AllReduceType reduce_type,
+                         absl::Span<const Value> inputs, const Value& token,
+                         double scale, std::vector<int64_t> scatter_dims,
+                         int64_t shard_count,
+                         std::vector<std::vector<int64_t>> groups);
+
+  std::string ToString() const override;
+
+  NodePtr Clone(OpList operands) const override;
+
+  XlaOpVector Lower(LoweringContext* loctx) const override;
+
+  AllReduceType reduce_type() const { return reduce_type_; }
+
+  double scale() const { return scale_; }
+
+  const std::vector<int64_t>& scatter_dims() const { return scatter_dims_; }
+
+  int64_t shard_count() const { return shard_count_; }
+
+  const std::vector<std::vector<int64_t>>& groups() const { return groups_; }
+
+ private:
+  AllReduceType reduce_type_;
+  double scale_;
+  std::vector<int64_t> scatter_dims_;
+  int64_t shard_count_;
+  std::vector<std::vector<int64_t>> groups_;
+};
+
+}  // namespace ops
+}  // namespace ir
+}  // namespace torch_xla
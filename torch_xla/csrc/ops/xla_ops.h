@@ -31,10 +31,12 @@ class OpKindWrapper {
 
 extern const OpKindWrapper xla_adam_optimizer_step;
 extern const OpKindWrapper xla_all_gather;
+extern const OpKindWrapper xla_all_gather_coalesced;
 extern const OpKindWrapper xla_all_to_all;
 extern const OpKindWrapper xla_as_strided_view_update;
 extern const OpKindWrapper xla_cast;
 extern const OpKindWrapper xla_collective_permute;
+extern const OpKindWrapper xla_create_token;
 extern const OpKindWrapper xla_cross_replica_sum;
 extern const OpKindWrapper xla_device_data;
 extern const OpKindWrapper xla_diagonal_view_update;
@@ -44,13 +46,16 @@ extern const OpKindWrapper xla_moving_average;
 extern const OpKindWrapper xla_nms;
 extern const OpKindWrapper xla_not_supported;
 extern const OpKindWrapper xla_reduce_scatter;
+extern const OpKindWrapper xla_reduce_scatter_coalesced;
 extern const OpKindWrapper xla_replication_pad;
 extern const OpKindWrapper xla_replication_pad_backward;
+extern const OpKindWrapper xla_rng_seed;
 extern const OpKindWrapper xla_select;
 extern const OpKindWrapper xla_sgd_optimizer_step;
 extern const OpKindWrapper xla_tensor_data;
 extern const OpKindWrapper xla_unselect;
 extern const OpKindWrapper xla_update_slice;
+extern const OpKindWrapper xla_update_slices;
 
 }  // namespace ops
 }  // namespace ir
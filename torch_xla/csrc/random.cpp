@@ -2,6 +2,7 @@
 
 #include <string>
 #include <tuple>
+#include <utility>
 
 #include "tensorflow/compiler/xla/client/lib/constants.h"
 #include "tensorflow/compiler/xla/client/lib/prng.h"
@@ -43,6 +44,30 @@ xla::XlaOp MakeSeed(xla::XlaOp seed) {
   return xla::ConvertElementType(seed, xla::PrimitiveType::U64);
 }
 
+// Returns the key and the initial state to be fed to the bit generators. The
+// seed is either a scalar, used as key, or a counter based seed created by
+// MakeCounterSeed(), holding a base seed and an offset. The initial state is
+// always zero.
+std::pair<xla::XlaOp, xla::XlaOp> MakeSeedAndState(xla::XlaOp seed) {
+  const xla::Shape& seed_shape = XlaHelpers::ShapeOfXlaOp(seed);
+  xla::XlaOp key;
+  if (seed_shape.rank() == 1) {
+    XLA_CHECK_EQ(seed_shape.dimensions(0), 2) << seed_shape;
+    xla::XlaOp base = xla::Reshape(xla::SliceInDim(seed, 0, 1, 1, 0), {});
+    xla::XlaOp offset = xla::Reshape(xla::SliceInDim(seed, 1, 2, 1, 0), {});
+    // Using the offset as initial state would make the streams of consecutive
+    // operations overlap, as the bit generators advance the state by one for
+    // every block of generated bits. Hash the offset into the key instead, so
+    // that every operation gets an independent stream.
+    key = xla::ScramblePhiloxKey(xla::Xor(MakeSeed(base), MakeSeed(offset)))
+              .second;
+  } else {
+    key = MakeSeed(seed);
+  }
+  return std::make_pair(key,
+                        xla::Zero(seed.builder(), xla::PrimitiveType::U64));
+}
+
 xla::XlaOp MakeUniformBoundaryValue(xla::XlaOp val) {
   xla::PrimitiveType element_type = XlaHelpers::TypeOfXlaOp(val);
   if (element_type == xla::PrimitiveType::BF16 ||
@@ -69,6 +94,11 @@ xla::Shape MakeRngShape(const xla::Shape& shape) {
 
 }  // namespace
 
+xla::XlaOp MakeCounterSeed(xla::XlaOp seed, uint64_t offset) {
+  xla::XlaOp xla_offset = xla::ConstantR0<uint64_t>(seed.builder(), offset);
+  return xla::ConcatScalars(seed.builder(), {MakeSeed(seed), xla_offset});
+}
+
 xla::XlaOp RngDiscreteUniform(xla::XlaOp seed, const xla::Shape& shape,
                               xla::XlaOp minval, xla::XlaOp maxval) {
   xla::PrimitiveType minval_type = XlaHelpers::TypeOfXlaOp(minval);
@@ -80,9 +110,9 @@ xla::XlaOp RngDiscreteUniform(xla::XlaOp seed, const xla::Shape& shape,
             minval_type == xla::PrimitiveType::U32)
       << "RngDiscreteUniform not implemented for type "
       << xla::primitive_util::LowercasePrimitiveTypeName(minval_type);
-  xla::XlaOp rng_seed = MakeSeed(seed);
-  xla::XlaOp initial_state =
-      xla::Zero(rng_seed.builder(), xla::PrimitiveType::U64);
+  xla::XlaOp rng_seed;
+  xla::XlaOp initial_state;
+  std::tie(rng_seed, initial_state) = MakeSeedAndState(seed);
   xla::Shape rng_shape(shape);
   rng_shape.set_element_type(minval_type);
   xla::XlaOp result =
@@ -94,12 +124,12 @@ xla::XlaOp RngDiscreteUniform(xla::XlaOp seed, const xla::Shape& shape,
 
 xla::XlaOp RngUniform(xla::XlaOp seed, const xla::Shape& shape,
                       xla::XlaOp minval, xla::XlaOp maxval) {
-  xla::XlaOp rng_seed = MakeSeed(seed);
+  xla::XlaOp rng_seed;
+  xla::XlaOp initial_state;
+  std::tie(rng_seed, initial_state) = MakeSeedAndState(seed);
   xla::Shape rng_shape = MakeRngShape(shape);
   xla::XlaOp rng_minval = MakeUniformBoundaryValue(minval);
   xla::XlaOp rng_maxval = MakeUniformBoundaryValue(maxval);
-  xla::XlaOp initial_state =
-      xla::Zero(rng_seed.builder(), xla::PrimitiveType::U64);
   switch (shape.element_type()) {
     case xla::PrimitiveType::F16:
     case xla::PrimitiveType::BF16: {
@@ -147,10 +177,10 @@ xla::XlaOp RngUniform(xla::XlaOp seed, const xla::Shape& shape,
 
 xla::XlaOp RngNormal(xla::XlaOp seed, const xla::Shape& shape, xla::XlaOp mean,
                      xla::XlaOp std) {
-  xla::XlaOp rng_seed = MakeSeed(seed);
+  xla::XlaOp rng_seed;
+  xla::XlaOp initial_state;
+  std::tie(rng_seed, initial_state) = MakeSeedAndState(seed);
   xla::Shape rng_shape = MakeRngShape(shape);
-  xla::XlaOp initial_state =
-      xla::Zero(rng_seed.builder(), xla::PrimitiveType::U64);
   switch (shape.element_type()) {
     case xla::PrimitiveType::F16:
     case xla::PrimitiveType::BF16: {
@@ -4,6 +4,12 @@
 
 namespace torch_xla {
 
+// Creates a counter based seed (a U64[2] holding the seed and the offset) which
+// the APIs below hash into the key fed to the bit generators. Random
+// operations using the same seed with different offsets generate independent
+// streams, without having to derive a new seed for each of them.
+xla::XlaOp MakeCounterSeed(xla::XlaOp seed, uint64_t offset);
+
 xla::XlaOp RngUniform(xla::XlaOp seed, const xla::Shape& shape,
                       xla::XlaOp minval, xla::XlaOp maxval);
 
@@ -0,0 +1,409 @@
+#include "torch_xla/csrc/simd_convert.h"
+
+#include <cmath>
+#include <cstring>
+#include <string>
+
+#include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/compiler/xla/xla_client/debug_macros.h"
+#include "tensorflow/compiler/xla/xla_client/sys_util.h"
+#include "tensorflow/compiler/xla/xla_client/tf_logging.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define XLA_SIMD_CONVERT_X86 1
+#include <immintrin.h>
+#endif
+
+namespace torch_xla {
+namespace simd {
+namespace {
+
+uint16_t F32ToBF16Bits(float value) {
+  if (std::isnan(value)) {
+    return 0x7fc0;
+  }
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  uint32_t lsb = (bits >> 16) & 1;
+  return static_cast<uint16_t>((bits + 0x7fff + lsb) >> 16);
+}
+
+void F32ToBF16Scalar(const float* src, uint16_t* dest, int64_t n) {
+  for (int64_t i = 0; i < n; ++i) {
+    dest[i] = F32ToBF16Bits(src[i]);
+  }
+}
+
+void BF16ToF32Scalar(const uint16_t* src, float* dest, int64_t n) {
+  for (int64_t i = 0; i < n; ++i) {
+    uint32_t bits = static_cast<uint32_t>(src[i]) << 16;
+    std::memcpy(dest + i, &bits, sizeof(bits));
+  }
+}
+
+void F32ToF16Scalar(const float* src, uint16_t* dest, int64_t n) {
+  for (int64_t i = 0; i < n; ++i) {
+    xla::half value(src[i]);
+    std::memcpy(dest + i, &value, sizeof(value));
+  }
+}
+
+void F16ToF32Scalar(const uint16_t* src, float* dest, int64_t n) {
+  for (int64_t i = 0; i < n; ++i) {
+    xla::half value;
+    std::memcpy(&value, src + i, sizeof(value));
+    dest[i] = static_cast<float>(value);
+  }
+}
+
+void S64ToS32Scalar(const int64_t* src, int32_t* dest, int64_t n) {
+  for (int64_t i = 0; i < n; ++i) {
+    dest[i] = static_cast<int32_t>(src[i]);
+  }
+}
+
+void S32ToS64Scalar(const int32_t* src, int64_t* dest, int64_t n) {
+  for (int64_t i = 0; i < n; ++i) {
+    dest[i] = static_cast<int64_t>(src[i]);
+  }
+}
+
+void Transpose32Scalar(const uint32_t* src, int64_t src_stride,
+                       uint32_t* dest, int64_t dest_stride, int64_t rows,
+                       int64_t cols) {
+  for (int64_t i = 0; i < rows; ++i) {
+    for (int64_t j = 0; j < cols; ++j) {
+      dest[j * dest_stride + i] = src[i * src_stride + j];
+    }
+  }
+}
+
+#if defined(XLA_SIMD_CONVERT_X86)
+
+// The kernels below are compiled for their target instruction set using
+// function attributes, so that the rest of the library does not require any
+// special compiler flag. Tails which do not fill a vector register are
+// handled by the scalar kernels.
+
+__attribute__((target("avx2"))) __m256i F32ToBF16x8(__m256 value) {
+  __m256i bits = _mm256_castps_si256(value);
+  __m256i lsb =
+      _mm256_and_si256(_mm256_srli_epi32(bits, 16), _mm256_set1_epi32(1));
+  __m256i rounded = _mm256_srli_epi32(
+      _mm256_add_epi32(_mm256_add_epi32(bits, _mm256_set1_epi32(0x7fff)), lsb),
+      16);
+  __m256 nan_mask = _mm256_cmp_ps(value, value, _CMP_UNORD_Q);
+  return _mm256_blendv_epi8(rounded, _mm256_set1_epi32(0x7fc0),
+                            _mm256_castps_si256(nan_mask));
+}
+
+__attribute__((target("avx2"))) void F32ToBF16Avx2(const float* src,
+                                                    uint16_t* dest, int64_t n) {
+  int64_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256i low = F32ToBF16x8(_mm256_loadu_ps(src + i));
+    __m256i high = F32ToBF16x8(_mm256_loadu_ps(src + i + 8));
+    // The pack works within 128 bit lanes, so the 64 bit blocks need to be
+    // reordered afterwards.
+    __m256i packed =
+        _mm256_permute4x64_epi64(_mm256_packus_epi32(low, high), 0xd8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i), packed);
+  }
+  F32ToBF16Scalar(src + i, dest + i, n - i);
+}
+
+__attribute__((target("avx2"))) void BF16ToF32Avx2(const uint16_t* src,
+                                                    float* dest, int64_t n) {
+  int64_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    __m256i bits = _mm256_slli_epi32(_mm256_cvtepu16_epi32(value), 16);
+    _mm256_storeu_ps(dest + i, _mm256_castsi256_ps(bits));
+  }
+  BF16ToF32Scalar(src + i, dest + i, n - i);
+}
+
+__attribute__((target("avx2,f16c"))) void F32ToF16Avx2(const float* src,
+                                                        uint16_t* dest,
+                                                        int64_t n) {
+  int64_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i value =
+        _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), value);
+  }
+  F32ToF16Scalar(src + i, dest + i, n - i);
+}
+
+__attribute__((target("avx2,f16c"))) void F16ToF32Avx2(const uint16_t* src,
+                                                        float* dest,
+                                                        int64_t n) {
+  int64_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    _mm256_storeu_ps(dest + i, _mm256_cvtph_ps(value));
+  }
+  F16ToF32Scalar(src + i, dest + i, n - i);
+}
+
+__attribute__((target("avx2"))) void S64ToS32Avx2(const int64_t* src,
+                                                   int32_t* dest, int64_t n) {
+  // Selects the low 32 bits of each 64 bit value into the lower 128 bits.
+  const __m256i low_words = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+  int64_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256i value =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    __m256i packed = _mm256_permutevar8x32_epi32(value, low_words);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i),
+                     _mm256_castsi256_si128(packed));
+  }
+  S64ToS32Scalar(src + i, dest + i, n - i);
+}
+
+__attribute__((target("avx2"))) void S32ToS64Avx2(const int32_t* src,
+                                                   int64_t* dest, int64_t n) {
+  int64_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i),
+                        _mm256_cvtepi32_epi64(value));
+  }
+  S32ToS64Scalar(src + i, dest + i, n - i);
+}
+
+__attribute__((target("avx512f"))) void F32ToBF16Avx512(const float* src,
+                                                         uint16_t* dest,
+                                                         int64_t n) {
+  const __m512i one = _mm512_set1_epi32(1);
+  const __m512i bias = _mm512_set1_epi32(0x7fff);
+  const __m512i nan_value = _mm512_set1_epi32(0x7fc0);
+  int64_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512 value = _mm512_loadu_ps(src + i);
+    __m512i bits = _mm512_castps_si512(value);
+    __m512i lsb = _mm512_and_si512(_mm512_srli_epi32(bits, 16), one);
+    __m512i rounded = _mm512_srli_epi32(
+        _mm512_add_epi32(_mm512_add_epi32(bits, bias), lsb), 16);
+    __mmask16 nan_mask = _mm512_cmp_ps_mask(value, value, _CMP_UNORD_Q);
+    rounded = _mm512_mask_blend_epi32(nan_mask, rounded, nan_value);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i),
+                        _mm512_cvtepi32_epi16(rounded));
+  }
+  F32ToBF16Scalar(src + i, dest + i, n - i);
+}
+
+__attribute__((target("avx512f"))) void BF16ToF32Avx512(const uint16_t* src,
+                                                         float* dest,
+                                                         int64_t n) {
+  int64_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256i value =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    __m512i bits = _mm512_slli_epi32(_mm512_cvtepu16_epi32(value), 16);
+    _mm512_storeu_ps(dest + i, _mm512_castsi512_ps(bits));
+  }
+  BF16ToF32Scalar(src + i, dest + i, n - i);
+}
+
+__attribute__((target("avx512f"))) void F32ToF16Avx512(const float* src,
+                                                        uint16_t* dest,
+                                                        int64_t n) {
+  int64_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256i value =
+        _mm512_cvtps_ph(_mm512_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i), value);
+  }
+  F32ToF16Scalar(src + i, dest + i, n - i);
+}
+
+__attribute__((target("avx512f"))) void F16ToF32Avx512(const uint16_t* src,
+                                                        float* dest,
+                                                        int64_t n) {
+  int64_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256i value =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    _mm512_storeu_ps(dest + i, _mm512_cvtph_ps(value));
+  }
+  F16ToF32Scalar(src + i, dest + i, n - i);
+}
+
+__attribute__((target("avx512f"))) void S64ToS32Avx512(const int64_t* src,
+                                                        int32_t* dest,
+                                                        int64_t n) {
+  int64_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m512i value =
+        _mm512_loadu_si512(reinterpret_cast<const __m512i*>(src + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i),
+                        _mm512_cvtepi64_epi32(value));
+  }
+  S64ToS32Scalar(src + i, dest + i, n - i);
+}
+
+__attribute__((target("avx512f"))) void S32ToS64Avx512(const int32_t* src,
+                                                        int64_t* dest,
+                                                        int64_t n) {
+  int64_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i value =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    _mm512_storeu_si512(reinterpret_cast<__m512i*>(dest + i),
+                        _mm512_cvtepi32_epi64(value));
+  }
+  S32ToS64Scalar(src + i, dest + i, n - i);
+}
+
+// Transposes an 8x8 block of 32 bit elements within registers.
+__attribute__((target("avx2"))) void Transpose8x8Avx2(const uint32_t* src,
+                                                      int64_t src_stride,
+                                                      uint32_t* dest,
+                                                      int64_t dest_stride) {
+  __m256 r[8];
+  for (int i = 0; i < 8; ++i) {
+    r[i] = _mm256_loadu_ps(reinterpret_cast<const float*>(src) +
+                           i * src_stride);
+  }
+  __m256 t0 = _mm256_unpacklo_ps(r[0], r[1]);
+  __m256 t1 = _mm256_unpackhi_ps(r[0], r[1]);
+  __m256 t2 = _mm256_unpacklo_ps(r[2], r[3]);
+  __m256 t3 = _mm256_unpackhi_ps(r[2], r[3]);
+  __m256 t4 = _mm256_unpacklo_ps(r[4], r[5]);
+  __m256 t5 = _mm256_unpackhi_ps(r[4], r[5]);
+  __m256 t6 = _mm256_unpacklo_ps(r[6], r[7]);
+  __m256 t7 = _mm256_unpackhi_ps(r[6], r[7]);
+  __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+  r[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+  r[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+  r[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+  r[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+  r[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+  r[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+  r[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+  r[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+  for (int i = 0; i < 8; ++i) {
+    _mm256_storeu_ps(reinterpret_cast<float*>(dest) + i * dest_stride, r[i]);
+  }
+}
+
+__attribute__((target("avx2"))) void Transpose32Avx2(const uint32_t* src,
+                                                     int64_t src_stride,
+                                                     uint32_t* dest,
+                                                     int64_t dest_stride,
+                                                     int64_t rows,
+                                                     int64_t cols) {
+  int64_t full_rows = rows - rows % 8;
+  int64_t full_cols = cols - cols % 8;
+  for (int64_t i = 0; i < full_rows; i += 8) {
+    for (int64_t j = 0; j < full_cols; j += 8) {
+      Transpose8x8Avx2(src + i * src_stride + j, src_stride,
+                       dest + j * dest_stride + i, dest_stride);
+    }
+  }
+  Transpose32Scalar(src + full_cols, src_stride, dest + full_cols * dest_stride,
+                    dest_stride, rows, cols - full_cols);
+  Transpose32Scalar(src + full_rows * src_stride, src_stride, dest + full_rows,
+                    dest_stride, rows - full_rows, full_cols);
+}
+
+#endif  // XLA_SIMD_CONVERT_X86
+
+const ConvertKernels kScalarKernels = {
+    Isa::kScalar,    F32ToBF16Scalar, BF16ToF32Scalar, F32ToF16Scalar,
+    F16ToF32Scalar,  S64ToS32Scalar,  S32ToS64Scalar,  Transpose32Scalar,
+};
+
+#if defined(XLA_SIMD_CONVERT_X86)
+const ConvertKernels kAvx2Kernels = {
+    Isa::kAvx2,   F32ToBF16Avx2, BF16ToF32Avx2, F32ToF16Avx2,
+    F16ToF32Avx2, S64ToS32Avx2,  S32ToS64Avx2,  Transpose32Avx2,
+};
+
+const ConvertKernels kAvx512Kernels = {
+    Isa::kAvx512,   F32ToBF16Avx512, BF16ToF32Avx512, F32ToF16Avx512,
+    F16ToF32Avx512, S64ToS32Avx512,  S32ToS64Avx512,
+    // The 8x8 in-register transpose is already bound by the memory accesses.
+    Transpose32Avx2,
+};
+#endif  // XLA_SIMD_CONVERT_X86
+
+bool IsaSupported(Isa isa) {
+  switch (isa) {
+    case Isa::kScalar:
+      return true;
+#if defined(XLA_SIMD_CONVERT_X86)
+    case Isa::kAvx2:
+      // All the CPUs shipping AVX2 also have F16C.
+      return __builtin_cpu_supports("avx2");
+    case Isa::kAvx512:
+      return __builtin_cpu_supports("avx512f");
+#endif  // XLA_SIMD_CONVERT_X86
+    default:
+      return false;
+  }
+}
+
+const ConvertKernels* SelectConvertKernels() {
+  std::string isa_name =
+      xla::sys_util::GetEnvString("XLA_SIMD_CONVERT_ISA", "");
+  for (Isa isa : {Isa::kAvx512, Isa::kAvx2, Isa::kScalar}) {
+    if (!isa_name.empty() && isa_name != IsaName(isa)) {
+      continue;
+    }
+    const ConvertKernels* kernels = GetConvertKernels(isa);
+    if (kernels != nullptr) {
+      TF_VLOG(1) << "Using " << IsaName(isa) << " conversion kernels";
+      return kernels;
+    }
+  }
+  XLA_ERROR() << "Conversion kernels not available: " << isa_name;
+}
+
+}  // namespace
+
+const ConvertKernels& GetConvertKernels() {
+  static const ConvertKernels* kernels = SelectConvertKernels();
+  return *kernels;
+}
+
+const ConvertKernels* GetConvertKernels(Isa isa) {
+  if (!IsaSupported(isa)) {
+    return nullptr;
+  }
+  switch (isa) {
+    case Isa::kScalar:
+      return &kScalarKernels;
+#if defined(XLA_SIMD_CONVERT_X86)
+    case Isa::kAvx2:
+      return &kAvx2Kernels;
+    case Isa::kAvx512:
+      return &kAvx512Kernels;
+#endif  // XLA_SIMD_CONVERT_X86
+    default:
+      return nullptr;
+  }
+}
+
+const char* IsaName(Isa isa) {
+  switch (isa) {
+    case Isa::kScalar:
+      return "scalar";
+    case Isa::kAvx2:
+      return "avx2";
+    case Isa::kAvx512:
+      return "avx512";
+  }
+  return "unknown";
+}
+
+}  // namespace simd
+}  // namespace torch_xla
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+namespace torch_xla {
+namespace simd {
+
+// The instruction sets the conversion kernels can be built for. The best one
+// supported by the host CPU is selected at runtime, unless overridden with the
+// XLA_SIMD_CONVERT_ISA environment variable (scalar, avx2 or avx512).
+enum class Isa {
+  kScalar,
+  kAvx2,
+  kAvx512,
+};
+
+// Contiguous element type conversion kernels. The 16 bit floating point types
+// are passed as their raw bits. Conversions to BF16 and F16 use IEEE round to
+// nearest even, and conversions from S64 to S32 truncate like static_cast<>.
+struct ConvertKernels {
+  Isa isa;
+  void (*f32_to_bf16)(const float* src, uint16_t* dest, int64_t n);
+  void (*bf16_to_f32)(const uint16_t* src, float* dest, int64_t n);
+  void (*f32_to_f16)(const float* src, uint16_t* dest, int64_t n);
+  void (*f16_to_f32)(const uint16_t* src, float* dest, int64_t n);
+  void (*s64_to_s32)(const int64_t* src, int32_t* dest, int64_t n);
+  void (*s32_to_s64)(const int32_t* src, int64_t* dest, int64_t n);
+  // Transposes a rows x cols block of 32 bit elements, storing the element at
+  // src[i * src_stride + j] into dest[j * dest_stride + i]. Used by the tiled
+  // copies between tensors with different layouts.
+  void (*transpose_32)(const uint32_t* src, int64_t src_stride,
+                       uint32_t* dest, int64_t dest_stride, int64_t rows,
+                       int64_t cols);
+};
+
+// Returns the kernels selected for the host CPU.
+const ConvertKernels& GetConvertKernels();
+
+// Returns the kernels for the given instruction set, or nullptr if the host CPU
+// does not support it. Used by tests and benchmarks.
+const ConvertKernels* GetConvertKernels(Isa isa);
+
+const char* IsaName(Isa isa);
+
+}  // namespace simd
+}  // namespace torch_xla
@@ -80,6 +80,7 @@ class DeviceLocker {
   const Device& device() const { return device_; }
 
   void Lock() {
+    xla::env::ScopedBlockingWait blocking_wait;
     std::unique_lock<std::mutex> lock(mutex_);
     cv_.wait(lock, [this] { return !locked_; });
     CheckResetException();
@@ -94,6 +95,7 @@ class DeviceLocker {
   }
 
   void Barrier() {
+    xla::env::ScopedBlockingWait blocking_wait;
     std::unique_lock<std::mutex> lock(mutex_);
     cv_.wait(lock, [this] { return !locked_; });
     cv_.notify_all();
@@ -275,6 +277,9 @@ class XLATensor::DeviceContextArena {
     uint64_t seed = 101;
     uint64_t running_seed = 101;
     ir::Value seed_ir_value;
+    // The offset of the next random operation within the step, in counter
+    // based RNG mode.
+    uint64_t seed_offset = 0;
   };
 
  public:
@@ -318,6 +323,8 @@ class XLATensor::DeviceContextArena {
     static const uint64_t kSeedAdd = 2531011;
     static bool transfer_async =
         xla::sys_util::GetEnvBool("XLA_TRANSFER_SEED_ASYNC", false);
+    static bool counter_rng =
+        xla::sys_util::GetEnvBool("XLA_RNG_COUNTER_MODE", false);
     DeviceContext* devctx = GetDeviceContext(device);
     std::lock_guard<std::mutex> lock(devctx->lock);
     if (!devctx->seed_ir_value) {
@@ -327,6 +334,13 @@ class XLATensor::DeviceContextArena {
     // Keep the running seed as scalar as well, so we can return it directly
     // without executing graphs.
     devctx->running_seed = kSeedAdd + kSeedMul * devctx->running_seed;
+    if (counter_rng) {
+      // Every random operation gets the step seed, plus its own constant
+      // offset, instead of a seed derived from the previous one. This keeps
+      // the seed computations out of the graph, and the random operations
+      // independent from each other.
+      return ir::ops::RngSeed(devctx->seed_ir_value, devctx->seed_offset++);
+    }
     // Compose new seeds from the root seed, to avoid creating too many XLA
     // computation parameters which might overflow the TPU capacity.
     ir::Value k = ir::ops::ScalarOp(MakeIntScalar(kSeedMul),
@@ -349,6 +363,7 @@ class XLATensor::DeviceContextArena {
     devctx->seed = seed;
     devctx->running_seed = devctx->seed;
     devctx->seed_ir_value = ir::Value();
+    devctx->seed_offset = 0;
   }
 
   void MarkStep(const Device& device) {
@@ -357,6 +372,7 @@ class XLATensor::DeviceContextArena {
     devctx->seed = 1012031 + devctx->seed * 7012063;
     devctx->running_seed = devctx->seed;
     devctx->seed_ir_value = ir::Value();
+    devctx->seed_offset = 0;
   }
 
  private:
@@ -610,6 +626,7 @@ void XLATensor::SetXlaData(xla::ComputationClient::DataPtr xla_data) {
 
 void XLATensor::SetXlaData(xla::ComputationClient::DataPtr xla_data,
                            bool sync) {
+  UpdateShapeGeneration(xla_data->shape().dimensions());
   data()->xla_data = std::move(xla_data);
   // Assigning a device data should always clear the IR node, to allow graph
   // trimming. A view cannot be reset though, unless we are at a step-end sync.
@@ -621,6 +638,7 @@ void XLATensor::SetXlaData(xla::ComputationClient::DataPtr xla_data,
 }
 
 void XLATensor::SetIrValue(ir::Value ir_value, bool inplace) {
+  UpdateShapeGeneration(ir_value.xla_shape().dimensions());
   data()->xla_data = nullptr;
   data()->tensor_data = c10::nullopt;
   if (data()->view != nullptr && inplace) {
@@ -630,9 +648,10 @@ void XLATensor::SetIrValue(ir::Value ir_value, bool inplace) {
     data()->view = UpdateView(data()->view, std::move(ir_value));
     data()->generation += 1;
   } else {
-    // Reset the view if we are not within an in-place execution context
+    // Reset the view if we are not within an in-place execution context. The
+    // generation is left growing (AssignIrValue() bumps it), as resetting it
+    // could make the tensor impl miss a shape change.
     data()->view = nullptr;
-    data()->generation = 1;
     AssignIrValue(std::move(ir_value));
     TryLimitGraphSize();
   }
@@ -656,6 +675,17 @@ void XLATensor::AssignIrValue(ir::Value ir_value) const {
   data()->generation += 1;
 }
 
+void XLATensor::UpdateShapeGeneration(
+    absl::Span<const int64_t> dimensions) const {
+  // A tensor without data (like one whose view has just been dropped) is
+  // conservatively considered as changing shape.
+  bool has_shape = data()->view != nullptr || data()->xla_data != nullptr ||
+                   data()->ir_value || data()->tensor_data;
+  if (!has_shape || shape().get().dimensions() != dimensions) {
+    data()->shape_generation += 1;
+  }
+}
+
 void XLATensor::TryLimitGraphSize() {
   static const size_t kCheckFrequency =
       xla::sys_util::GetEnvInt("XLA_TRIM_GRAPH_CHECK_FREQUENCY", 5000);
@@ -701,6 +731,8 @@ ir::Value XLATensor::CurrentIrValue() const {
 }
 
 void XLATensor::SetTensorData(at::Tensor tensor_data) {
+  UpdateShapeGeneration(absl::Span<const int64_t>(tensor_data.sizes().data(),
+                                                  tensor_data.sizes().size()));
   data()->tensor_data = std::move(tensor_data);
 }
 
@@ -821,6 +853,7 @@ std::shared_ptr<View> XLATensor::UpdateView(std::shared_ptr<View> view,
 }
 
 void XLATensor::SetSubView(ViewInfo view_info) const {
+  UpdateShapeGeneration(view_info.shape.dimensions());
   data()->view = data()->view->CreateSubView(view_info.shape, view_info);
   data()->generation += 1;
 }
@@ -834,6 +867,7 @@ void XLATensor::ModifyCurrentView(ViewInfo view_info) const {
   // in place, we need to turn this existing tensor into a view.
   ir::Value ir_value = GetIrValue();
   std::shared_ptr<Alias> alias = std::make_shared<Alias>(ir_value);
+  UpdateShapeGeneration(view_info.shape.dimensions());
   data()->view =
       std::make_shared<View>(view_info.shape, alias, std::move(view_info));
   AssignIrValue(ir::Value());
@@ -1635,6 +1669,7 @@ XLATensor::CompilationResult XLATensor::Compile(
              computations.front()->computation().proto().SerializeAsString()));
   XLA_CHECK_EQ(program_shape.parameters_size(),
                po_data->parameters_data.size());
+  RecordCompiledLayouts(computations.front()->compiled_program_shape());
 
   return {/*device=*/coll.device,
           /*emitted_nodes=*/lowering_ctx.GetEmittedNodeCount(),
@@ -46,6 +46,9 @@ class XLATensor {
 
   size_t generation() const { return data()->generation; }
 
+  // Changes only when the dimensions of the tensor change, unlike generation().
+  size_t shape_generation() const { return data()->shape_generation; }
+
   XLATensor alias() const { return XLATensor(data_ptr()); }
 
   int64_t size(int64_t dim) const;
@@ -232,6 +235,12 @@ class XLATensor {
                                       int64_t scatter_dim, int64_t shard_count,
                                       std::vector<std::vector<int64_t>> groups);
 
+  static std::pair<std::vector<XLATensor>, ir::Value> reduce_scatter(
+      const std::vector<XLATensor>& inputs, const ir::Value& token,
+      AllReduceType reduce_type, double scale,
+      std::vector<int64_t> scatter_dims, int64_t shard_count,
+      std::vector<std::vector<int64_t>> groups);
+
   static std::pair<XLATensor, ir::Value> all_to_all(
       const XLATensor& input, const ir::Value& token, int64_t split_dimension,
       int64_t concat_dimension, int64_t split_count,
@@ -246,6 +255,11 @@ class XLATensor {
                                   int64_t shard_count,
                                   std::vector<std::vector<int64_t>> groups);
 
+  static std::pair<std::vector<XLATensor>, ir::Value> all_gather(
+      const std::vector<XLATensor>& inputs, const ir::Value& token,
+      std::vector<int64_t> dims, int64_t shard_count,
+      std::vector<std::vector<int64_t>> groups);
+
   static std::pair<XLATensor, ir::Value> collective_permute(
       const XLATensor& input, const ir::Value& token,
       std::vector<std::pair<int64_t, int64_t>> source_target_pairs);
@@ -1302,6 +1316,7 @@ class XLATensor {
     const Device device;
     const int64_t unique_id = 0;
     size_t generation = 1;
+    size_t shape_generation = 1;
   };
 
   XLATensor(const at::Tensor& tensor, const Device& device);
@@ -1328,6 +1343,10 @@ class XLATensor {
 
   void AssignIrValue(ir::Value ir_value) const;
 
+  // Bumps the shape generation if dimensions differ from the current ones.
+  // Must be called before the tensor data is updated.
+  void UpdateShapeGeneration(absl::Span<const int64_t> dimensions) const;
+
   void SetTensorData(at::Tensor tensor_data);
 
   ir::Value CreateTensorNode(xla::ComputationClient::DataPtr data,
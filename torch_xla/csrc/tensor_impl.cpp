@@ -129,20 +129,24 @@ int64_t XLATensorImpl::size(int64_t d) const {
 }
 
 void XLATensorImpl::SetupSizeProperties() {
-  size_t generation = tensor_.generation();
+  // The shape generation only changes with the dimensions of the tensor, while
+  // the tensor generation also changes with every in-place operation and with
+  // the device data assigned at step boundaries. So the common updates do not
+  // need to fetch the tensor shape at all.
+  size_t generation = tensor_.shape_generation();
   if (generation != generation_) {
     // Fill up the basic dimension data members which the base class
     // implementation uses in its APIs.
     auto shape = tensor_.shape();
-    c10::SmallVector<int64_t, 5> updated_sizes;
+    absl::Span<const int64_t> dimensions = shape.get().dimensions();
     numel_ = 1;
-    for (auto dim : shape.get().dimensions()) {
-      updated_sizes.push_back(dim);
+    for (auto dim : dimensions) {
       numel_ *= dim;
     }
-    sizes_and_strides_.set_sizes(updated_sizes);
+    sizes_and_strides_.set_sizes(
+        c10::IntArrayRef(dimensions.data(), dimensions.size()));
     auto updated_strides = torch::lazy::ComputeArrayStrides(
-        torch::lazy::ToVector<int64_t>(shape.get().dimensions()));
+        c10::IntArrayRef(dimensions.data(), dimensions.size()));
     for (int i = 0; i < updated_strides.size(); i++) {
       sizes_and_strides_.stride_at_unchecked(i) = updated_strides[i];
     }
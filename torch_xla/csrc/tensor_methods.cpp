@@ -25,6 +25,7 @@
 #include "torch_xla/csrc/ops/adaptive_max_pool2d.h"
 #include "torch_xla/csrc/ops/all.h"
 #include "torch_xla/csrc/ops/all_gather.h"
+#include "torch_xla/csrc/ops/all_gather_coalesced.h"
 #include "torch_xla/csrc/ops/all_reduce.h"
 #include "torch_xla/csrc/ops/all_to_all.h"
 #include "torch_xla/csrc/ops/amax.h"
@@ -103,6 +104,7 @@
 #include "torch_xla/csrc/ops/put.h"
 #include "torch_xla/csrc/ops/qr.h"
 #include "torch_xla/csrc/ops/reduce_scatter.h"
+#include "torch_xla/csrc/ops/reduce_scatter_coalesced.h"
 #include "torch_xla/csrc/ops/reflection_pad2d.h"
 #include "torch_xla/csrc/ops/reflection_pad2d_backward.h"
 #include "torch_xla/csrc/ops/repeat.h"
@@ -396,6 +398,26 @@ ir::Value XLATensor::reduce_scatter_out(
   return ir::Value(node, 1);
 }
 
+std::pair<std::vector<XLATensor>, ir::Value> XLATensor::reduce_scatter(
+    const std::vector<XLATensor>& inputs, const ir::Value& token,
+    AllReduceType reduce_type, double scale, std::vector<int64_t> scatter_dims,
+    int64_t shard_count, std::vector<std::vector<int64_t>> groups) {
+  std::vector<ir::Value> input_values;
+  input_values.reserve(inputs.size());
+  for (auto& input : inputs) {
+    input_values.push_back(input.GetIrValue());
+  }
+  ir::NodePtr node = ir::MakeNode<ir::ops::ReduceScatterCoalesced>(
+      reduce_type, input_values, token, scale, std::move(scatter_dims),
+      shard_count, std::move(groups));
+  std::vector<XLATensor> results;
+  results.reserve(inputs.size());
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    results.push_back(inputs[i].CreateFrom(ir::Value(node, i)));
+  }
+  return {std::move(results), ir::Value(node, inputs.size())};
+}
+
 std::pair<XLATensor, ir::Value> XLATensor::all_to_all(
     const XLATensor& input, const ir::Value& token, int64_t split_dimension,
     int64_t concat_dimension, int64_t split_count,
@@ -424,6 +446,25 @@ ir::Value XLATensor::all_gather_out(XLATensor& output, const XLATensor& input,
   return ir::Value(node, 1);
 }
 
+std::pair<std::vector<XLATensor>, ir::Value> XLATensor::all_gather(
+    const std::vector<XLATensor>& inputs, const ir::Value& token,
+    std::vector<int64_t> dims, int64_t shard_count,
+    std::vector<std::vector<int64_t>> groups) {
+  std::vector<ir::Value> input_values;
+  input_values.reserve(inputs.size());
+  for (auto& input : inputs) {
+    input_values.push_back(input.GetIrValue());
+  }
+  ir::NodePtr node = ir::MakeNode<ir::ops::AllGatherCoalesced>(
+      input_values, token, std::move(dims), shard_count, std::move(groups));
+  std::vector<XLATensor> results;
+  results.reserve(inputs.size());
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    results.push_back(inputs[i].CreateFrom(ir::Value(node, i)));
+  }
+  return {std::move(results), ir::Value(node, inputs.size())};
+}
+
 std::pair<XLATensor, ir::Value> XLATensor::collective_permute(
     const XLATensor& input, const ir::Value& token,
     std::vector<std::pair<int64_t, int64_t>> source_target_pairs) {
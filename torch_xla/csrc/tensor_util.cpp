@@ -4,14 +4,18 @@
 #include <ATen/Functions.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <functional>
 #include <list>
+#include <memory>
 #include <numeric>
 #include <thread>
+#include <type_traits>
 
 #include "tensorflow/compiler/xla/literal_util.h"
 #include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/compiler/xla/xla_client/debug_macros.h"
 #include "tensorflow/compiler/xla/xla_client/multi_wait.h"
 #include "tensorflow/compiler/xla/xla_client/sys_util.h"
@@ -24,6 +28,7 @@
 #include "torch/csrc/lazy/core/util.h"
 #include "torch_xla/csrc/helpers.h"
 #include "torch_xla/csrc/layout_manager.h"
+#include "torch_xla/csrc/simd_convert.h"
 #include "torch_xla/csrc/torch_util.h"
 
 namespace torch_xla {
@@ -272,13 +277,13 @@ struct Caster<std::complex<double>> {
 };
 
 // Copies n bytes from source to dest, with different stride values for source
-// and destination.
+// and destination. The source stride can be zero, for expanded tensors.
 template <typename S, typename D>
 void StridedCopy(D* dest, int64_t dest_stride, const S* source,
                  int64_t source_stride, int64_t n) {
   Caster<S> caster;
-  const S* source_top = source + n * source_stride;
-  for (; source < source_top; dest += dest_stride, source += source_stride) {
+  for (int64_t i = 0; i < n;
+       ++i, dest += dest_stride, source += source_stride) {
     *dest = caster.template cast<D>(*source);
   }
 }
@@ -378,6 +383,46 @@ void CopyData<tensorflow::bfloat16, at::BFloat16>(tensorflow::bfloat16* dest,
   CheckedMemcpy<tensorflow::bfloat16, at::BFloat16>(dest, source, n);
 }
 
+// The most common conversions, which happen when uploading/downloading with
+// XLA_USE_BF16, XLA_DOWNCAST_BF16, XLA_USE_F16 or XLA_USE_32BIT_LONG set, are
+// routed to the vectorized kernels.
+template <>
+void CopyData<tensorflow::bfloat16, float>(tensorflow::bfloat16* dest,
+                                           const float* source, int64_t n,
+                                           const CopyCasted&) {
+  simd::GetConvertKernels().f32_to_bf16(
+      source, reinterpret_cast<uint16_t*>(dest), n);
+}
+template <>
+void CopyData<float, tensorflow::bfloat16>(float* dest,
+                                           const tensorflow::bfloat16* source,
+                                           int64_t n, const CopyCasted&) {
+  simd::GetConvertKernels().bf16_to_f32(
+      reinterpret_cast<const uint16_t*>(source), dest, n);
+}
+template <>
+void CopyData<xla::half, float>(xla::half* dest, const float* source,
+                                int64_t n, const CopyCasted&) {
+  simd::GetConvertKernels().f32_to_f16(source,
+                                       reinterpret_cast<uint16_t*>(dest), n);
+}
+template <>
+void CopyData<float, xla::half>(float* dest, const xla::half* source,
+                                int64_t n, const CopyCasted&) {
+  simd::GetConvertKernels().f16_to_f32(
+      reinterpret_cast<const uint16_t*>(source), dest, n);
+}
+template <>
+void CopyData<int32_t, int64_t>(int32_t* dest, const int64_t* source,
+                                int64_t n, const CopyDirect&) {
+  simd::GetConvertKernels().s64_to_s32(source, dest, n);
+}
+template <>
+void CopyData<int64_t, int32_t>(int64_t* dest, const int32_t* source,
+                                int64_t n, const CopyDirect&) {
+  simd::GetConvertKernels().s32_to_s64(source, dest, n);
+}
+
 std::vector<int64_t> GetIterationDimensions(const xla::Shape& shape) {
   // We want to favor the most minor dimension as core iteration dimension, as
   // this walks one of the two tensors buffers in a cache friendly fashion.
@@ -416,7 +461,8 @@ std::vector<CopyPartition> CreateCopyPartitions(
   // Use at most 50% of the available cores.
   int64_t max_parts =
       std::max<int64_t>(std::thread::hardware_concurrency() / 2, 1);
-  // Find the maximum dimension which is not the strided copy dimension.
+  // Find the maximum dimension which is not the strided copy dimension. There
+  // must be one, so this is only valid for ranks >= 2.
   int64_t max_dim = -1;
   for (int64_t i = 0; i < dimensions.size(); ++i) {
     if (i != strided_copy_dimension &&
@@ -470,6 +516,211 @@ void SlicedCopy(absl::Span<const int64_t> dimensions, const SType* src_data,
   }
 }
 
+// The tiled copy can be disabled with XLA_TILED_TENSOR_COPY=0, to fall back to
+// the sliced one. The variable is read only once, and SetTiledTensorCopy() can
+// switch between the two within a process.
+std::atomic<bool>* TiledCopyEnabled() {
+  static std::atomic<bool>* enabled = new std::atomic<bool>(
+      xla::sys_util::GetEnvBool("XLA_TILED_TENSOR_COPY", true));
+  return enabled;
+}
+
+bool UseTiledCopy() {
+  return TiledCopyEnabled()->load(std::memory_order_relaxed);
+}
+
+// Returns the edge of the square tiles used by TiledCopy(), sized so that the
+// source and destination tiles take at most half of a 32KB L1 data cache.
+int64_t GetCopyTileSize(size_t element_pair_size) {
+  static const int64_t kMaxTileBytes = 16 * 1024;
+  int64_t tile_size = 64;
+  while (tile_size > 8 && tile_size * tile_size * element_pair_size >
+                              kMaxTileBytes) {
+    tile_size /= 2;
+  }
+  return tile_size;
+}
+
+// Returns the dimension with size greater than one and the smallest non zero
+// stride, or -1 if there is no dimension with size greater than one. Zero
+// strides (expanded dimensions) are only picked if there is nothing else.
+int64_t GetMinorCopyDimension(absl::Span<const int64_t> dimensions,
+                              absl::Span<const int64_t> strides) {
+  int64_t minor_dim = -1;
+  for (int64_t dim = 0; dim < dimensions.size(); ++dim) {
+    if (dimensions[dim] > 1 &&
+        (minor_dim < 0 || strides[minor_dim] == 0 ||
+         (strides[dim] != 0 && strides[dim] < strides[minor_dim]))) {
+      minor_dim = dim;
+    }
+  }
+  return minor_dim;
+}
+
+// Copies a rows x cols tile whose destination is contiguous along the rows.
+// The vectorized paths require the source to be contiguous along the columns.
+// The buffer must have room for rows x cols source elements.
+template <typename SType, typename DType>
+void TransposeTile(const SType* src, int64_t src_stride, int64_t src_col_stride,
+                   DType* dest, int64_t dest_stride, int64_t rows, int64_t cols,
+                   SType* buffer) {
+  if (sizeof(SType) == sizeof(uint32_t) && !NeedCast<SType>::value &&
+      src_col_stride == 1) {
+    const simd::ConvertKernels& kernels = simd::GetConvertKernels();
+    if (std::is_same<SType, DType>::value) {
+      kernels.transpose_32(reinterpret_cast<const uint32_t*>(src), src_stride,
+                           reinterpret_cast<uint32_t*>(dest), dest_stride,
+                           rows, cols);
+      return;
+    }
+    // Transpose into the cache resident buffer, and convert every destination
+    // row out of it.
+    kernels.transpose_32(reinterpret_cast<const uint32_t*>(src), src_stride,
+                         reinterpret_cast<uint32_t*>(buffer), rows, rows,
+                         cols);
+    for (int64_t j = 0; j < cols; ++j) {
+      CopyData<DType, SType>(dest + j * dest_stride, buffer + j * rows, rows,
+                             typename CopyType < NeedCast<SType>::value ||
+                                 NeedCast<DType>::value > ::type());
+    }
+    return;
+  }
+  for (int64_t i = 0; i < rows; ++i) {
+    StridedCopy(dest + i, dest_stride, src + i * src_stride, src_col_stride,
+                cols);
+  }
+}
+
+// Copies between tensors with different layouts, by splitting the plane formed
+// by the source and destination minor dimensions into L1 sized tiles, which
+// are then transposed (and converted) as a whole. Differently from
+// SlicedCopy(), neither of the two buffers is ever walked with a large stride
+// within a tile, and the copy is spread over all the cores by assigning
+// ranges of tiles to each thread. The source strides can be arbitrary.
+template <typename SType, typename DType>
+void TiledCopy(const SType* src_data, absl::Span<const int64_t> src_strides,
+               const xla::Shape& dest_shape, DType* dest_data) {
+  // The minimum number of elements copy that can be assigned to a thread.
+  static const int64_t kMinThreadElements = 100000;
+  std::vector<int64_t> dest_strides = ComputeShapeStrides(dest_shape);
+  int64_t col_dim =
+      GetMinorCopyDimension(dest_shape.dimensions(), src_strides);
+  int64_t row_dim =
+      GetMinorCopyDimension(dest_shape.dimensions(), dest_strides);
+  if (col_dim < 0) {
+    // Single element tensor.
+    StridedCopy(dest_data, 1, src_data, 1, 1);
+    return;
+  }
+  int64_t tile_size = GetCopyTileSize(sizeof(SType) + sizeof(DType));
+  int64_t num_rows = 1;
+  int64_t row_tile_size = 1;
+  int64_t col_tile_size = tile_size * tile_size;
+  if (row_dim != col_dim) {
+    num_rows = dest_shape.dimensions(row_dim);
+    row_tile_size = tile_size;
+    col_tile_size = tile_size;
+  }
+  int64_t num_cols = dest_shape.dimensions(col_dim);
+  int64_t row_tiles = xla::CeilOfRatio<int64_t>(num_rows, row_tile_size);
+  int64_t col_tiles = xla::CeilOfRatio<int64_t>(num_cols, col_tile_size);
+  std::vector<int64_t> outer_dims;
+  int64_t num_outer = 1;
+  for (int64_t dim : dest_shape.layout().minor_to_major()) {
+    if (dim != row_dim && dim != col_dim && dest_shape.dimensions(dim) > 1) {
+      outer_dims.push_back(dim);
+      num_outer *= dest_shape.dimensions(dim);
+    }
+  }
+  int64_t num_tiles = num_outer * row_tiles * col_tiles;
+  int64_t max_parts =
+      std::max<int64_t>(std::thread::hardware_concurrency(), 1);
+  int64_t part_tiles = std::max<int64_t>(
+      xla::CeilOfRatio<int64_t>(num_tiles, max_parts),
+      xla::CeilOfRatio<int64_t>(kMinThreadElements, tile_size * tile_size));
+  int64_t num_parts = xla::CeilOfRatio<int64_t>(num_tiles, part_tiles);
+
+  auto copy_fn = [&](int64_t part) {
+    std::unique_ptr<SType[]> buffer(new SType[tile_size * tile_size]);
+    int64_t end = std::min(num_tiles, (part + 1) * part_tiles);
+    for (int64_t tile = part * part_tiles; tile < end; ++tile) {
+      int64_t col_tile = tile % col_tiles;
+      int64_t row_tile = (tile / col_tiles) % row_tiles;
+      int64_t outer = tile / col_tiles / row_tiles;
+      int64_t src_offset = 0;
+      int64_t dest_offset = 0;
+      for (int64_t dim : outer_dims) {
+        int64_t index = outer % dest_shape.dimensions(dim);
+        outer /= dest_shape.dimensions(dim);
+        src_offset += index * src_strides[dim];
+        dest_offset += index * dest_strides[dim];
+      }
+      int64_t row = row_tile * row_tile_size;
+      int64_t col = col_tile * col_tile_size;
+      int64_t cols = std::min(col_tile_size, num_cols - col);
+      src_offset += col * src_strides[col_dim];
+      dest_offset += col * dest_strides[col_dim];
+      if (row_dim != col_dim) {
+        src_offset += row * src_strides[row_dim];
+        dest_offset += row * dest_strides[row_dim];
+        TransposeTile(src_data + src_offset, src_strides[row_dim],
+                      src_strides[col_dim], dest_data + dest_offset,
+                      dest_strides[col_dim],
+                      std::min(row_tile_size, num_rows - row), cols,
+                      buffer.get());
+      } else if (src_strides[col_dim] == 1) {
+        CopyData<DType, SType>(dest_data + dest_offset, src_data + src_offset,
+                               cols,
+                               typename CopyType < NeedCast<SType>::value ||
+                                   NeedCast<DType>::value > ::type());
+      } else {
+        StridedCopy(dest_data + dest_offset, 1, src_data + src_offset,
+                    src_strides[col_dim], cols);
+      }
+    }
+  };
+  if (num_parts == 1) {
+    copy_fn(0);
+    return;
+  }
+  auto mwait = std::make_shared<xla::util::MultiWait>(num_parts);
+  for (int64_t i = 0; i < num_parts; ++i) {
+    xla::env::ScheduleClosure(xla::util::MultiWait::Completer(
+        mwait, [&copy_fn, i]() { copy_fn(i); }));
+  }
+  mwait->Wait();
+}
+
+// Copies the source data, whose elements are laid out according to the given
+// strides, into the destination buffer of the given shape.
+template <typename SType, typename DType>
+void CopyStridedTensor(const SType* src_data,
+                       absl::Span<const int64_t> src_strides,
+                       const xla::Shape& dest_shape, DType* dest_data) {
+  // Rank 1 tensors have no dimension other than the copy one to partition on,
+  // and always take the tiled copy, which degenerates into a strided one.
+  if (UseTiledCopy() || dest_shape.rank() < 2) {
+    TiledCopy<SType, DType>(src_data, src_strides, dest_shape, dest_data);
+    return;
+  }
+  // We issue a multi-threaded copy by slicing the bigger dimension and
+  // assigning its copy to different threads.
+  std::vector<int64_t> dest_strides = ComputeShapeStrides(dest_shape);
+  std::vector<int64_t> iter_dims = GetIterationDimensions(dest_shape);
+  std::vector<CopyPartition> parts =
+      CreateCopyPartitions(dest_shape.dimensions(), iter_dims.front());
+  auto mwait = std::make_shared<xla::util::MultiWait>(parts.size());
+  for (size_t i = 0; i < parts.size(); ++i) {
+    auto copy_fn = [&, i]() {
+      SlicedCopy<SType, DType>(dest_shape.dimensions(), src_data, src_strides,
+                               dest_data, dest_strides, iter_dims, parts[i]);
+    };
+    xla::env::ScheduleClosure(
+        xla::util::MultiWait::Completer(mwait, std::move(copy_fn)));
+  }
+  mwait->Wait();
+}
+
 template <typename SType, typename DType>
 void CopyTensors(const void* src_buffer, const xla::Shape& src_shape,
                  void* dest_buffer, size_t dest_buffer_size,
@@ -488,24 +739,8 @@ void CopyTensors(const void* src_buffer, const xla::Shape& src_shape,
                            typename CopyType < NeedCast<SType>::value ||
                                NeedCast<DType>::value > ::type());
   } else if (total_elements > 0) {
-    // We issue a multi-threaded copy by slicing the bigger dimension and
-    // assigning its copy to different threads. This code is only valid for
-    // ranks >= 2, but the layout check above covers the case.
-    std::vector<int64_t> src_strides = ComputeShapeStrides(src_shape);
-    std::vector<int64_t> dest_strides = ComputeShapeStrides(dest_shape);
-    std::vector<int64_t> iter_dims = GetIterationDimensions(dest_shape);
-    std::vector<CopyPartition> parts =
-        CreateCopyPartitions(dest_shape.dimensions(), iter_dims.front());
-    auto mwait = std::make_shared<xla::util::MultiWait>(parts.size());
-    for (size_t i = 0; i < parts.size(); ++i) {
-      auto copy_fn = [&, i]() {
-        SlicedCopy<SType, DType>(dest_shape.dimensions(), src_data, src_strides,
-                                 dest_data, dest_strides, iter_dims, parts[i]);
-      };
-      xla::env::ScheduleClosure(
-          xla::util::MultiWait::Completer(mwait, std::move(copy_fn)));
-    }
-    mwait->Wait();
+    CopyStridedTensor<SType, DType>(
+        src_data, ComputeShapeStrides(src_shape), dest_shape, dest_data);
   }
 }
 
@@ -513,12 +748,25 @@ template <typename SType, typename DType>
 void TensorToBuffer(const at::Tensor& tensor, const xla::Shape& dest_shape,
                     void* dest_buffer, size_t dest_buffer_size,
                     const Device& device) {
-  at::Tensor contiguous_tensor = tensor.contiguous();
+  if (!tensor.is_contiguous()) {
+    // Sliced, permuted and expanded tensors are copied straight out of their
+    // strided storage, instead of materializing a contiguous copy first.
+    XLA_CHECK(XlaHelpers::I64List(tensor.sizes()) ==
+              torch::lazy::ToVector<int64_t>(dest_shape.dimensions()))
+        << tensor.sizes() << " vs. " << dest_shape;
+    XLA_CHECK_EQ(dest_buffer_size, tensor.numel() * sizeof(DType));
+    if (tensor.numel() > 0) {
+      CopyStridedTensor<SType, DType>(
+          tensor.data_ptr<SType>(), XlaHelpers::I64List(tensor.strides()),
+          dest_shape, reinterpret_cast<DType*>(dest_buffer));
+    }
+    return;
+  }
   xla::Shape src_shape = MakeTorchTensorLayout(
-      XlaHelpers::I64List(contiguous_tensor.sizes()), /*dynamic_dimensions=*/{},
-      XlaTypeFromTensorType(contiguous_tensor.type().scalarType(), device));
-  CopyTensors<SType, DType>(contiguous_tensor.data_ptr<SType>(), src_shape,
-                            dest_buffer, dest_buffer_size, dest_shape);
+      XlaHelpers::I64List(tensor.sizes()), /*dynamic_dimensions=*/{},
+      XlaTypeFromTensorType(tensor.type().scalarType(), device));
+  CopyTensors<SType, DType>(tensor.data_ptr<SType>(), src_shape, dest_buffer,
+                            dest_buffer_size, dest_shape);
 }
 
 template <typename SType>
@@ -704,6 +952,9 @@ at::Tensor XlaLiteralToTensor(const xla::Literal& literal,
   int64_t total_elements = xla::ShapeUtil::ElementsIn(torch_shape);
 
   const auto literal_data = literal.data<SType>();
+  // The returned tensor is handed to the user, and can live arbitrarily long,
+  // so it is not allocated from the (size class rounded, cached) staging
+  // buffers pool.
   at::Tensor tensor = at::empty(dimensions, at::TensorOptions(atype));
   CopyTensors<SType, DType>(literal_data.data(), literal.shape(),
                             tensor.data_ptr<DType>(),
@@ -749,6 +1000,10 @@ at::Tensor XlaLiteralToTensorHelper(const xla::Literal& literal,
 
 }  // namespace
 
+bool SetTiledTensorCopy(bool enabled) {
+  return TiledCopyEnabled()->exchange(enabled);
+}
+
 std::vector<int64_t> ComputeShapeStrides(const xla::Shape& shape) {
   std::vector<int64_t> strides(shape.rank());
   int64_t stride = 1;
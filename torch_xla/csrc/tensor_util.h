@@ -16,6 +16,11 @@ namespace torch_xla {
 
 std::vector<int64_t> ComputeShapeStrides(const xla::Shape& shape);
 
+// Selects the tiled (default, unless XLA_TILED_TENSOR_COPY=0) or the sliced
+// host copies between tensors with different layouts, and returns the previous
+// selection. Used by tests and benchmarks.
+bool SetTiledTensorCopy(bool enabled);
+
 // Converts an XLA literal to an at::Tensor of the given element type.
 at::Tensor MakeTensorFromXlaLiteral(const xla::Literal& literal,
                                     at::ScalarType dest_element_type);
@@ -1,5 +1,7 @@
 #include "torch_xla/csrc/token_handler.h"
 
+#include <utility>
+
 #include "tensorflow/compiler/xla/client/lib/constants.h"
 #include "tensorflow/compiler/xla/shape_util.h"
 #include "torch_xla/csrc/convert_ops.h"
@@ -28,10 +30,28 @@ xla::XlaOp SliceOneToken(xla::XlaOp input) {
   return input;
 }
 
+// Returns the elements of the {first, second} tuple, once both of them are
+// available. The optimization barrier prevents XLA from moving computations
+// across it, so users of the returned values are sequenced after both.
+std::pair<xla::XlaOp, xla::XlaOp> BarrierPair(xla::XlaOp first,
+                                              xla::XlaOp second) {
+  xla::XlaOp barrier =
+      xla::OptimizationBarrier(xla::Tuple(first.builder(), {first, second}));
+  return std::make_pair(xla::GetTupleElement(barrier, 0),
+                        xla::GetTupleElement(barrier, 1));
+}
+
 }  // namespace
 
+bool TokenHandler::IsRealToken(xla::XlaOp token) {
+  return XlaHelpers::ShapeOfXlaOp(token).IsToken();
+}
+
 xla::XlaOp TokenHandler::GetInput(xla::XlaOp input,
                                   const xla::Shape* input_shape) {
+  if (IsRealToken(token_)) {
+    return BarrierPair(input, token_).first;
+  }
   if (input_shape == nullptr) {
     input_shape = &XlaHelpers::ShapeOfXlaOp(input);
   }
@@ -40,6 +60,10 @@ xla::XlaOp TokenHandler::GetInput(xla::XlaOp input,
 }
 
 xla::XlaOp TokenHandler::GetNewToken(xla::XlaOp result) {
+  if (IsRealToken(token_)) {
+    token_ = BarrierPair(result, token_).second;
+    return token_;
+  }
   xla::XlaOp slice = SliceOneToken(result);
   // Token is always a numeric zero, and multiplying it for one element of the
   // result will still leave it as zero.
@@ -4,10 +4,16 @@
 
 namespace torch_xla {
 
+// Sequences collective operations by threading a token through them. The token
+// can either be a real XLA token (see IsRealToken()), in which case the
+// ordering is enforced with optimization barriers which carry no data, or a
+// numeric zero pseudo-token which is folded into the inputs and results.
 class TokenHandler {
  public:
   explicit TokenHandler(xla::XlaOp token) : token_(token) {}
 
+  static bool IsRealToken(xla::XlaOp token);
+
   xla::XlaOp GetInput(xla::XlaOp input, const xla::Shape* input_shape);
 
   xla::XlaOp GetNewToken(xla::XlaOp result);
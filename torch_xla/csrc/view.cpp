@@ -121,6 +121,92 @@ ir::Value ApplyUpdate(ir::Value ir_value,
   return result;
 }
 
+// Returns whether the view is a pure narrowing, that is, a kNarrow or a kSelect
+// with unit stride.
+bool IsNarrowView(const ViewInfo& view_info) {
+  return view_info.view_type == ViewInfo::Type::kNarrow ||
+         (view_info.view_type == ViewInfo::Type::kSelect &&
+          view_info.select->stride == 1);
+}
+
+ViewInfo ToNarrowView(ViewInfo view_info) {
+  if (view_info.view_type == ViewInfo::Type::kNarrow) {
+    return view_info;
+  }
+  ViewInfo narrow_info(ViewInfo::Type::kNarrow, view_info.shape,
+                       view_info.source_shape);
+  narrow_info.indices[view_info.select->dim] = view_info.select->start;
+  return narrow_info;
+}
+
+bool IsIdentityView(const ViewInfo& view_info) {
+  switch (view_info.view_type) {
+    case ViewInfo::Type::kNoOp:
+      return true;
+    case ViewInfo::Type::kNarrow:
+    case ViewInfo::Type::kReshape:
+      return view_info.shape == view_info.source_shape;
+    case ViewInfo::Type::kPermute:
+      return xla::IsIdentityPermutation(view_info.permutation);
+    default:
+      return false;
+  }
+}
+
+// Appends view_info to view_infos, folding it into the last view when the two
+// compose into a single one (narrow of narrow, permute of permute, reshape of
+// reshape), and dropping the views which are identities. This keeps the chains
+// replayed by GetViewIrNode() and ApplyUpdate() short, and makes equivalent
+// view paths compare equal in Alias::Update().
+void AppendViewInfo(std::vector<ViewInfo>* view_infos, ViewInfo view_info) {
+  if (IsNarrowView(view_info)) {
+    view_info = ToNarrowView(std::move(view_info));
+  }
+  if (!view_infos->empty()) {
+    ViewInfo& last = view_infos->back();
+    if (last.view_type == ViewInfo::Type::kNoOp) {
+      view_infos->pop_back();
+    } else if (last.view_type == view_info.view_type) {
+      switch (view_info.view_type) {
+        case ViewInfo::Type::kNarrow:
+          for (size_t i = 0; i < last.indices.size(); ++i) {
+            last.indices[i] += view_info.indices[i];
+          }
+          last.shape = std::move(view_info.shape);
+          view_info = std::move(last);
+          view_infos->pop_back();
+          break;
+        case ViewInfo::Type::kPermute:
+          // The composed view picks, for output dimension i, the input
+          // dimension last.permutation[view_info.permutation[i]].
+          for (auto& dim : view_info.permutation) {
+            dim = last.permutation[dim];
+          }
+          view_info.source_shape = std::move(last.source_shape);
+          view_infos->pop_back();
+          break;
+        case ViewInfo::Type::kReshape:
+          view_info.source_shape = std::move(last.source_shape);
+          view_info.indices.assign(view_info.source_shape.rank(), 0);
+          view_infos->pop_back();
+          break;
+        default:
+          break;
+      }
+    }
+  }
+  if (!IsIdentityView(view_info)) {
+    view_infos->push_back(std::move(view_info));
+  }
+}
+
+// Returns whether the update writes a region of the alias through a single
+// narrowing view, which lets consecutive such updates be batched.
+bool IsSliceUpdate(const Alias::UpdateData& update_data) {
+  return update_data.view_infos.size() == 1 &&
+         update_data.view_infos.front().view_type == ViewInfo::Type::kNarrow;
+}
+
 }  // namespace
 
 ViewInfo::ViewInfo(Type view_type, xla::Shape shape, xla::Shape source_shape)
@@ -177,8 +263,28 @@ void Alias::Update(ir::Value ir_value, std::vector<ViewInfo> view_infos) {
 }
 
 ir::Value Alias::SyncUpdateOperations() {
-  for (auto& update_data : updates_) {
-    ir_value_ = ApplyUpdate(ir_value_, update_data);
+  for (size_t i = 0; i < updates_.size();) {
+    size_t end = i + 1;
+    if (IsSliceUpdate(updates_[i])) {
+      while (end < updates_.size() && IsSliceUpdate(updates_[end])) {
+        ++end;
+      }
+    }
+    if (end - i > 1) {
+      // Runs of slice updates (like the ones issued by a loop writing the rows
+      // of a tensor) are applied in order, by a single IR node.
+      std::vector<ir::Value> sources;
+      std::vector<std::vector<int64_t>> base_indices;
+      for (; i < end; ++i) {
+        sources.push_back(updates_[i].ir_value);
+        base_indices.push_back(updates_[i].view_infos.front().indices);
+      }
+      ir_value_ =
+          ir::ops::UpdateSlices(ir_value_, sources, std::move(base_indices));
+    } else {
+      ir_value_ = ApplyUpdate(ir_value_, updates_[i]);
+      i = end;
+    }
   }
   updates_.clear();
   return ir_value_;
@@ -186,7 +292,7 @@ ir::Value Alias::SyncUpdateOperations() {
 
 View::View(xla::Shape shape, std::shared_ptr<Alias> alias, ViewInfo view_info)
     : shape_(std::move(shape)), alias_(std::move(alias)) {
-  view_infos_.push_back(std::move(view_info));
+  AppendViewInfo(&view_infos_, std::move(view_info));
 }
 
 View::View(xla::Shape shape, std::shared_ptr<Alias> alias,
@@ -202,7 +308,7 @@ void View::Update(ir::Value ir_value) {
 std::shared_ptr<View> View::CreateSubView(xla::Shape shape,
                                           ViewInfo view_info) {
   std::vector<ViewInfo> view_infos(view_infos_);
-  view_infos.push_back(std::move(view_info));
+  AppendViewInfo(&view_infos, std::move(view_info));
   return std::make_shared<View>(std::move(shape), alias_,
                                 std::move(view_infos));
 }
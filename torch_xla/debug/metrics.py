@@ -45,3 +45,19 @@ def metric_data(name):
 def metrics_report():
   """Retrieves a string containing the full metrics and counters report."""
   return torch_xla._XLAC._xla_metrics_report()
+
+
+def xrt_metrics_report(metrics_regex=None, delta=False):
+  """Retrieves a string containing the XRT metrics report.
+
+  Args:
+    metrics_regex (list of string, optional): The regular expressions selecting
+      the XRT metrics (like `/tensorflow/xrt/ops/execute`) to be collected. All
+      of them are collected if missing.
+      Default: None
+    delta (bool, optional): Whether only the metrics which changed since the
+      previous report with `delta=True` and the same `metrics_regex` should be
+      included. Useful to cheaply poll the metrics from monitoring code.
+      Default: False
+  """
+  return torch_xla._XLAC._xla_xrt_metrics_report(metrics_regex or [], delta)
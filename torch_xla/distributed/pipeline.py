@@ -0,0 +1,258 @@
+from __future__ import division
+from __future__ import print_function
+
+import collections
+import torch
+import torch.autograd
+import torch_xla
+import torch_xla.core.xla_model as xm
+
+FORWARD = 'F'
+BACKWARD = 'B'
+
+_FORWARD_CHAIN = 'pipeline_forward'
+_BACKWARD_CHAIN = 'pipeline_backward'
+
+Action = collections.namedtuple('Action', 'kind microbatch')
+
+
+def _gpipe_stage_actions(stage, num_stages, num_microbatches):
+  actions = [Action(FORWARD, m) for m in range(num_microbatches)]
+  actions += [Action(BACKWARD, m) for m in range(num_microbatches)]
+  return actions
+
+
+def _1f1b_stage_actions(stage, num_stages, num_microbatches):
+  num_warmup = min(num_stages - stage - 1, num_microbatches)
+  actions = [Action(FORWARD, m) for m in range(num_warmup)]
+  next_backward = 0
+  for m in range(num_warmup, num_microbatches):
+    actions.append(Action(FORWARD, m))
+    actions.append(Action(BACKWARD, next_backward))
+    next_backward += 1
+  actions += [
+      Action(BACKWARD, m) for m in range(next_backward, num_microbatches)
+  ]
+  return actions
+
+
+_SCHEDULES = {
+    'gpipe': _gpipe_stage_actions,
+    '1f1b': _1f1b_stage_actions,
+}
+
+
+def create_schedule(schedule, num_stages, num_microbatches):
+  """Creates the tick-synchronous execution table of a pipeline schedule.
+
+  All the stages run in lock-step ticks. At every tick each stage executes at
+  most one action, after which the activations produced by forward actions are
+  sent to the next stage, and the gradients produced by backward actions are
+  sent to the previous one.
+
+  Args:
+    schedule (string): The schedule name. Either ``gpipe`` or ``1f1b``.
+    num_stages (int): The number of pipeline stages.
+    num_microbatches (int): The number of microbatches the batch is split into.
+
+  Returns:
+    A list of ticks, each one being a list (indexed by stage) of `Action`
+    objects, or `None` if the stage is idle within the tick.
+  """
+  stage_actions_fn = _SCHEDULES.get(schedule, None)
+  if stage_actions_fn is None:
+    raise ValueError('Unknown pipeline schedule: {}'.format(schedule))
+  pending = [
+      collections.deque(stage_actions_fn(s, num_stages, num_microbatches))
+      for s in range(num_stages)
+  ]
+  done = set()
+  ticks = []
+  while any(pending):
+    tick = [None] * num_stages
+    for s in range(num_stages):
+      if not pending[s]:
+        continue
+      action = pending[s][0]
+      if action.kind == FORWARD:
+        ready = s == 0 or (FORWARD, s - 1, action.microbatch) in done
+      else:
+        ready = (FORWARD, s, action.microbatch) in done and (
+            s == num_stages - 1 or
+            (BACKWARD, s + 1, action.microbatch) in done)
+      if ready:
+        tick[s] = pending[s].popleft()
+    if all(action is None for action in tick):
+      raise RuntimeError('Pipeline schedule {} is stuck'.format(schedule))
+    for s, action in enumerate(tick):
+      if action is not None:
+        done.add((action.kind, s, action.microbatch))
+    ticks.append(tick)
+  return ticks
+
+
+class Pipeline(object):
+  """Runs a pipeline-parallel training step over microbatches.
+
+  Every replica runs one stage of the pipeline, with stage equal to the replica
+  ordinal modulo `num_stages`. Replicas whose ordinals differ by a multiple of
+  `num_stages` form a data-parallel set of pipelines.
+  The activations flowing across stage boundaries are exchanged with
+  `xm.collective_permute()` operations issued on token chains separate from the
+  one used by the other collectives (like the gradients all-reduce), so that XLA
+  is free to overlap the transfers with the compute of the other microbatches.
+  Since all the replicas must issue the same sequence of collectives, all the
+  stage boundaries must carry activations of the same shape and type.
+
+  Args:
+    stage_module (:class:`torch.nn.Module` or callable): The model code for the
+      stage run by this replica. Stages other than the first receive as input
+      the output of the previous stage.
+    num_stages (int): The number of pipeline stages.
+    activation_shape (list): The shape of the activations (for a single
+      microbatch) which flow across the stage boundaries.
+    loss_fn (callable): The function computing the loss out of the last stage
+      output and the microbatch target, as `loss_fn(output, target)`.
+    schedule (string, optional): The pipeline schedule. Either ``gpipe`` or
+      ``1f1b``.
+      Default: ``1f1b``
+    activation_dtype (:class:`torch.dtype`, optional): The type of the
+      activations which flow across the stage boundaries.
+      Default: `torch.float32`
+  """
+
+  def __init__(self,
+               stage_module,
+               num_stages,
+               activation_shape,
+               loss_fn,
+               schedule='1f1b',
+               activation_dtype=torch.float32):
+    self._stage_module = stage_module
+    self._num_stages = num_stages
+    self._activation_shape = list(activation_shape)
+    self._activation_dtype = activation_dtype
+    self._loss_fn = loss_fn
+    self._schedule = schedule
+    self._tables = dict()
+    ordinal = xm.get_ordinal()
+    self._stage = ordinal % num_stages
+    world_size = xm.xrt_world_size()
+    if world_size % num_stages != 0:
+      raise ValueError(
+          'World size {} is not a multiple of the number of stages {}'.format(
+              world_size, num_stages))
+    self._forward_pairs = []
+    self._backward_pairs = []
+    for base in range(0, world_size, num_stages):
+      for s in range(0, num_stages - 1):
+        self._forward_pairs.append([base + s, base + s + 1])
+        self._backward_pairs.append([base + s + 1, base + s])
+
+  @property
+  def stage(self):
+    return self._stage
+
+  @property
+  def is_first_stage(self):
+    return self._stage == 0
+
+  @property
+  def is_last_stage(self):
+    return self._stage == self._num_stages - 1
+
+  def _get_table(self, num_microbatches):
+    table = self._tables.get(num_microbatches, None)
+    if table is None:
+      table = create_schedule(self._schedule, self._num_stages,
+                              num_microbatches)
+      self._tables[num_microbatches] = table
+    return table
+
+  def _zeros(self, device):
+    return torch.zeros(
+        self._activation_shape, dtype=self._activation_dtype, device=device)
+
+  def step(self, microbatches, targets=None):
+    """Runs the forward and backward passes of a pipeline training step.
+
+    The gradients of the stage parameters are accumulated over the microbatches,
+    with the loss of each microbatch scaled by the number of microbatches.
+
+    Args:
+      microbatches (list): The inputs of the microbatches. Only used by the
+        first stage, but must have the same length on all the stages.
+      targets (list, optional): The targets of the microbatches, passed to
+        `loss_fn`. Only used by the last stage.
+
+    Returns:
+      The sum of the (scaled) microbatch losses on the last stage, `None` on the
+      other stages.
+    """
+    num_microbatches = len(microbatches)
+    device = xm.xla_device()
+    table = self._get_table(num_microbatches)
+    s = self._stage
+    inputs = dict()
+    outputs = dict()
+    received_activations = dict()
+    received_grads = dict()
+    total_loss = None
+    for tick in table:
+      action = tick[s]
+      send_activation = None
+      send_grad = None
+      if action is not None and action.kind == FORWARD:
+        m = action.microbatch
+        if self.is_first_stage:
+          stage_input = microbatches[m]
+        else:
+          stage_input = received_activations.pop(m).detach().requires_grad_()
+        output = self._stage_module(stage_input)
+        inputs[m] = stage_input
+        if self.is_last_stage:
+          output = self._loss_fn(output, targets[m]) / num_microbatches
+          total_loss = output.detach() if total_loss is None else (
+              total_loss + output.detach())
+        else:
+          send_activation = output.detach()
+        outputs[m] = output
+      elif action is not None and action.kind == BACKWARD:
+        m = action.microbatch
+        output = outputs.pop(m)
+        if self.is_last_stage:
+          torch.autograd.backward(output)
+        else:
+          torch.autograd.backward(output, received_grads.pop(m))
+        stage_input = inputs.pop(m)
+        if not self.is_first_stage:
+          send_grad = stage_input.grad
+
+      if self._num_stages > 1:
+        self._exchange(tick, device, send_activation, send_grad,
+                       received_activations, received_grads)
+    return total_loss
+
+  def _exchange(self, tick, device, send_activation, send_grad,
+                received_activations, received_grads):
+    # The replicas must agree on the collectives to be issued, so the decision
+    # is taken looking at the actions of all the stages within the tick.
+    s = self._stage
+    if any(a is not None and a.kind == FORWARD and i < self._num_stages - 1
+           for i, a in enumerate(tick)):
+      if send_activation is None:
+        send_activation = self._zeros(device)
+      activation = xm.collective_permute(
+          send_activation, self._forward_pairs, token_chain=_FORWARD_CHAIN)
+      prev_action = tick[s - 1] if s > 0 else None
+      if prev_action is not None and prev_action.kind == FORWARD:
+        received_activations[prev_action.microbatch] = activation
+    if any(a is not None and a.kind == BACKWARD and i > 0
+           for i, a in enumerate(tick)):
+      if send_grad is None:
+        send_grad = self._zeros(device)
+      grad = xm.collective_permute(
+          send_grad, self._backward_pairs, token_chain=_BACKWARD_CHAIN)
+      next_action = tick[s + 1] if s < self._num_stages - 1 else None
+      if next_action is not None and next_action.kind == BACKWARD:
+        received_grads[next_action.microbatch] = grad
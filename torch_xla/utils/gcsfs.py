@@ -235,6 +235,28 @@ def read(path):
   return _slurp_file(path)
 
 
+def read_into(path, tensor, offset=0):
+  """Reads the content of a file straight into the storage of a CPU tensor.
+
+  The file range is read with concurrent requests, and no intermediate copy is
+  made, so the tensor can be handed to the device transfer APIs right away.
+
+  Args:
+    path (string): The path of the file. Can be a local path, or a GCS path in
+      the "gs://BUCKET_NAME/PATH" form.
+    tensor (torch.Tensor): The contiguous CPU tensor to be filled. The number
+      of bytes read is the tensor size in bytes.
+    offset (int, optional): The offset within the file where the read starts.
+      Default: 0
+
+  Returns:
+    The input tensor.
+  """
+  gcs_file = torch_xla._XLAC._xla_tffile_open(path)
+  torch_xla._XLAC._xla_tffile_read_into(gcs_file, offset, tensor)
+  return tensor
+
+
 def write(path, content):
   """Write a string/bytes or file into a GCS blob.
 
@@ -101,3 +101,95 @@ def load(path):
     return type(v) == TensorReference
 
   return xm.ToXlaTensorArena(convert_fn, select_fn).transform(ref_data)
+
+
+def _get_tensors_stream(path):
+  return path + '.tensors.bin'
+
+
+def save_streaming(data,
+                   path,
+                   master_only=True,
+                   global_master=False,
+                   group_bytes=256 * 1024 * 1024):
+  """Saves the input data into a file, streaming the tensors data.
+
+  Like `save()`, but the XLA tensors are written into a single file next to
+  `path`, with the device fetch, the conversion to CPU tensors and the file
+  write of groups of tensors running concurrently. The host memory used is
+  bounded by a few groups of `group_bytes`, instead of by the total size of
+  the saved tensors. The tensors file can be on any file system supported by
+  the `torch_xla.utils.gcsfs` module.
+
+  Args:
+    data: The input data to be saved. Any nested combination of Python objects
+      (list, tuples, sets, dicts, ...).
+    path: The destination file for the data saving operation.
+    master_only (bool, optional): Whether only the master device should save the
+      data. See `save()`.
+      Default: True
+    global_master (bool, optional): When ``master_only`` is ``True`` this flag
+      controls whether every host's master (if ``global_master`` is ``False``)
+      saves the content, or only the global master (ordinal 0).
+      Default: False
+    group_bytes (int, optional): The maximum size of the groups of tensors
+      which are fetched from the devices at once.
+      Default: 256MB
+  """
+  should_write_data = not master_only or xm.is_master_ordinal(
+      local=not global_master)
+
+  def convert_fn(tensors):
+    torch_xla._XLAC._xla_sync_multi(
+        tensors, devices=[], wait=True, sync_xla_data=True)
+    if should_write_data:
+      torch_xla._XLAC._xla_save_tensors_stream(
+          tensors, _get_tensors_stream(path), group_bytes=group_bytes)
+    return [TensorReference(i) for i in range(len(tensors))]
+
+  def select_fn(v):
+    return type(v) == torch.Tensor and xm.is_xla_tensor(v)
+
+  ref_data = xm.ToXlaTensorArena(convert_fn, select_fn).transform(data)
+  if should_write_data:
+    torch.save(ref_data, path)
+  xm.rendezvous('torch_xla.utils.serialization.save_streaming')
+
+
+def load_streaming(path,
+                   device=None,
+                   group_bytes=256 * 1024 * 1024,
+                   mmap=False):
+  """Loads data previously saved with the `save_streaming()` API.
+
+  Args:
+    path (str): The path passed to the `save_streaming()` API.
+    device (torch.device, optional): If specified, the tensors are uploaded to
+      this device, one group of at most `group_bytes` at a time, while the next
+      group is being read. Otherwise CPU tensors are returned.
+      Default: None
+    group_bytes (int, optional): The maximum size of the groups of tensors
+      which are uploaded to the device at once.
+      Default: 256MB
+    mmap (bool, optional): Whether the tensors file should be memory mapped
+      instead of read. Only supported for local files. The returned CPU tensors
+      point straight into the (copy-on-write) mapping, which shares its pages
+      with all the processes loading the same file through the page cache.
+      Default: False
+  Returns:
+    The loaded data.
+  """
+  ref_data = torch.load(path)
+
+  def convert_fn(tensors):
+    loaded_tensors = torch_xla._XLAC._xla_load_tensors_stream(
+        _get_tensors_stream(path),
+        device=str(device) if device is not None else '',
+        group_bytes=group_bytes,
+        use_mmap=mmap)
+    return [loaded_tensors[t.tid] for t in tensors]
+
+  def select_fn(v):
+    return type(v) == TensorReference
+
+  return xm.ToXlaTensorArena(convert_fn, select_fn).transform(ref_data)
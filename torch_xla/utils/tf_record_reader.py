@@ -1,6 +1,7 @@
 from __future__ import division
 from __future__ import print_function
 
+import torch
 import torch_xla
 
 
@@ -62,3 +63,114 @@ class TfRecordReader(object):
         else:
           raise RuntimeError('Invalid transform: {}'.format(trs))
     return ex
+
+
+_FEATURE_TYPES = {
+    torch.float32: 'float32',
+    torch.int64: 'int64',
+    torch.int32: 'int32',
+    torch.uint8: 'uint8',
+    torch.int8: 'int8',
+}
+
+
+class FeatureSpec(object):
+  """Describes how a TfExample feature is collated into a batch tensor.
+
+  Args:
+    dtype (:class:`torch.dtype`): The type of the batch tensor. Float lists can
+      be read as ``torch.float32``, int64 lists as ``torch.int64`` or
+      ``torch.int32``, and single value bytes lists as ``torch.uint8`` or
+      ``torch.int8``.
+    shape (list): The shape of the feature for a single example.
+    padding_value (number, optional): If not `None`, examples with fewer (or
+      missing) values are allowed, and their remaining elements are filled with
+      this value.
+      Default: None
+  """
+
+  def __init__(self, dtype, shape, padding_value=None):
+    if dtype not in _FEATURE_TYPES:
+      raise ValueError('Unsupported feature type: {}'.format(dtype))
+    self.dtype = dtype
+    self.shape = list(shape)
+    self.padding_value = padding_value
+
+
+class TfExamplePipeline(object):
+  """Reads batches of TfExamples with a native, multi-threaded pipeline.
+
+  The files are sharded among `num_readers` threads, which parse the examples
+  straight into preallocated batch tensors without holding the Python GIL. If
+  a device is given, the batches are uploaded to it in the background, up to
+  `prefetch` batches ahead of the consumer.
+  The order of the examples within the batches is not deterministic.
+
+  Args:
+    files (list): The paths of the files containing the TfRecords.
+    features (dict): A dictionary with the TfExample feature names as keys, and
+      `FeatureSpec` objects as values. Features not listed are ignored.
+    batch_size (int): The number of examples in each batch.
+    device (:class:`torch.device`, optional): The device the batches should be
+      uploaded to. If `None`, CPU tensors are returned.
+      Default: None
+    compression (string, optional): The compression type. The empty string for
+      no compression, otherwise ``ZLIB`` or ``GZIP``.
+      Default: No compression.
+    buffer_size (int, optional): The size of the buffer to be used to read
+      TfRecords.
+      Default: 16 * 1024 * 1024
+    num_readers (int, optional): The number of reader threads.
+      Default: 4
+    prefetch (int, optional): The maximum number of batches queued.
+      Default: 2
+    drop_last (bool, optional): Whether the final batch should be dropped if
+      smaller than `batch_size`.
+      Default: False
+  """
+
+  def __init__(self,
+               files,
+               features,
+               batch_size,
+               device=None,
+               compression='',
+               buffer_size=16 * 1024 * 1024,
+               num_readers=4,
+               prefetch=2,
+               drop_last=False):
+    self._names = list(features.keys())
+    specs = []
+    for name in self._names:
+      spec = features[name]
+      specs.append((name, _FEATURE_TYPES[spec.dtype], spec.shape,
+                    spec.padding_value is not None, spec.padding_value or 0))
+    self._pipeline = torch_xla._XLAC._xla_create_tfexample_pipeline(
+        list(files),
+        specs,
+        batch_size,
+        compression=compression,
+        buffer_size=buffer_size,
+        num_readers=num_readers,
+        prefetch=prefetch,
+        drop_last=drop_last,
+        device=str(device) if device is not None else '')
+
+  def next_batch(self):
+    """Returns the next batch.
+
+    Returns:
+      In case of EOD returns ``None``, otherwise a dictionary whose keys are
+      the feature names, and values the batch tensors.
+    """
+    tensors = torch_xla._XLAC._xla_tfexample_pipeline_next(self._pipeline)
+    if tensors is None:
+      return None
+    return dict(zip(self._names, tensors))
+
+  def __iter__(self):
+    while True:
+      batch = self.next_batch()
+      if batch is None:
+        break
+      yield batch